@@ -74,6 +74,7 @@ uniform int mirSilence; // 0 or 1
 
 // this comes from the vertex shader
 in vec2 texCoordVarying;
+flat in vec4 shapeBoundingBoxVarying; // use this rather than shapeBoundingBox
 in vec4 gl_FragCoord;
 
 // this is the output of the fragment shader
@@ -113,7 +114,7 @@ void main(){
 //	float offset = 0.1 + timeValX / 120.0 + mirZeroCrossings/100.0 + mirOnSetCalls/20.0;
 
 	vec2 positionFloat = (gl_FragCoord.xy/fboCanvas.xy); // from 0 to 1, relative to fbo
-	vec2 cornerDistance = ((texCoordVarying)/shapeBoundingBox.ba); // goes from -1 to 1, relative to shape
+	vec2 cornerDistance = ((texCoordVarying)/shapeBoundingBoxVarying.ba); // goes from -1 to 1, relative to shape
 	
 
 	//outputColor *= 0.1*mod( dot(gl_FragCoord.xy*2*( offset/2 ),gl_FragCoord.xy*offset),16.1+offset/3*2);
@@ -28,8 +28,13 @@ in vec4 color;
 in vec4 normal;
 uniform vec4 shapeBoundingBox;
 
+// per-vertex shape data when karmaMapper batches shapes, (0,0,0,1) otherwise
+in vec2 kmShapeCenter;
+in vec4 kmShapeBoundingBox;
+
 // texture coordinates are sent to fragment shader
 out vec2 texCoordVarying;
+flat out vec4 shapeBoundingBoxVarying;
 //out vec4 texColor;
 
 void main(){
@@ -42,6 +47,7 @@ void main(){
 	// gl_Position
 
 	//texColor = globalColor;
-    texCoordVarying = position.xy;//shapeBox.xy;//gl_Position.xy;//(modelViewProjectionMatrix * position).xy;
+    texCoordVarying = position.xy - kmShapeCenter;//shapeBox.xy;//gl_Position.xy;//(modelViewProjectionMatrix * position).xy;
+	shapeBoundingBoxVarying = (kmShapeBoundingBox.z > 0.0) ? kmShapeBoundingBox : shapeBoundingBox;
 	gl_Position = modelViewProjectionMatrix * position;
 }
\ No newline at end of file
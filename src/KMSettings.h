@@ -39,6 +39,10 @@
 	//#define KM_LOG_INSTANCIATIONS true
 #endif
 
+// per-frame CPU profiler (see karmaProfiler.h)
+// comment line to compile the timers out
+#define KM_ENABLE_PROFILER true
+
 #ifdef TARGET_OSX
 	#define KM_CTRL_KEY_NAME "CMD"
 	#define KM_CTRL_KEY_CODE OF_KEY_COMMAND
@@ -53,9 +57,17 @@
 #define KM_SCENE_SAVE_FILE "saveFiles/karmaMapperSceneSettings.xml"
 #define KM_SCENE_SAVE_PATH "saveFiles/scenes/"
 #define KM_DEFAULT_SCENE "defaultScene.xml"
+#define KM_BINARY_SCENE_EXTENSION "kmscene" // memory mapped, see shapesBinaryScene.h
+#define KM_CONGRUENT_SHAPE_TOLERANCE 0.01f // px, shapes this close share their geometry (see shapeGeometry.h)
+#define KM_SHAPE_LOD_MIN_VERTICES 24 // shapes with less vertices only have their full outline
+#define KM_SHAPE_LOD_MAX_LEVELS 4 // simplified outlines per shape
+#define KM_SHAPE_LOD_TOLERANCE 0.5f // px, simplification error of the first level, doubles each level
+#define KM_SHAPE_LOD_DEFAULT_ERROR 0.5f // px, global simplification error shapes may be drawn with
 // Effect configurations
 #define KM_LAST_CONFIG_FILE "saveFiles/lastUsedConfiguration.xml"
 #define KM_CONFIG_FOLDER "saveFiles/configurations/"
 #define KM_CONFIG_DEFAULT "defaultConfig.xml"
+#define KM_CONFIG_LOADER_FRAME_BUDGET 4 // ms per frame spent creating effects while loading in the background
+#define KM_STANDBY_MEMORY_BUDGET 512 // MB, estimated, a preloaded configuration may hold (see animationController::preloadConfiguration())
 
 
@@ -10,6 +10,7 @@
 
 #include "ofxVLCRemote.h"
 #include "durationRC.h"
+#include <unordered_set>
 
 // forward declarations are needed for event listening
 ofEvent<karmaControllerDrawEventArgs> animationController::karmaControllerBeforeDraw;//(animationParams& _p);
@@ -18,7 +19,7 @@ ofEvent<karmaControllerDrawEventArgs> animationController::karmaControllerAfterD
 // - - - - - - - -
 // CONSTRUCTORS
 // - - - - - - - -
-animationController::animationController( shapesDB& _scene ): scene(_scene){
+animationController::animationController( shapesDB& _scene ): scene(_scene), configLoader(*this), standbyLoader(*this) {
 	
 	ofSetLoggerChannel( karmaConsoleChannel::getLogger() );
 	
@@ -31,8 +32,18 @@ animationController::animationController( shapesDB& _scene ): scene(_scene){
 	bGuiShowPlugins = false;
 	loadedConfiguration = "";
 	bGuiShowConsole = false;
+	bGuiShowProfiler = false;
+	bGuiShowGovernor = false;
+	bGuiShowRenderTargets = false;
+	frameStartMicros = 0;
+	bParallelEffectUpdates = true;
+	bPipelinedUpdates = false;
+	bCacheStaticLayers = true;
+	numCachedLayers = 0;
+	bSimulationPending = false;
 	bGuiShowModules = false;
 	bGuiShowMainWindow = true;
+	bSwitchStandbyOnBeat = false;
 	
 	ofAddListener( ofEvents().draw , this, &animationController::draw, OF_EVENT_ORDER_APP );
 	ofAddListener( ofEvents().update , this, &animationController::update, OF_EVENT_ORDER_APP );
@@ -42,8 +53,10 @@ animationController::animationController( shapesDB& _scene ): scene(_scene){
 	newConfiguration();
 	
 	// build GUI
+#ifndef KM_BENCHMARK_APP
 	gui.setup();
 	ImGui::GetIO().MouseDrawCursor = false;
+#endif
 }
 
 animationController::~animationController(){
@@ -300,6 +313,37 @@ bool animationController::removeEffect(basicEffect *_e){
 	return true;
 }
 
+// appends an effect to an existing layer. The controller takes ownership.
+bool animationController::addEffect(basicEffect *_e, karmaFboLayer &_layer){
+	if( _e == nullptr ) return false;
+	
+	for(auto layer=layers.begin(); layer!=layers.end(); ++layer){
+		if( &layer->first == &_layer ){
+			// prevent duplicates
+			if( std::find(layer->second.begin(), layer->second.end(), _e) == layer->second.end() ){
+				layer->second.push_back( _e );
+			}
+			return true;
+		}
+	}
+	
+	ofLogError("animationController::addEffect") << "Layer " << _layer.getName() << " is not part of this controller, not adding effect " << _e->getName();
+	return false;
+}
+
+karmaFboLayer& animationController::addLayer(const string& _name){
+	layers.emplace_back(
+		karmaFboLayer(ofGetWidth(),ofGetHeight()),
+		list<basicEffect*>()
+	);
+	
+	// setup karmaFboLayer
+	layers.back().second.clear();
+	layers.back().first.set(_name, layers.size()-1);
+	
+	return layers.back().first;
+}
+
 bool animationController::removeLayer(  karmaFboLayer& _layer  ){
 	//if( _layer == nullptr) return false;
 	
@@ -329,306 +373,33 @@ bool animationController::removeLayer(  karmaFboLayer& _layer  ){
 // - - - - - - - -
 // LOAD & SAVE
 // - - - - - - - -
-bool animationController::loadConfiguration(const string& _file){
-	
-	if( _file.empty() ){
-		ofLogError("animationController::loadConfiguration") << "Not loading, no file name specified";
-		return false;
-	}
-	
-	bool success = false;
-	ofxXmlSettings configXML;
-	
-	if( configXML.loadFile( _file ) ){
-		
-		stop();
-		
-		// load shapes scene
-		if( configXML.pushTag("sceneSettings") ){
-			if( scene.loadScene( configXML.getValue("shapesFile", "")) ){
-				loadedConfiguration = _file;
-				start();
-				success = true;
-			}
-			else {
-				newConfiguration();
-				start(); // start anyways
-				// todo: make this a GUI warning modal ?
-				ofLogWarning("animationController::loadConfiguration") << "The config file is loading but it's associated shapes scene file was not found. ( continuing... )";
-			}
-			configXML.popTag(); // pop sceneSettings
-		}
-		else {
-			newConfiguration();
-			start();
-			ofLogNotice("animationController::loadConfiguration") << "The config file has no shapes scene file. Loading effects without shapes.";
-		}
-		
-		if( configXML.pushTag("guiSettings") ){
-			bShowGui = configXML.getValue("bShowGui", bShowGui );
-			bGuiShowMainWindow = configXML.getValue("bGuiShowMainWindow", bGuiShowMainWindow );
-			bGuiShowAnimParams = configXML.getValue("bGuiShowAnimParams", bGuiShowAnimParams );
-			bGuiShowPlugins = configXML.getValue("bGuiShowPlugins", bGuiShowPlugins );
-			bGuiShowModules = configXML.getValue("bGuiShowModules", bGuiShowModules );
-			bGuiShowConsole = configXML.getValue("bGuiShowConsole", bGuiShowConsole );
-			configXML.popTag();
-		}
-		
-		// fix (import (old)savefiles which don't have layers
-		bool bypass = false;
-		if (configXML.tagExists("effects")){
-			//configXML.doc.
-			//configXML.addTag("layers");
-			// push directly into effect
-			//if(configXML.pushTag("effects")){
-			ofLogWarning("animationController::loadConfiguration") << "LOADING OLD SAVE FILE WITHOUT LAYERS... (should automatically convert by re-saving it once loaded)";
-			bypass=true;
-			//}
-		}
-		
-		// load effects
-		if(	bypass || configXML.pushTag("layers") ){
-			layers.clear(); // should be done in resetLayers()
-			int numLayers = configXML.getNumTags("layer");
-			
-			if(bypass || numLayers==0){
-				numLayers = 1;
-			}
-			
-			// load layers from save file
-			for(int l=0; l<numLayers; ++l){
-				
-				if( bypass || configXML.pushTag("layer",l) ){
-					
-					layers.emplace_back(
-						karmaFboLayer(ofGetWidth(),ofGetHeight()),
-						list<basicEffect*>()
-					);
-					
-					karmaFboLayer& curFbo = layers.back().first;
-					list<basicEffect*>& curLayerEffects = layers.back().second;
-					
-					// setup karmaFboLayer
-					curLayerEffects.clear();
-					if(bypass){
-						ofLogVerbose("animationController::loadConfiguration") << "Created initial layer";
-						curFbo.set("Initial Layer", 0);
-					}
-					else {
-						curFbo.set( configXML.getValue("layerName", "Layer "+ofToString(l)), l);
-					}
-					
-					// setup it's effects
-					vector<int> failedEffects;
-					failedEffects.clear();
-					vector<int> effectIndexes;
-					effectIndexes.clear();
-					int numEffects = 0;
-					
-					// push into effects
-					if( configXML.pushTag("effects") ){
-						
-						// loop for each effect
-						numEffects = configXML.getNumTags("effect");
-						for(int e=0; e<numEffects; e++){
-							if( configXML.pushTag("effect", e) ){
-								
-								// Some code comes from:
-								// --> http://stackoverflow.com/questions/8269465/how-can-i-instantiate-an-object-knowing-only-its-name
-								string effectType = configXML.getValue("effectType", "basicEffect");
-								basicEffect* effect = effect::create(effectType);
-								if( effect != nullptr ){
-									curLayerEffects.push_back( effect );
-									effect->initialise(animationParams.params);
-									effect->loadFromXML( configXML );
-									
-									// check index
-									int tmpIndex = effect->getIndex();
-									if(std::find(effectIndexes.begin(), effectIndexes.end(), tmpIndex) == effectIndexes.end() ){
-										// index is OK to have
-										
-									}
-									else {
-										while( std::find(effectIndexes.begin(), effectIndexes.end(), tmpIndex) != effectIndexes.end() ){
-											tmpIndex++;
-										}
-										effect->setIndex(tmpIndex);
-									}
-									effectIndexes.push_back(tmpIndex);
-									
-									if( configXML.pushTag("boundShapes") ){
-										
-										// bind with previous shapes
-										int numShapes = configXML.getNumTags("shape");
-										vector<string> failedShapes;
-										failedShapes.clear();
-										
-										for(int s=0; s<numShapes; s++){
-											
-											if( configXML.tagExists("shape", s) ){
-												
-												// get shape instance
-												string tmpName = configXML.getAttribute("shape", "name", "", s);
-												basicShape* tmpShape = scene.getShapeByName( tmpName );
-												
-												if(tmpShape != nullptr){
-													if( !curLayerEffects.back()->bindWithShape(tmpShape) ){
-														tmpName += "(failed binding with ";
-														tmpName += configXML.getAttribute("shape", "type", "undefined type", s);
-														tmpName += ")";
-														failedShapes.push_back( (tmpName) );
-													}
-												}
-												else {
-													tmpName += "(";
-													tmpName += configXML.getAttribute("shape", "type", "undefined type", s);
-													tmpName += " = not found)";
-													failedShapes.push_back( (tmpName) );
-												}
-												
-												//configXML.popTag();
-											}
-											
-											// todo: (important) adapt this structure in the basicShape save process
-										}
-										
-										// todo: make this GUI message and show details
-										if(failedShapes.size() > 0) ofLogWarning("animationController::loadConfiguration") << " Effect '" << effectType << "' loaded but failed to bind with " << failedShapes.size() << " out of " << numShapes << " shapes... (ignoring, but re-saving the configuration will erase this information).";
-										
-										configXML.popTag(); // pop bound shapes
-									}
-									
-									
-								}
-								else {
-									failedEffects.push_back(e);
-									// unknow effect type
-									ofLogError("effect::create") << "Effect type not found: " << effectType;
-								}
-								
-								configXML.popTag(); // pop effect
-							}
-							else {
-								
-								ofLogWarning("animationController::loadConfiguration") << "Weird situation... Can't push into effect #" << e;
-							}
-						} // end for(effects)
-						ofLogVerbose("animationController::loadConfiguration") << "Successfully loaded " <<  curLayerEffects.size() << "effects on layer " << l;
-						
-						configXML.popTag(); // pop effects
-					}
-					else {
-						if(bypass){
-							ofLogError("animationController::loadConfiguration") << "Couldn't import OLD CONFIG FILE, sorry...";
-						}
-						else {
-							ofLogNotice("animationController::loadConfiguration") << "No effects in layer #"<< l << ", skipping effects on this layer!";
-						}
-					}
-					
-					if (failedEffects.size()>0) {
-						success = false;
-						ofLogError("animationController::loadConfiguration") << "Failed loading " << failedEffects.size()<< " effects on layer #" << l;
-					}
-					
-					ofLogVerbose("animationController::loadConfiguration") << "Loaded layer #"<< l << "/"<< numLayers <<" ("<< curFbo.getName() << ") from file [" << _file << "] with [" << numEffects << " effects] ( " << failedEffects.size() << "failed )";
-					
-					
-					ofLogVerbose("animationController::loadConfiguration") << "Created layer "<< l <<" ("<< curFbo.getName() << ")";
 
-//					else {
-//						ofLogError("animationController::loadConfiguration") << "Layer " << l << " couldn't be loaded! Continueing with other layers...";
-//					}
-					
-					// pop layer
-					if(!bypass) configXML.popTag();
-				}
-				else {
-					ofLogWarning("animationController::loadConfiguration") << "Can't load layer #" << l;
-				}
-				
-			} // end for(layer)
-			
-			// pop "layers"
-			if(!bypass) configXML.popTag();
-		}
-		else {
-			ofLogError("animationController::loadConfiguration") << "Weird situation... Can't push into layers section.";
-		}
-			
-		// load modules
-		if(	configXML.pushTag("modules") ){
-				
-			// loop for each effect
-			int numModules = configXML.getNumTags("module");
-			vector<int> failedModules;
-			failedModules.clear();
-			
-			for(int m=0; m<numModules; m++){
-				if( configXML.pushTag("module", m) ){
-					
-					// Some code comes from:
-					// --> http://stackoverflow.com/questions/8269465/how-can-i-instantiate-an-object-knowing-only-its-name
-					string moduleType = configXML.getValue("moduleType", "karmaModule");
-					
-					//
-					karmaModule* newModule = tryLoadModule(moduleType);
-					if ( newModule != nullptr) {
-						// (do nothing )
-						if(! newModule->loadFromXML( configXML ) ){
-							ofLogError("animationController::loadConfiguration");
-							failedModules.push_back(m);
-						}
-						else {
-							newModule->enable();
-						}
-					}
-					else {
-						failedModules.push_back(m);
-						// unknow effect type
-						ofLogError("module::create") << "Module type not found, or error while instantiating it: " << moduleType;
-					}
-					
-					configXML.popTag(); // pop module
-				}
-			ofLogNotice("animationController::loadConfiguration") << "Loaded modules from " << _file << " [" << numModules << " modules] ( " << failedModules.size() << "failed )";
-			}
-			
-			if (failedModules.size()>0) {
-				success = false;
-			}
-			configXML.popTag(); // pop modules
-		}
-		else {
-			ofLogNotice("animationController::loadConfiguration") << "No modules in file, skipping modules!";
-		}
-		
-		if( !success ){
-			ofLogError("animationController::loadConfiguration") << "There were errors loading the configuration file...";
-		}
-		else {
-			ofLogNotice("animationController::loadConfiguration") << "The config file was loaded !";
-		}
-	}
-	else {
-		// todo: make this a GUI message
-		ofLogError("animationController::loadConfiguration") << "404 - The config file `"<< _file << "` does not exist or is not readable.";
-		success = false;
-	}
-	
-	if(success){
-		loadedConfiguration = _file;
-		configXML.clear();
-		configXML.setValue("lastLoadedConfiguration", _file );
-		if(!configXML.saveFile(ofToDataPath(KM_LAST_CONFIG_FILE)) ){
-			ofLogWarning("animationController::loadConfiguration") << "Failed saving lastLoadedConfiguration... (continuing...)";
-		}
-	}
-	else{
-		//ofLogError("animationController::loadConfiguration", "Loading from `"+_file+"` failed!");
-	}
-	
-	return success;
+// synchronous loads stop the output meanwhile, background ones swap in once ready (see configurationLoader)
+bool animationController::loadConfiguration(const string& _file, bool _inBackground){
+	return configLoader.load( _file, _inBackground );
+}
+
+bool animationController::isLoadingConfiguration() const {
+	return configLoader.isLoading();
+}
+
+// loads in the background, without touching the running configuration
+bool animationController::preloadConfiguration(const string& _file){
+	standbyLoader.discard();
+	return standbyLoader.preload( _file );
+}
+
+// _onBeat waits for the next mirReceiver tempo event
+bool animationController::switchToStandby(bool _onBeat){
+	return standbyLoader.switchToStandby( _onBeat );
+}
+
+void animationController::discardStandby(){
+	standbyLoader.discard();
+}
+
+bool animationController::isStandbyReady() const {
+	return standbyLoader.isReady();
 }
 
 bool animationController::loadLastConfiguration(){
@@ -666,115 +437,101 @@ bool animationController::saveConfiguration( const string& _filePath ){
 	}
 	else fullPath = ofToDataPath(_filePath);
 	
-	ofxXmlSettings sceneXML;
-	
-	sceneXML.addTag("sceneSettings");
-	if( sceneXML.pushTag("sceneSettings") ){
-		sceneXML.setValue("shapesFile", scene.getLoadedScene() );
-		sceneXML.popTag();
+	// streamed to disk, effects and modules still serialize trough ofxXmlSettings, one element at a time
+	karmaXmlWriter sceneXML;
+	if( !sceneXML.open(fullPath) ){
+		ofSystemAlertDialog("Could not save the current configuration... :(\nSave File: "+fullPath);
+		return false;
 	}
 	
-	sceneXML.addTag("guiSettings");
-	if( sceneXML.pushTag("guiSettings") ){
-		sceneXML.setValue("bShowGui", bShowGui );
-		sceneXML.setValue("bGuiShowMainWindow", bGuiShowMainWindow );
-		sceneXML.setValue("bGuiShowAnimParams", bGuiShowAnimParams );
-		sceneXML.setValue("bGuiShowPlugins", bGuiShowPlugins );
-		sceneXML.setValue("bGuiShowModules", bGuiShowModules );
-		sceneXML.setValue("bGuiShowConsole", bGuiShowConsole );
-		sceneXML.popTag();
-	}
+	sceneXML.beginElement("sceneSettings");
+	sceneXML.addValue("shapesFile", scene.getLoadedScene() );
+	sceneXML.endElement();
+	
+	sceneXML.beginElement("guiSettings");
+	sceneXML.addValue("bShowGui", bShowGui );
+	sceneXML.addValue("bGuiShowMainWindow", bGuiShowMainWindow );
+	sceneXML.addValue("bGuiShowAnimParams", bGuiShowAnimParams );
+	sceneXML.addValue("bGuiShowPlugins", bGuiShowPlugins );
+	sceneXML.addValue("bGuiShowModules", bGuiShowModules );
+	sceneXML.addValue("bGuiShowConsole", bGuiShowConsole );
+	sceneXML.addValue("bGuiShowProfiler", bGuiShowProfiler );
+	sceneXML.addValue("bGuiShowGovernor", bGuiShowGovernor );
+	sceneXML.addValue("bGuiShowRenderTargets", bGuiShowRenderTargets );
+	sceneXML.addValue("bFrameGovernor", frameGovernor.isEnabled() );
+	sceneXML.addValue("governorTargetFps", frameGovernor.getTargetFps() );
+	sceneXML.addValue("bParallelEffectUpdates", bParallelEffectUpdates );
+	sceneXML.addValue("bPipelinedUpdates", bPipelinedUpdates );
+	sceneXML.addValue("bCacheStaticLayers", bCacheStaticLayers );
+	sceneXML.endElement();
 	
 	// save all effect & layer data
-	sceneXML.addTag("layers");
-	vector<int> failedLayers;
 	vector<basicEffect*> totalFailedEffects;
-	if(sceneXML.pushTag("layers")){
-		int l=0;
-		failedLayers.clear();
-		for(auto layer = layers.begin(); layer!=layers.end(); ++layer, ++l){
+	sceneXML.beginElement("layers");
+	int l=0;
+	for(auto layer = layers.begin(); layer!=layers.end(); ++layer, ++l){
+		
+		karmaFboLayer& layerFbo = layer->first;
+		list<basicEffect*>& layerEffects = layer->second;
+		
+		sceneXML.beginElement("layer");
+		
+		// layer settings
+		sceneXML.addValue("layerName", layerFbo.getName());
+		sceneXML.addValue("layerIndex", layerFbo.getIndex());
+		
+		// layer effects
+		sceneXML.beginElement("effects");
+		for(auto it = layerEffects.begin(); it != layerEffects.end(); it++){
 			
-			karmaFboLayer& layerFbo = layer->first;
-			list<basicEffect*>& layerEffects = layer->second;
+			sceneXML.beginElement("effect");
 			
-			sceneXML.addTag("layer");
-			if( sceneXML.pushTag("layer",l) ){
-				
-				// layer settings
-				sceneXML.addValue("layerName", layerFbo.getName());
-				sceneXML.addValue("layerIndex", layerFbo.getIndex());
-				
-				// layer effects
-				sceneXML.addTag("effects");
-				vector<basicEffect*> failedEffects;
-				if (sceneXML.pushTag("effects")) {
-					
-					int e=0;
-					failedEffects.clear();
-					for(auto it = layerEffects.begin(); it != layerEffects.end(); it++, e++){
-						
-						sceneXML.addTag("effect");
-						if( sceneXML.pushTag("effect", e) ){
-							
-							if(!(*it)->saveToXML(sceneXML)) failedEffects.push_back(*it);
-							
-							sceneXML.popTag(); //pop effect
-						}
-						else {
-							ofLogError("animationController::saveConfiguration()") << "Layer " << l << " couldn't be saved due to an ofxXmlSettings error.";
-							failedEffects.push_back(*it);
-						}
-					}
-					sceneXML.popTag(); // pop effects
-				}
-				else {
-					ofLogError("animationController::saveConfiguration()") << "Effects " << l << " couldn't be saved due to an ofxXmlSettings error.";
-					failedLayers.push_back(l);
-				}
-				
-				totalFailedEffects.insert(totalFailedEffects.end(), failedEffects.begin(), failedEffects.end());
-				
-				sceneXML.popTag(); //pop layer
-			}
-			else {
-				ofLogError("animationController::saveConfiguration()") << "Layer " << l << " couldn't be created due to an ofxXmlSettings error.";
-				failedLayers.push_back(l);
+			ofxXmlSettings effectXML;
+			string effectString;
+			if( (*it)->saveToXML(effectXML) ){
+				effectXML.copyXmlToString(effectString);
+				sceneXML.addRaw(effectString);
 			}
+			else totalFailedEffects.push_back(*it);
+			(*it)->saveBoundShapes(sceneXML);
+			
+			sceneXML.endElement(); // effect
 		}
-		sceneXML.popTag(); // pop layers
+		sceneXML.endElement(); // effects
+		
+		sceneXML.endElement(); // layer
 	}
+	sceneXML.endElement(); // layers
 	
 	// save all modules data
-	sceneXML.addTag("modules");
 	vector<karmaModule*> failedModules;
-	if (sceneXML.pushTag("modules")) {
-	
-		int m=0;
-		failedModules.clear();
-		for(auto it = modules.begin(); it != modules.end(); it++, m++){
-			
-			sceneXML.addTag("module");
-			sceneXML.pushTag("module", m);
-			
-			if(!(*it)->saveToXML(sceneXML)) failedModules.push_back(*it);
-			
-			
-			sceneXML.popTag(); //pop module
+	sceneXML.beginElement("modules");
+	for(auto it = modules.begin(); it != modules.end(); it++){
+		
+		sceneXML.beginElement("module");
+		
+		ofxXmlSettings moduleXML;
+		string moduleString;
+		if( (*it)->saveToXML(moduleXML) ){
+			moduleXML.copyXmlToString(moduleString);
+			sceneXML.addRaw(moduleString);
 		}
+		else failedModules.push_back(*it);
 		
-		sceneXML.popTag(); // pop modules
+		sceneXML.endElement(); // module
 	}
+	sceneXML.endElement(); // modules
 	
 	// write down settings to disk
-	if( sceneXML.saveFile(fullPath) ){
+	if( sceneXML.close() ){
 		//loadedConfiguration = ofFilePath::getFileName(fullPath);
 		loadedConfiguration = fullPath;
 		success = true;
-		if(totalFailedEffects.size() == 0 && failedModules.size() == 0 && failedLayers.size() == 0 ){
+		if(totalFailedEffects.size() == 0 && failedModules.size() == 0 ){
 			ofLogNotice("animationController::saveConfiguration()", "Saved current configuration to `"+fullPath+"`");
 		}
 		else{
-			ofSystemAlertDialog("The configuration has been saved but "+ ofToString(totalFailedEffects.size()) +" effects and "+ ofToString(failedModules.size()) +" modules and "+ofToString(failedLayers.size())+" layers failed to save.");
+			ofSystemAlertDialog("The configuration has been saved but "+ ofToString(totalFailedEffects.size()) +" effects and "+ ofToString(failedModules.size()) +" modules failed to save.");
 		}
 	}
 	else ofSystemAlertDialog("Could not save the current configuration... :(\nSave File: "+fullPath);
@@ -979,32 +736,174 @@ unsigned int animationController::getNumLayers() const {
 // - - - - - - - -
 // EVENT LISTENERS
 // - - - - - - - -
+// resets altered shapes, then runs all effect updates with the given params
+void animationController::updateShapesAndEffects(const ::animationParams& _params){
+	// reset shapes data to original state
+	// every frame, effects can alter this. Only altered shapes need a reset.
+	{
+		KM_PROFILE_SCOPE("Reset shapes");
+		for(auto it=scene.getShapesRef().begin(); it!=scene.getShapesRef().end(); ++it){
+			if( (*it)->isModified() ) (*it)->resetToScene();
+		}
+	}
+	
+	// update effects (run mode)
+	// parallel-safe effects run in waves on the thread pool as long as their shape write sets don't overlap
+	// serial effects and overlapping write sets wait for the running wave, keeping layer order where it matters
+	{
+		karmaTaskGroup wave;
+		std::unordered_set<basicShape*> waveWriteSet;
+		vector<basicShape*> writeSet;
+		
+		for(auto layer = layers.rbegin(); layer!=layers.rend(); ++layer){
+			list<basicEffect*>& layerEffects = layer->second;
+			karmaFboLayer& renderLayer = layer->first;
+			
+			for(auto e=layerEffects.rbegin(); e!=layerEffects.rend(); ++e){
+				basicEffect* effect = *e;
+				
+				if( bParallelEffectUpdates && effect->canUpdateInParallel() ){
+					writeSet.clear();
+					effect->getShapeWriteSet( writeSet );
+					
+					for(auto s=writeSet.begin(); s!=writeSet.end(); ++s){
+						if( waveWriteSet.find(*s) != waveWriteSet.end() ){
+							threadPool.wait(wave);
+							waveWriteSet.clear();
+							break;
+						}
+					}
+					waveWriteSet.insert( writeSet.begin(), writeSet.end() );
+					
+					threadPool.run( wave, [this, effect, &renderLayer, &_params](){
+						KM_PROFILE_SCOPE( effect->getName() );
+						uint64_t start = ofGetElapsedTimeMicros();
+						effect->update(renderLayer, _params);
+						frameGovernor.addEffectCost( effect, ofGetElapsedTimeMicros()-start );
+					});
+				}
+				else {
+					threadPool.wait(wave);
+					waveWriteSet.clear();
+					
+					KM_PROFILE_SCOPE( effect->getName() );
+					uint64_t start = ofGetElapsedTimeMicros();
+					effect->update(renderLayer, _params);
+					frameGovernor.addEffectCost( effect, ofGetElapsedTimeMicros()-start );
+				}
+			}
+		}
+		
+		threadPool.wait(wave);
+	}
+	
+	// deformations, in layer & effect order whatever order the updates finished in
+	{
+		KM_PROFILE_SCOPE("Shape modifiers");
+		modifierStack.clear();
+		for(auto layer = layers.rbegin(); layer!=layers.rend(); ++layer){
+			for(auto e=layer->second.rbegin(); e!=layer->second.rend(); ++e){
+				modifierStack.add( **e );
+			}
+		}
+		modifierStack.evaluate( _params, bParallelEffectUpdates ? &threadPool : nullptr );
+	}
+}
+
+// pipelining needs every effect to leave the data used by its render() alone while updating
+bool animationController::canPipelineUpdates() const {
+	for(auto layer = layers.cbegin(); layer!=layers.cend(); ++layer){
+		for(auto e=layer->second.cbegin(); e!=layer->second.cend(); ++e){
+			if( !(*e)->canUpdateAheadOfRender() ) return false;
+		}
+	}
+	return true;
+}
+
+// summarizes everything the layer's effects render from
+// returns false if one of them changes by itself, the layer then can't be cached
+bool animationController::getLayerContentKey( const list<basicEffect*>& _effects, uint64_t& _key ) const {
+	_key = 14695981039346656037ULL;
+	auto mix = [&_key]( uint64_t _value ){ _key = (_key ^ _value) * 1099511628211ULL; };
+	
+	for(auto e=_effects.cbegin(); e!=_effects.cend(); ++e){
+		unsigned int dependencies = (*e)->getOutputDependencies();
+		if( dependencies & EFFECT_OUTPUT_USES_TIME ) return false;
+		
+		mix( (uintptr_t) *e );
+		mix( (*e)->getRevision() );
+		mix( (*e)->isReady() );
+		
+		if( dependencies & EFFECT_OUTPUT_USES_SHAPES ){
+			mix( (uint64_t)( (*e)->getLodError()*1000.f ) ); // simplified outlines
+			
+			const vector<basicShape*>& shapes = (*e)->getShapes();
+			for(auto s=shapes.cbegin(); s!=shapes.cend(); ++s){
+				mix( (uintptr_t) *s );
+				mix( (*s)->getRenderRevision() );
+			}
+		}
+	}
+	
+	return true;
+}
+
 void animationController::update(ofEventArgs &event){
+	// a profiler frame spans from update() to the end of draw()
+	karmaProfiler::getInstance().beginFrame();
+	
+	// background loading, might swap in a new configuration
+	configLoader.update();
+	standbyLoader.update();
+	
 	if(!isEnabled()) return;
 	
-	// reset shapes data to original state
-	// every frame, effects can alter this
-	for(auto it=scene.getShapesRef().begin(); it!=scene.getShapesRef().end(); ++it){
-		(*it)->resetToScene();
+	frameStartMicros = ofGetElapsedTimeMicros();
+	
+	KM_PROFILE_SCOPE("Update");
+	
+	// pipelined: the shapes for this frame were computed on a worker while the previous frame rendered
+	if( bSimulationPending ){
+		KM_PROFILE_SCOPE("Wait simulation");
+		threadPool.wait(simulationTask);
+		bSimulationPending = false;
+	}
+	else {
+		updateShapesAndEffects( animationParams.params );
 	}
 	
-	// update effects (run mode)
-	for(auto layer = layers.rbegin(); layer!=layers.rend(); ++layer){
-		list<basicEffect*>& layerEffects = layer->second;
+	// shape data is final for this frame
+	{
+		KM_PROFILE_SCOPE("Commit shapes");
+		for(auto it=scene.getShapesRef().begin(); it!=scene.getShapesRef().end(); ++it){
+			unsigned int renderRevision = (*it)->getRenderRevision();
+			(*it)->commitRenderState();
+			if( (*it)->getRenderRevision() != renderRevision ) scene.markShapeMoved( *it );
+		}
+		
+		// only the shapes which changed, queries during the next updates see this frame's boxes
+		scene.updateSpatialIndex();
 		
-		for(auto e=layerEffects.rbegin(); e!=layerEffects.rend(); ++e){
-			(*e)->update(layer->first, animationParams.params);
+		// what the effects render from, the next update can then run ahead
+		for(auto layer = layers.begin(); layer!=layers.end(); ++layer){
+			for(auto e=layer->second.begin(); e!=layer->second.end(); ++e){
+				(*e)->commitRenderState();
+			}
 		}
 	}
 	
 	// update modules
 	for(auto m=modules.begin(); m!=modules.end(); ++m){
+		KM_PROFILE_SCOPE( (*m)->getName() );
 		(*m)->update( animationParams.params );
 	}
 }
 
 void animationController::draw(ofEventArgs& event){
-	if(!isEnabled()) return;
+	if(!isEnabled()){
+		karmaProfiler::getInstance().endFrame();
+		return;
+	}
 	
 	// set idle time
 	animationParams.params.idleTimeMillis = idleTimeTimer.getElapsedMillis();
@@ -1019,11 +918,39 @@ void animationController::draw(ofEventArgs& event){
 	ofClear(0,1);
 	//ofBackground(255,0,0);
 	
+	KM_PROFILE_BEGIN(drawScope, "Draw");
+	
 	// draw modules
 	for(auto m=modules.begin(); m!=modules.end(); ++m){
+		KM_PROFILE_SCOPE( (*m)->getName() );
 		(*m)->draw(animationParams.params);
 	}
 	
+	// pipelined: simulate the next frame on a worker while this one renders from the committed shape copies
+	if( bPipelinedUpdates && canPipelineUpdates() ){
+		simulationParams = animationParams.params;
+		bSimulationPending = true;
+		threadPool.run( simulationTask, [this](){
+			KM_PROFILE_SCOPE("Simulate next frame");
+			updateShapesAndEffects( simulationParams );
+		});
+	}
+	
+	numCachedLayers = 0;
+	
+	// window resized ? Layer contents are gone.
+	if( karmaRenderTargetPool::getInstance().beginFrame() ){
+		for(auto layer = layers.begin(); layer!=layers.end(); ++layer){
+			layer->first.clear(0);
+		}
+	}
+	
+	// upload the committed shape geometry once for all effects
+	{
+		KM_PROFILE_SCOPE("Batch shapes");
+		shapesBatcher::getInstance().update( scene.getShapesRef() );
+	}
+	
 	// render a scene without effects (tmp?)
 	if(layers.size()==0){
 		ofSetColor( ofFloatColor(1.f, 1));//params.seasons.summer));
@@ -1036,21 +963,57 @@ void animationController::draw(ofEventArgs& event){
 	else for(auto layer = layers.rbegin(); layer!=layers.rend(); ++layer){
 		list<basicEffect*>& layerEffects = layer->second;
 		
-		// prevents screen flickering using double FBO + uneven nb of effects
-		layer->first.resetSwap();
-		
-		//layer->first.begin();
-		// draw effects
-		for(auto e=layerEffects.rbegin(); e!=layerEffects.rend(); ++e){
-			(*e)->render(layer->first, animationParams.params);
+		// nothing changed since the last rendering ? Composite it again.
+		uint64_t contentKey = 0;
+		bool bCacheable = bCacheStaticLayers && getLayerContentKey( layerEffects, contentKey );
+		if( bCacheable && layer->first.isCached( contentKey ) ){
+			numCachedLayers++;
+			KM_RECORD_RENDER_CALL(layerCacheHits, 1);
+		}
+		else {
+			// prevents screen flickering using double FBO + uneven nb of effects
+			layer->first.resetSwap();
+			
+			//layer->first.begin();
+			// draw effects
+			for(auto e=layerEffects.rbegin(); e!=layerEffects.rend(); ++e){
+				KM_PROFILE_SCOPE( (*e)->getName() );
+				uint64_t start = ofGetElapsedTimeMicros();
+				(*e)->render(layer->first, animationParams.params);
+				frameGovernor.addEffectCost( *e, ofGetElapsedTimeMicros()-start );
+			}
+			
+			if( bCacheable ) layer->first.setCached( contentKey );
+			else layer->first.invalidateCache();
 		}
 		//cout << "DONE --- Drawing fbo.texture: "<<" // " << layer->first.getFBO().getIdDrawBuffer()<<endl;
-		layer->first.getSrcTexture().draw(0,0);
+		{
+			KM_PROFILE_SCOPE( layer->first.getProfileLabel() );
+			layer->first.getSrcTexture().draw(0,0);
+			KM_RECORD_RENDER_CALL(layerComposites, 1);
+		}
 		
 		// uncomment to view layer contents
 		//layer->first.getSrcTextureIndex(0).draw( ofGetWidth()-500, ofGetHeight()-200*(layer->first.getIndex()+1), 250,200);
 		//layer->first.getSrcTextureIndex(1).draw( ofGetWidth()-250, ofGetHeight()-200*(layer->first.getIndex()+1), 250,200);
 	}
+	KM_PROFILE_END(drawScope);
+	
+	// the GUI & listeners below can alter effects and shapes
+	if( bSimulationPending ){
+		KM_PROFILE_SCOPE("Wait simulation");
+		threadPool.wait(simulationTask);
+	}
+	
+	// adapt effect quality levels to the frame rate
+	governedEffects.clear();
+	for(auto layer = layers.begin(); layer!=layers.end(); ++layer){
+		governedEffects.insert( governedEffects.end(), layer->second.begin(), layer->second.end() );
+	}
+	frameGovernor.endFrame( ofGetLastFrameTime()*1000.f, (ofGetElapsedTimeMicros()-frameStartMicros)/1000.f, governedEffects );
+	
+	// frees render targets nobody used for a while
+	karmaRenderTargetPool::getInstance().endFrame();
 	
 	// notify end draw (before GUI)
 	drawEventArgs.params = animationParams.params;
@@ -1058,7 +1021,9 @@ void animationController::draw(ofEventArgs& event){
 	ofNotifyEvent(animationController::karmaControllerAfterDraw, drawEventArgs, this);
 	
 	
+#ifndef KM_BENCHMARK_APP
 	// draw gui stuff
+	KM_PROFILE_BEGIN(guiScope, "ImGui");
 	ofPushStyle();
 	//ofNoFill();
 	gui.begin();
@@ -1073,9 +1038,10 @@ void animationController::draw(ofEventArgs& event){
 			
 			ImGui::MenuItem("FPS", ofToString( ofGetFrameRate() ).c_str() );
 			
-			// Could be useful:
-			// https://github.com/armadillu/ofxTimeMeasurements.git
-			ImGui::MenuItem("Application load", "#todo" );
+			// frame time of the last profiled frame (update + draw)
+			if( ImGui::MenuItem("Application load", (ofToString( karmaProfiler::getInstance().getLastFrameMillis(), 2 ) + " ms").c_str() ) ){
+				bGuiShowProfiler = true;
+			}
 			
 			char buffer[26];
 			snprintf(buffer, 26, "Resolution: %d x %i", ofGetWidth(), ofGetHeight() );
@@ -1111,6 +1077,10 @@ void animationController::draw(ofEventArgs& event){
 				newConfiguration();
 			}
 			
+			if( isLoadingConfiguration() ){
+				ImGui::Text("Loading configuration... %.0f%%", configLoader.getProgress()*100.f);
+			}
+			
 			if (ImGui::BeginMenu("Load configuration..." ) ){
 				
 //				if (ImGui::MenuItem("File browser...", ofToString(KM_CTRL_KEY_NAME).append( " + O" ).c_str() )){
@@ -1128,7 +1098,7 @@ void animationController::draw(ofEventArgs& event){
 						if( ImGui::MenuItem( dir.getName(i).c_str(), "", (bool)(scene.getLoadedScene() == dir.getPath(i)) ) ){
 							
 							// todo: add error feedback here
-							loadConfiguration(dir.getPath(i));
+							loadConfiguration(dir.getPath(i), true);
 
 						}
 					}
@@ -1136,6 +1106,41 @@ void animationController::draw(ofEventArgs& event){
 				ImGui::EndMenu();
 			}
 			
+			// standby slot
+			if (ImGui::BeginMenu("Preload configuration..." ) ){
+				ofDirectory dir;
+				dir.listDir( ofToDataPath( KM_CONFIG_FOLDER ) );
+				dir.sort();
+				if( dir.size() <= 0 ){
+					ImGui::Text("No files in %s", KM_CONFIG_FOLDER);
+				} else {
+					for (int i = 0; i < dir.size(); i++){
+						if( ImGui::MenuItem( dir.getName(i).c_str(), "", (bool)(standbyLoader.getFile() == dir.getPath(i)) ) ){
+							preloadConfiguration(dir.getPath(i));
+						}
+					}
+				}
+				ImGui::EndMenu();
+			}
+			if( standbyLoader.isLoading() ){
+				ImGui::Text("Preloading %s... %.0f%%", ofFilePath::getFileName(standbyLoader.getFile()).c_str(), standbyLoader.getProgress()*100.f);
+			}
+			if( standbyLoader.isReady() ){
+				ImGui::Text("Standby: %s (%.0fMB)", ofFilePath::getFileName(standbyLoader.getFile()).c_str(), standbyLoader.getMemoryUsage()/(1024.f*1024.f));
+			}
+			if( standbyLoader.isSwitchPending() ){
+				ImGui::Text( bSwitchStandbyOnBeat ? "Switching on the next beat..." : "Switching..." );
+			}
+			else if( ImGui::MenuItem("Switch to preloaded", NULL, false, standbyLoader.isReady() || standbyLoader.isLoading() ) ){
+				switchToStandby( bSwitchStandbyOnBeat );
+			}
+			ImGui::MenuItem("Switch on beat", NULL, &bSwitchStandbyOnBeat);
+			if( (standbyLoader.isReady() || standbyLoader.isLoading()) && ImGui::MenuItem("Discard preloaded") ){
+				discardStandby();
+			}
+			
+			ImGui::MenuItem("", "", false, false);
+			
 			if ( !loadedConfiguration.empty() && ImGui::MenuItem("Save configuration", ofToString(KM_CTRL_KEY_NAME).append( " + S" ).c_str() )){
 				saveConfiguration();
 			}
@@ -1200,6 +1205,24 @@ void animationController::draw(ofEventArgs& event){
 			
 			ImGui::MenuItem(GUIToggleConsole, NULL, &bGuiShowConsole);
 			
+			ImGui::MenuItem(GUIToggleProfiler, NULL, &bGuiShowProfiler);
+			
+			ImGui::MenuItem(GUIToggleGovernor, frameGovernor.isEnabled() ? (ofToString(frameGovernor.getNumDegradedEffects()) + " lowered").c_str() : "(off)", &bGuiShowGovernor);
+			
+			ImGui::MenuItem(GUIToggleRenderTargets, (ofToString( karmaRenderTargetPool::getInstance().getAllocatedBytes()/1048576 ) + " MB").c_str(), &bGuiShowRenderTargets);
+			
+			ImGui::MenuItem(GUIToggleParallelUpdates, (ofToString(threadPool.getNumThreads()) + " threads").c_str(), &bParallelEffectUpdates);
+			
+			ImGui::MenuItem(GUITogglePipelinedUpdates, canPipelineUpdates()?"":"(inactive, some effects can't)", &bPipelinedUpdates);
+			if( ImGui::IsItemHovered() ){
+				ImGui::SetTooltip("Updates the next frame while rendering the current one.\nOnly works if all loaded effects support it.");
+			}
+			
+			ImGui::MenuItem(GUIToggleLayerCaching, (ofToString(numCachedLayers) + "/" + ofToString(layers.size()) + " cached").c_str(), &bCacheStaticLayers);
+			if( ImGui::IsItemHovered() ){
+				ImGui::SetTooltip("Layers whose effects, settings and shapes didn't change are not rendered again.");
+			}
+			
 			ImGui::MenuItem(GUIShowModules, NULL, &bGuiShowModules );
 			
 			ImGui::MenuItem(GUIShowPlugins, NULL, &bGuiShowPlugins );
@@ -1267,7 +1290,7 @@ void animationController::draw(ofEventArgs& event){
 						ImGui::SameLine();
 						ImGui::RadioButton("All", &shapeTypeFilter, 0);
 						
-						auto shapesByType = scene.getAllShapesByType();
+						const auto& shapesByType = scene.getAllShapesByType();
 						int i = 1;
 						for( auto it = shapesByType.begin(); it!=shapesByType.end(); ++it, ++i ){
 							ImGui::SameLine();
@@ -1758,6 +1781,21 @@ void animationController::draw(ofEventArgs& event){
 			karmaConsoleChannel::getLogger()->drawImGui (GUIConsolePanel, bGuiShowConsole );
 		}
 		
+		// show profiler ?
+		if( bGuiShowProfiler ){
+			karmaProfiler::getInstance().drawImGui( GUIProfilerPanel, bGuiShowProfiler );
+		}
+		
+		// show frame governor ?
+		if( bGuiShowGovernor ){
+			frameGovernor.drawImGui( GUIGovernorPanel, bGuiShowGovernor, governedEffects );
+		}
+		
+		// show VRAM usage ?
+		if( bGuiShowRenderTargets ){
+			karmaRenderTargetPool::getInstance().drawImGui( GUIRenderTargetsPanel, bGuiShowRenderTargets );
+		}
+		
 		// show effects gui
 		for(auto layer = layers.begin(); layer!=layers.end(); ++layer){
 			list<basicEffect*>& layerEffects = layer->second;
@@ -1805,9 +1843,13 @@ void animationController::draw(ofEventArgs& event){
 	
 	gui.end();
 	ofPopStyle();
+	KM_PROFILE_END(guiScope);
+#endif
 	
 	// fire idle timer at end of draw
 	idleTimeTimer.setStartTime();
+	
+	karmaProfiler::getInstance().endFrame();
 }
 
 // - - - - - - - -
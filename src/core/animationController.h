@@ -22,8 +22,14 @@
 #include "animationParamsServer.h"
 #include "karmaModule.h"
 #include "karmaConsole.h"
+#include "karmaProfiler.h"
+#include "karmaThreadPool.h"
+#include "shapeModifierStack.h"
+#include "karmaFrameGovernor.h"
 #include "animationControllerEvents.h"
 #include "karmaFboLayer.h"
+#include "karmaRenderTargetPool.h"
+#include "configurationLoader.h"
 #include "karmaUtilities.h"
 #include "ofxMSATimer.h"
 
@@ -46,6 +52,7 @@
 class animationController {
 	// let ImGui control app variables
 	friend class ofxImGui;
+	friend class configurationLoader;
 	
 public:
 	animationController( shapesDB& _scene );
@@ -59,10 +66,17 @@ public:
 	bool isEnabled() const;
 	bool removeEffect( basicEffect* _e);
 	bool addEffect( basicEffect* _e, karmaFboLayer& _layer );
+	karmaFboLayer& addLayer( const string& _name );
 	bool removeLayer( karmaFboLayer& _layer );
 
 	// load & save
-	bool loadConfiguration(const string& _file = "");
+	bool loadConfiguration(const string& _file = "", bool _inBackground = false);
+	bool isLoadingConfiguration() const;
+	// standby slot for cues: preload the next configuration, then switch to it in one frame
+	bool preloadConfiguration(const string& _file);
+	bool switchToStandby(bool _onBeat = false);
+	void discardStandby();
+	bool isStandbyReady() const;
 	bool loadLastConfiguration();
 	bool saveConfiguration(const string& _filePath = "");
 	string loadedConfiguration;
@@ -79,6 +93,12 @@ public:
 	vector<basicEffect*> getEffectsOfType(string _type);
 	map<string, vector<basicEffect*> > getAllEffectsByType() const;
 	unsigned int getNumLayers() const;
+	const ::animationParams& getAnimationParams() const { return animationParams.params; }
+	animationParamsServer& getAnimationParamsServer() { return animationParams; }
+	karmaFrameGovernor& getFrameGovernor() { return frameGovernor; }
+	void setPipelinedUpdates( bool _pipelined ) { bPipelinedUpdates = _pipelined; }
+	// true once draw() started the next frame's update ahead
+	bool isPipelining() const { return bSimulationPending; }
 	
 	// event handlers
 	void update( ofEventArgs& event );
@@ -107,6 +127,12 @@ protected:
 	bool bGuiShowPlugins;
 	bool bGuiShowModules;
 	bool bGuiShowConsole;
+	bool bGuiShowProfiler;
+	bool bGuiShowGovernor;
+	bool bGuiShowRenderTargets;
+	bool bParallelEffectUpdates;
+	bool bPipelinedUpdates;
+	bool bCacheStaticLayers;
 	
 	// gui
 	ofxImGui gui;
@@ -122,7 +148,29 @@ protected:
 	animationParamsServer animationParams;
 	list< karmaModule* > modules;
 	
+	karmaThreadPool threadPool; // runs parallel effect updates
+	shapeModifierStack modifierStack; // deformations, applied after the effect updates
+	
+	// effect updates
+	void updateShapesAndEffects( const ::animationParams& _params );
+	bool canPipelineUpdates() const;
+	karmaTaskGroup simulationTask; // pipelined mode: next frame's update
+	::animationParams simulationParams; // params copy used by simulationTask
+	bool bSimulationPending;
+	
+	// static layer caching
+	bool getLayerContentKey( const list<basicEffect*>& _effects, uint64_t& _key ) const;
+	unsigned int numCachedLayers; // last frame
+	
+	// adaptive quality
+	karmaFrameGovernor frameGovernor;
+	vector<basicEffect*> governedEffects; // all effects, refreshed every frame
+	uint64_t frameStartMicros;
+	
 	shapesDB& scene;
+	configurationLoader configLoader; // after scene, it's destroyed first
+	configurationLoader standbyLoader;
+	bool bSwitchStandbyOnBeat;
 	
 	ofxMSATimer idleTimeTimer;
 	uint32_t currentIdleTime;
@@ -163,3 +211,6 @@ private:
 #define GUIModulesPanel "Modules"
 #define GUIToggleConsole "Show Console Window"
 #define GUIConsolePanel "Console"
+#define GUIToggleParallelUpdates "Parallel effect updates"
+#define GUITogglePipelinedUpdates "Pipelined updates"
+#define GUIToggleLayerCaching "Cache static layers"
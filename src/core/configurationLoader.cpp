@@ -0,0 +1,588 @@
+//
+//  configurationLoader.cpp
+//  karmaMapper
+//
+
+#include "configurationLoader.h"
+#include "animationController.h"
+
+// - - - - - - - -
+// PARSING
+// - - - - - - - -
+// reads a configuration file into a plan, in file order:
+// <sceneSettings>, <guiSettings>, <layers> or the old <effects>, <modules>
+// effects and modules keep their element's source, they read it themselves once created (see basicEffect::onXmlElementStart())
+class configurationPlanReader : public karmaXmlVisitor {
+public:
+	configurationPlanReader( configurationPlan& _plan ) : plan(_plan), effectDepth(-1) {}
+	
+	virtual bool onXmlElementStart( const karmaXmlElement& _element ){
+		unsigned int depth = _element.getDepth();
+		
+		if( depth == 0 ){
+			if( _element.is("sceneSettings") ) plan.bHasSceneSettings = true;
+			else if( _element.is("layers") ) plan.bHasLayers = true;
+			else if( _element.is("modules") ) plan.bHasModules = true;
+			// fix (import (old)savefiles which don't have layers
+			else if( _element.is("effects") ){
+				plan.bHasLayers = true;
+				plan.bLegacyEffects = true;
+				plan.layers.emplace_back();
+				plan.layers.back().name = "Initial Layer";
+			}
+		}
+		
+		// layers > layer
+		else if( depth == 1 && _element.is("layer") && _element.isChildOf("layers") ){
+			plan.layers.emplace_back();
+			plan.layers.back().name = "Layer "+ofToString(plan.layers.size()-1);
+		}
+		
+		// (layers > layer >) effects > effect
+		else if( effectDepth < 0 && _element.is("effect") && _element.isChildOf("effects") && plan.layers.size() > 0 ){
+			effectDepth = depth;
+			plan.layers.back().effects.emplace_back();
+			plan.layers.back().effects.back().type = "basicEffect";
+		}
+		else if( effectDepth >= 0 && (int)depth == effectDepth+2 && _element.is("shape") && _element.isChildOf("boundShapes") ){
+			plan.layers.back().effects.back().boundShapes.push_back( make_pair(
+				_element.getAttribute("name", ""),
+				_element.getAttribute("type", "undefined type")
+			));
+		}
+		
+		// modules > module
+		else if( depth == 1 && _element.is("module") && _element.isChildOf("modules") ){
+			plan.modules.emplace_back();
+			plan.modules.back().type = "karmaModule";
+		}
+		
+		return true;
+	}
+	
+	virtual void onXmlValue( const karmaXmlElement& _element ){
+		unsigned int depth = _element.getDepth();
+		
+		if( depth == 1 && _element.is("shapesFile") && _element.isChildOf("sceneSettings") ){
+			plan.shapesFile = _element.getText();
+		}
+		else if( depth == 2 && _element.is("layerName") && _element.isChildOf("layer") && plan.layers.size() > 0 ){
+			plan.layers.back().name = _element.getValue( plan.layers.back().name );
+		}
+		else if( effectDepth >= 0 && (int)depth == effectDepth+1 && _element.is("effectType") ){
+			plan.layers.back().effects.back().type = _element.getValue("basicEffect");
+		}
+		else if( depth == 2 && _element.is("moduleType") && _element.isChildOf("module") && plan.modules.size() > 0 ){
+			plan.modules.back().type = _element.getValue("karmaModule");
+		}
+	}
+	
+	virtual bool onXmlElementEnd( const karmaXmlElement& _element ){
+		unsigned int depth = _element.getDepth();
+		
+		if( depth == 0 && _element.is("guiSettings") ){
+			plan.guiSettings.assign( _element.getSource(), _element.getSourceSize() );
+		}
+		else if( (int)depth == effectDepth && _element.is("effect") ){
+			plan.layers.back().effects.back().source.assign( _element.getSource(), _element.getSourceSize() );
+			effectDepth = -1;
+		}
+		else if( depth == 1 && _element.is("module") && _element.isChildOf("modules") && plan.modules.size() > 0 ){
+			plan.modules.back().source.assign( _element.getSource(), _element.getSourceSize() );
+		}
+		
+		return true;
+	}
+
+private:
+	configurationPlan& plan;
+	int effectDepth; // of the current <effect>, -1 = none
+};
+
+// applies <guiSettings>
+class configurationLoader::guiSettingsReader : public karmaXmlVisitor {
+public:
+	guiSettingsReader( configurationLoader& _loader ) : loader(_loader) {}
+	
+	virtual void onXmlValue( const karmaXmlElement& _element ){
+		if( _element.getDepth() == 1 ) loader.applyGuiSetting( _element );
+	}
+
+private:
+	configurationLoader& loader;
+};
+
+// - - - - - - - -
+// CONSTRUCTORS
+// - - - - - - - -
+configurationLoader::configurationLoader( animationController& _controller ) : controller(_controller), state(LOADER_IDLE), bParsed(false), bSwitchOnBeat(false), bBeat(false) {
+	reset();
+	
+	ofAddListener(mirReceiver::mirTempoEvent, this, &configurationLoader::tempoEventListener);
+}
+
+configurationLoader::~configurationLoader(){
+	ofRemoveListener(mirReceiver::mirTempoEvent, this, &configurationLoader::tempoEventListener);
+	
+	if( worker.joinable() ) worker.join();
+	reset();
+}
+
+// - - - - - - - -
+// LOADING
+// - - - - - - - -
+bool configurationLoader::load( const string& _file, bool _inBackground ){
+	if( _file.empty() ){
+		ofLogError("animationController::loadConfiguration") << "Not loading, no file name specified";
+		return false;
+	}
+	// the previous configuration is still being deleted, finish now
+	if( state == LOADER_RETIRING ){
+		reset();
+		state = LOADER_IDLE;
+	}
+	if( state != LOADER_IDLE ){
+		ofLogWarning("animationController::loadConfiguration") << "Still loading `" << file << "`, not loading `" << _file << "`.";
+		return false;
+	}
+	
+	if( worker.joinable() ) worker.join();
+	reset();
+	file = _file;
+	
+	if( !_inBackground ){
+		bParsed = parse();
+		if( !bParsed ){
+			reset();
+			return false;
+		}
+		
+		controller.stop();
+		state = LOADER_STAGING;
+		while( stageNext() ){}
+		controller.start();
+		swap();
+		
+		bool loaded = success;
+		reset();
+		state = LOADER_IDLE;
+		return loaded;
+	}
+	
+	state = LOADER_PARSING;
+	worker = std::thread( [this](){
+		bParsed = parse();
+		state = LOADER_STAGING;
+	});
+	
+	return true;
+}
+
+void configurationLoader::update(){
+	// a few effects per frame
+	uint64_t start = ofGetElapsedTimeMillis();
+	
+	if( state == LOADER_RETIRING ){
+		while( retireNext() ){
+			if( ofGetElapsedTimeMillis()-start >= KM_CONFIG_LOADER_FRAME_BUDGET ) return;
+		}
+		reset();
+		state = LOADER_IDLE;
+		return;
+	}
+	
+	if( state == LOADER_READY ){
+		if( !bSwitchRequested || ( bSwitchOnBeat && !bBeat ) ) return;
+		
+		ofLogNotice("animationController::switchToStandby") << "Switching to `" << file << "`";
+		swap();
+		state = LOADER_RETIRING;
+		return;
+	}
+	
+	if( state != LOADER_STAGING ) return;
+	
+	if( worker.joinable() ) worker.join();
+	if( !bParsed || bDiscard ){
+		bool bSwitch = bSwitchRequested;
+		bool bOnBeat = bSwitchOnBeat;
+		reset();
+		state = LOADER_IDLE;
+		
+		// a preload was asked for meanwhile, a pending switch now goes to it
+		if( !queuedFile.empty() ){
+			string next;
+			next.swap( queuedFile );
+			if( preload( next ) && bSwitch ) switchToStandby( bOnBeat );
+		}
+		return;
+	}
+	
+	bool bStaging = true;
+	while( bStaging ){
+		bStaging = stageNext();
+		
+		if( bStandby && memoryUsage > (size_t) KM_STANDBY_MEMORY_BUDGET*1024*1024 ){
+			ofLogError("animationController::preloadConfiguration") << "`" << file << "` needs more than " << KM_STANDBY_MEMORY_BUDGET << "MB, not preloading it.";
+			reset();
+			state = LOADER_IDLE;
+			return;
+		}
+		
+		if( bStaging && ofGetElapsedTimeMillis()-start >= KM_CONFIG_LOADER_FRAME_BUDGET ) return;
+	}
+	
+	// standby: hold it, update() switches once asked
+	if( bStandby ){
+		ofLogNotice("animationController::preloadConfiguration") << "`" << file << "` is ready (" << memoryUsage/(1024*1024) << "MB)";
+		state = LOADER_READY;
+		return;
+	}
+	
+	swap();
+	state = LOADER_RETIRING;
+}
+
+bool configurationLoader::isLoading() const {
+	return state == LOADER_PARSING || state == LOADER_STAGING;
+}
+
+float configurationLoader::getProgress() const {
+	if( state == LOADER_READY ) return 1.f;
+	if( state != LOADER_STAGING ) return 0.f;
+	return numToStage > 0 ? numStaged / (float) numToStage : 1.f;
+}
+
+// - - - - - - - -
+// STANDBY SLOT
+// - - - - - - - -
+bool configurationLoader::preload( const string& _file ){
+	// the worker can't be interrupted, update() drops its result and starts this one
+	if( bStandby && state == LOADER_PARSING ){
+		bDiscard = true;
+		queuedFile = _file;
+		ofLogNotice("animationController::preloadConfiguration") << "Preloading `" << _file << "` once `" << file << "` is parsed.";
+		return true;
+	}
+	
+	if( !load( _file, true ) ) return false;
+	
+	bStandby = true;
+	return true;
+}
+
+bool configurationLoader::switchToStandby( bool _onBeat ){
+	if( !bStandby || state == LOADER_IDLE || state == LOADER_RETIRING ){
+		ofLogWarning("animationController::switchToStandby") << "Nothing preloaded, not switching.";
+		return false;
+	}
+	
+	bBeat = false;
+	bSwitchOnBeat = _onBeat;
+	bSwitchRequested = true;
+	return true;
+}
+
+void configurationLoader::discard(){
+	queuedFile.clear();
+	if( !bStandby ) return;
+	
+	// the worker can't be interrupted, update() drops its result
+	if( state == LOADER_PARSING ){
+		bDiscard = true;
+		return;
+	}
+	
+	if( state == LOADER_STAGING || state == LOADER_READY ){
+		if( worker.joinable() ) worker.join();
+		reset();
+		state = LOADER_IDLE;
+	}
+}
+
+bool configurationLoader::isReady() const {
+	return state == LOADER_READY;
+}
+
+bool configurationLoader::isSwitchPending() const {
+	return bSwitchRequested && state != LOADER_IDLE && state != LOADER_RETIRING;
+}
+
+const string& configurationLoader::getFile() const {
+	if( !queuedFile.empty() ) return queuedFile;
+	return file;
+}
+
+size_t configurationLoader::getMemoryUsage() const {
+	return memoryUsage;
+}
+
+// the main tempo only, not the second tracker
+void configurationLoader::tempoEventListener( mirTempoEventArgs& _args ){
+	if( bSwitchOnBeat && !_args.isTempoBis ) bBeat = true;
+}
+
+// - - - - - - - -
+// INTERNALS
+// - - - - - - - -
+// no GL here
+bool configurationLoader::parse(){
+	karmaXmlReader configXML;
+	if( !configXML.open(file) ){
+		// todo: make this a GUI message
+		ofLogError("animationController::loadConfiguration") << "404 - The config file `"<< file << "` does not exist or is not readable.";
+		return false;
+	}
+	
+	configurationPlanReader planReader( plan );
+	if( !configXML.parse( planReader ) ){
+		ofLogError("animationController::loadConfiguration") << file << ": " << configXML.getError();
+		return false;
+	}
+	configXML.close();
+	
+	// load shapes scene
+	if( plan.bHasSceneSettings ){
+		// worker thread, swap() remembers it once it's used
+		bSceneLoaded = stagingScene.loadScene( plan.shapesFile, false );
+		// todo: make this a GUI warning modal ?
+		if( !bSceneLoaded ) ofLogWarning("animationController::loadConfiguration") << "The config file is loading but it's associated shapes scene file was not found. ( continuing... )";
+	}
+	else {
+		ofLogNotice("animationController::loadConfiguration") << "The config file has no shapes scene file. Loading effects without shapes.";
+	}
+	
+	if( !plan.bHasLayers ){
+		ofLogError("animationController::loadConfiguration") << "Weird situation... Can't push into layers section.";
+		plan.layers.emplace_back();
+		plan.layers.back().name = "Initial Layer";
+	}
+	if( !plan.bHasModules ){
+		ofLogNotice("animationController::loadConfiguration") << "No modules in file, skipping modules!";
+	}
+	
+	numToStage = 0;
+	for(auto it=plan.layers.cbegin(); it!=plan.layers.cend(); ++it){
+		numToStage += it->effects.size();
+	}
+	
+	return true;
+}
+
+// main thread, creates one effect per call
+bool configurationLoader::stageNext(){
+	while( nextLayer < plan.layers.size() ){
+		const configurationPlan::layerPlan& layerPlan = plan.layers[nextLayer];
+		
+		if( stagingLayers.size() == nextLayer ){
+			stagingLayers.emplace_back(
+				karmaFboLayer(ofGetWidth(),ofGetHeight()),
+				list<basicEffect*>()
+			);
+			stagingLayers.back().first.set( layerPlan.name, nextLayer );
+			memoryUsage += (size_t) stagingLayers.back().first.getWidth() * stagingLayers.back().first.getHeight() * 4 * 2; // 2 rgba ping-pong buffers
+			effectIndexes.clear();
+			numFailedLayerEffects = 0;
+		}
+		
+		if( nextEffect < layerPlan.effects.size() ){
+			if( !stageEffect( layerPlan.effects[nextEffect], stagingLayers.back().second ) ) numFailedLayerEffects++;
+			nextEffect++;
+			numStaged++;
+			return true;
+		}
+		
+		// layer done
+		if( layerPlan.effects.size() == 0 ){
+			if( plan.bLegacyEffects ) ofLogError("animationController::loadConfiguration") << "Couldn't import OLD CONFIG FILE, sorry...";
+			else ofLogNotice("animationController::loadConfiguration") << "No effects in layer #"<< nextLayer << ", skipping effects on this layer!";
+		}
+		if( numFailedLayerEffects > 0 ){
+			ofLogError("animationController::loadConfiguration") << "Failed loading " << numFailedLayerEffects << " effects on layer #" << nextLayer;
+		}
+		ofLogVerbose("animationController::loadConfiguration") << "Loaded layer #"<< nextLayer << "/"<< plan.layers.size() <<" ("<< stagingLayers.back().first.getName() << ") from file [" << file << "] with [" << layerPlan.effects.size() << " effects] ( " << numFailedLayerEffects << "failed )";
+		
+		numFailedEffects += numFailedLayerEffects;
+		nextLayer++;
+		nextEffect = 0;
+	}
+	
+	return false;
+}
+
+bool configurationLoader::stageEffect( const configurationPlan::effectPlan& _plan, list<basicEffect*>& _layerEffects ){
+	// Some code comes from:
+	// --> http://stackoverflow.com/questions/8269465/how-can-i-instantiate-an-object-knowing-only-its-name
+	basicEffect* effect = effect::create(_plan.type);
+	if( effect == nullptr ){
+		// unknow effect type
+		ofLogError("effect::create") << "Effect type not found: " << _plan.type;
+		return false;
+	}
+	
+	_layerEffects.push_back( effect );
+	effect->initialise( controller.animationParams.params );
+	
+	// the effect reads its own element
+	karmaXmlReader effectReader;
+	if( !effectReader.parse( _plan.source.data(), _plan.source.size(), *effect ) ){
+		ofLogWarning("animationController::loadConfiguration") << "Effect '" << _plan.type << "' had trouble loading its settings: " << effectReader.getError();
+	}
+	
+	// check index
+	int tmpIndex = effect->getIndex();
+	while( std::find(effectIndexes.begin(), effectIndexes.end(), tmpIndex) != effectIndexes.end() ){
+		tmpIndex++;
+	}
+	if( tmpIndex != effect->getIndex() ) effect->setIndex(tmpIndex);
+	effectIndexes.push_back(tmpIndex);
+	
+	// bind with the new shapes
+	vector<string> failedShapes;
+	for(auto it=_plan.boundShapes.cbegin(); it!=_plan.boundShapes.cend(); ++it){
+		basicShape* tmpShape = stagingScene.getShapeByName( it->first );
+		
+		if(tmpShape != nullptr){
+			if( !effect->bindWithShape(tmpShape) ){
+				failedShapes.push_back( it->first + "(failed binding with " + it->second + ")" );
+			}
+		}
+		else {
+			failedShapes.push_back( it->first + "(" + it->second + " = not found)" );
+		}
+	}
+	
+	// todo: make this GUI message and show details
+	memoryUsage += effect->getMemoryEstimate();
+	
+	if(failedShapes.size() > 0) ofLogWarning("animationController::loadConfiguration") << " Effect '" << _plan.type << "' loaded but failed to bind with " << failedShapes.size() << " out of " << _plan.boundShapes.size() << " shapes... (ignoring, but re-saving the configuration will erase this information).";
+	
+	return true;
+}
+
+// main thread, between two frames
+void configurationLoader::swap(){
+	// nothing may be running on the old configuration
+	if( controller.bSimulationPending ){
+		controller.threadPool.wait( controller.simulationTask );
+		controller.bSimulationPending = false;
+	}
+	
+	controller.layers.swap( stagingLayers );
+	controller.scene.swapScene( stagingScene );
+	controller.governedEffects.clear();
+	
+	if( !plan.guiSettings.empty() ){
+		guiSettingsReader guiReader( *this );
+		karmaXmlReader reader;
+		reader.parse( plan.guiSettings.data(), plan.guiSettings.size(), guiReader );
+	}
+	
+	// modules come with the configuration, there are few of them
+	controller.unloadAllModules();
+	for(auto it=plan.modules.cbegin(); it!=plan.modules.cend(); ++it){
+		karmaModule* newModule = controller.tryLoadModule(it->type);
+		if ( newModule != nullptr) {
+			karmaXmlReader moduleReader;
+			if( !moduleReader.parse( it->source.data(), it->source.size(), *newModule ) ){
+				ofLogError("animationController::loadConfiguration") << "Module '" << it->type << "' failed loading its settings.";
+				numFailedModules++;
+			}
+			else {
+				newModule->enable();
+			}
+		}
+		else {
+			numFailedModules++;
+			// unknow effect type
+			ofLogError("module::create") << "Module type not found, or error while instantiating it: " << it->type;
+		}
+	}
+	if( plan.bHasModules ){
+		ofLogNotice("animationController::loadConfiguration") << "Loaded modules from " << file << " [" << plan.modules.size() << " modules] ( " << numFailedModules << "failed )";
+	}
+	
+	// the previous configuration now sits in stagingLayers and stagingScene, see retireNext()
+	
+	success = bSceneLoaded && numFailedEffects == 0 && numFailedModules == 0;
+	if( bSceneLoaded ){
+		controller.loadedConfiguration = file;
+		controller.scene.rememberLoadedScene();
+	}
+	
+	if( !success ){
+		ofLogError("animationController::loadConfiguration") << "There were errors loading the configuration file...";
+	}
+	else {
+		ofLogNotice("animationController::loadConfiguration") << "The config file was loaded !";
+		
+		ofxXmlSettings lastConfigXML;
+		lastConfigXML.setValue("lastLoadedConfiguration", file );
+		if(!lastConfigXML.saveFile(ofToDataPath(KM_LAST_CONFIG_FILE)) ){
+			ofLogWarning("animationController::loadConfiguration") << "Failed saving lastLoadedConfiguration... (continuing...)";
+		}
+	}
+}
+
+// main thread, deletes one effect of the replaced configuration per call
+// effects first, they're bound to the shapes. The shapes go in reset().
+bool configurationLoader::retireNext(){
+	while( stagingLayers.size() > 0 ){
+		list<basicEffect*>& effects = stagingLayers.back().second;
+		if( effects.size() > 0 ){
+			delete effects.back();
+			effects.pop_back();
+			return true;
+		}
+		stagingLayers.pop_back(); // hands its render target back to the pool
+	}
+	return false;
+}
+
+void configurationLoader::applyGuiSetting( const karmaXmlElement& _element ){
+	animationController& c = controller;
+	if( _element.is("bShowGui") ) c.bShowGui = _element.getValue( c.bShowGui );
+	else if( _element.is("bGuiShowMainWindow") ) c.bGuiShowMainWindow = _element.getValue( c.bGuiShowMainWindow );
+	else if( _element.is("bGuiShowAnimParams") ) c.bGuiShowAnimParams = _element.getValue( c.bGuiShowAnimParams );
+	else if( _element.is("bGuiShowPlugins") ) c.bGuiShowPlugins = _element.getValue( c.bGuiShowPlugins );
+	else if( _element.is("bGuiShowModules") ) c.bGuiShowModules = _element.getValue( c.bGuiShowModules );
+	else if( _element.is("bGuiShowConsole") ) c.bGuiShowConsole = _element.getValue( c.bGuiShowConsole );
+	else if( _element.is("bGuiShowProfiler") ) c.bGuiShowProfiler = _element.getValue( c.bGuiShowProfiler );
+	else if( _element.is("bGuiShowGovernor") ) c.bGuiShowGovernor = _element.getValue( c.bGuiShowGovernor );
+	else if( _element.is("bGuiShowRenderTargets") ) c.bGuiShowRenderTargets = _element.getValue( c.bGuiShowRenderTargets );
+	else if( _element.is("bFrameGovernor") ) c.frameGovernor.setEnabled( _element.getValue( c.frameGovernor.isEnabled() ) );
+	else if( _element.is("governorTargetFps") ) c.frameGovernor.setTargetFps( _element.getValue( c.frameGovernor.getTargetFps() ) );
+	else if( _element.is("bParallelEffectUpdates") ) c.bParallelEffectUpdates = _element.getValue( c.bParallelEffectUpdates );
+	else if( _element.is("bPipelinedUpdates") ) c.bPipelinedUpdates = _element.getValue( c.bPipelinedUpdates );
+	else if( _element.is("bCacheStaticLayers") ) c.bCacheStaticLayers = _element.getValue( c.bCacheStaticLayers );
+}
+
+// forgets (and deletes) anything staged
+void configurationLoader::reset(){
+	for(auto layer = stagingLayers.begin(); layer!=stagingLayers.end(); ++layer){
+		for(auto it = layer->second.rbegin(); it != layer->second.rend(); ++it){
+			delete (*it);
+		}
+	}
+	stagingLayers.clear();
+	stagingScene.unloadShapes();
+	
+	plan = configurationPlan();
+	success = false;
+	bSceneLoaded = false;
+	nextLayer = 0;
+	nextEffect = 0;
+	numStaged = 0;
+	numToStage = 0;
+	effectIndexes.clear();
+	numFailedEffects = 0;
+	numFailedLayerEffects = 0;
+	numFailedModules = 0;
+	
+	bStandby = false;
+	bDiscard = false;
+	bSwitchRequested = false;
+	bSwitchOnBeat = false;
+	bBeat = false;
+	memoryUsage = 0;
+}
@@ -0,0 +1,137 @@
+//
+//  configurationLoader.h
+//  karmaMapper
+//
+//	Loads configurations next to the running one, then swaps them in between two frames.
+//	A worker thread parses the file and loads its shapes into a staging shapesDB.
+//	Effects and modules need GL, they're created on the main thread, a few per frame (KM_CONFIG_LOADER_FRAME_BUDGET).
+//	Synchronous loads take the same path in one go.
+//	Preloads stage a configuration and hold it as a standby slot, it goes live in one frame when asked (optionally on a beat).
+//	The replaced configuration is deleted over the next frames.
+//
+
+#pragma once
+
+#include "ofMain.h"
+#include "KMSettings.h"
+#include "shapesDB.h"
+#include "karmaFboLayer.h"
+#include "karmaXml.h"
+#include "effects.h"
+#include "mirReceiver.h"
+#include <atomic>
+
+class animationController;
+
+// what a configuration file describes, parsed without touching the controller
+struct configurationPlan {
+	struct effectPlan {
+		string type;
+		string source; // the <effect> element
+		vector< pair<string, string> > boundShapes; // name, type
+	};
+	
+	struct layerPlan {
+		string name;
+		vector<effectPlan> effects;
+	};
+	
+	struct modulePlan {
+		string type;
+		string source; // the <module> element
+	};
+	
+	bool bHasSceneSettings = false;
+	string shapesFile;
+	string guiSettings; // the <guiSettings> element
+	bool bHasLayers = false;
+	bool bLegacyEffects = false; // old files without layers
+	bool bHasModules = false;
+	vector<layerPlan> layers;
+	vector<modulePlan> modules;
+};
+
+class configurationLoader {
+public:
+	configurationLoader( animationController& _controller );
+	~configurationLoader();
+	
+	// returns false if a background load is running already
+	// synchronous loads return their success, background loads return right away and report in the log
+	bool load( const string& _file, bool _inBackground );
+	
+	// main thread, start of the frame: stages effects and swaps the configuration once done
+	void update();
+	
+	bool isLoading() const;
+	float getProgress() const; // 0-1, staging
+	
+	// standby slot: loads in the background, then waits for switchToStandby()
+	// stops with an error if the staged configuration gets bigger than KM_STANDBY_MEMORY_BUDGET
+	// while another file is still being parsed, that one gets dropped and _file starts right after
+	bool preload( const string& _file );
+	// goes live at the start of the next frame, or of the first one after a mirReceiver tempo event
+	// can be requested while still preloading, it then switches once ready
+	bool switchToStandby( bool _onBeat );
+	void discard();
+	bool isReady() const;
+	bool isSwitchPending() const;
+	const string& getFile() const;
+	size_t getMemoryUsage() const; // bytes, estimated
+
+private:
+	configurationLoader(const configurationLoader&) = delete;
+	configurationLoader& operator=(const configurationLoader&) = delete;
+	
+	enum loaderState {
+		LOADER_IDLE = 0,
+		LOADER_PARSING, // worker
+		LOADER_STAGING, // main thread
+		LOADER_READY, // staged, waiting for the switch (standby)
+		LOADER_RETIRING, // deleting the previous configuration
+	};
+	
+	class guiSettingsReader;
+	
+	bool parse(); // any thread
+	bool stageNext(); // main thread, one effect per call. False when done.
+	bool stageEffect( const configurationPlan::effectPlan& _plan, list<basicEffect*>& _layerEffects );
+	void swap();
+	bool retireNext(); // main thread, one effect per call. False when done.
+	void applyGuiSetting( const karmaXmlElement& _element );
+	void reset();
+	
+	void tempoEventListener( mirTempoEventArgs& _args ); // OSC thread
+	
+	animationController& controller;
+	std::thread worker;
+	std::atomic<int> state;
+	std::atomic<bool> bParsed;
+	
+	// standby
+	bool bStandby;
+	bool bDiscard; // while parsing
+	string queuedFile; // preloaded once the discarded parse is done
+	bool bSwitchRequested;
+	std::atomic<bool> bSwitchOnBeat;
+	std::atomic<bool> bBeat;
+	size_t memoryUsage;
+	
+	// what's being loaded
+	string file;
+	bool success;
+	bool bSceneLoaded;
+	configurationPlan plan;
+	shapesDB stagingScene;
+	list< karmaFboLayer::fboWithEffects > stagingLayers;
+	
+	// staging cursor
+	unsigned int nextLayer;
+	unsigned int nextEffect;
+	unsigned int numStaged;
+	unsigned int numToStage;
+	vector<int> effectIndexes; // of the current layer
+	unsigned int numFailedLayerEffects;
+	unsigned int numFailedEffects;
+	unsigned int numFailedModules;
+};
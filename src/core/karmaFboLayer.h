@@ -5,6 +5,8 @@
 //  Created by Daan de Lange on 25/02/2016.
 //
 //	Render layer ready for ping-ponging & more. :)
+//	In the benchmark target no GL objects are created, calls are recorded instead (see karmaRenderRecorder.h)
+//	Its FBO comes from karmaRenderTargetPool, layers matching the window size follow it.
 //
 //	Freely inspired from code from
 //	https://github.com/openframeworks/openFrameworks/blob/master/apps/devApps/fboTester/src/demo4.h
@@ -13,6 +15,8 @@
 
 #include "ofMain.h"
 #include "basicEffect.h"
+#include "karmaRenderRecorder.h"
+#include "karmaRenderTargetPool.h"
 
 class karmaFboLayer {
 public:
@@ -25,7 +29,10 @@ public:
 	
 	karmaFboLayer(int _w, int _h){
 		layerName = "Untitled Layer";
+		profileLabel = "Composite " + layerName;
 		layerIndex = -1;
+		bCacheValid = false;
+		contentKey = 0;
 		allocate( _w, _h, GL_RGBA );
 #ifdef KM_LOG_INSTANCIATIONS
 		cout << "karmaFboLayer() " << ofToString(&*this) << endl;
@@ -48,9 +55,11 @@ public:
 		s.numSamples		= 0;// ? ofFbo::maxSamples() : 0;
 		s.internalformat	= _internalformat;
 		
-		fbo.allocate(s);
+		KM_RECORD_RENDER_CALL(layerAllocations, 1);
 		
-		maskFbo.allocate(_width, _height, GL_LUMINANCE); //or GL_RED if you are using the programmable renderer
+		// hand back the previous one first so it can be reused
+		fbo.reset();
+		fbo = karmaRenderTargetPool::getInstance().acquire( s, _width==ofGetWidth() && _height==ofGetHeight() );
 		
 //		for(int i = 0; i < 2; i++){
 //			frameBuffers[i].allocate(s);
@@ -60,6 +69,7 @@ public:
 		width = _width;
 		height = _height;
 		
+		invalidateCache();
 		clear();
 		
 		// Set everything to 0
@@ -71,8 +81,11 @@ public:
 	}
 	
 	void begin() {
+#ifdef KM_BENCHMARK_APP
+		KM_RECORD_RENDER_CALL(layerBinds, 1);
+#else
 		
-		fbo.begin();
+		fbo->begin();
         glDrawBuffer(GL_COLOR_ATTACHMENT0_EXT + ((switched?0:1)));	// write to this texture
         
         // alternatve method, but doesnt work on all GPUs
@@ -80,15 +93,18 @@ public:
 		
 		// tmp disabled
 		if(false && getMSAA()>0){
-			fbo.end();
-			fbo.updateTexture(switched?0:1);
-			fbo.begin();
+			fbo->end();
+			fbo->updateTexture(switched?0:1);
+			fbo->begin();
 		}
 		//cout << "drawing to fbo.texture: "<<(switched?0:1)<<" // " << fbo.getIdDrawBuffer()<<" // " << fbo.getId()<<endl;
+#endif
 	}
 	
 	void end(const bool& displayOutput=true){
-		fbo.end();
+#ifndef KM_BENCHMARK_APP
+		fbo->end();
+#endif
 		
 		if(displayOutput){
 			draw();
@@ -96,8 +112,12 @@ public:
 	}
 	
 	void draw(){
+#ifdef KM_BENCHMARK_APP
+		KM_RECORD_RENDER_CALL(layerComposites, 1);
+#else
 		glColor3f(1, 1, 1);
-		fbo.draw(0,0);
+		fbo->draw(0,0);
+#endif
 	}
 	
 	void swap(){
@@ -106,12 +126,17 @@ public:
 		switched = !switched;
 		//cout << "Switched: "<< switched << endl;
 		
+#ifdef KM_BENCHMARK_APP
+		KM_RECORD_RENDER_CALL(layerSwaps, 1);
+#else
+		
 		// clear new dest buffer
-		fbo.begin();
-		fbo.setActiveDrawBuffer(switched?0:1);
+		fbo->begin();
+		fbo->setActiveDrawBuffer(switched?0:1);
 		//glDrawBuffer(GL_COLOR_ATTACHMENT0_EXT + (switched?0:1));	// write to this texture
 		ofClear(0,0);
-		fbo.end();
+		fbo->end();
+#endif
 	}
 	
 	void resetSwap(){
@@ -119,14 +144,31 @@ public:
 		//cout << "reset" << endl;
 	}
 	
+	// static layer caching
+	// the controller gives a key summarizing everything the layer's content depends on.
+	// While it stays the same, the previous result is composited again without rendering.
+	bool isCached( uint64_t _contentKey ) const {
+		return bCacheValid && contentKey==_contentKey;
+	}
+	
+	void setCached( uint64_t _contentKey ){
+		contentKey = _contentKey;
+		bCacheValid = true;
+	}
+	
+	void invalidateCache(){
+		bCacheValid = false;
+	}
+	
 	void set(const string& _name, int _layerIndex){
 		layerName = _name;
 		layerIndex = _layerIndex;
+		profileLabel = "Composite " + _name;
 	}
 	
 	// tmp for debugging
 	ofFbo& getFBO(){
-		return fbo;
+		return *fbo;
 	}
 	
 	const int& getMSAA(){
@@ -137,6 +179,11 @@ public:
 		return layerName;
 	}
 	
+	// built once so profiling the composite doesn't allocate every frame
+	const char* getProfileLabel() const {
+		return profileLabel.c_str();
+	}
+	
 	const int& getIndex() const {
 		return layerIndex;
 	}
@@ -146,28 +193,53 @@ public:
 	}
 	
 	bool isAllocated() const {
-		return fbo.isAllocated();
+#ifdef KM_BENCHMARK_APP
+		return true;
+#else
+		return fbo && fbo->isAllocated();
+#endif
 	}
 	
 	ofTexture& getSrcTexture() {
-		return (fbo.getTexture(switched?0:1));
+#ifdef KM_BENCHMARK_APP
+		return getNullTexture();
+#else
+		return (fbo->getTexture(switched?0:1));
+#endif
 	}
 	
 	ofTexture& getDstTexture() {
 		//cout << "Dst = " << (switched?1:0) << endl;
-		return (fbo.getTexture(switched?1:0));
+#ifdef KM_BENCHMARK_APP
+		return getNullTexture();
+#else
+		return (fbo->getTexture(switched?1:0));
+#endif
 	}
 	
 	ofTexture& getSrcTextureIndex(int i) {
-		return (fbo.getTexture(i));
+#ifdef KM_BENCHMARK_APP
+		return getNullTexture();
+#else
+		return (fbo->getTexture(i));
+#endif
 	}
 	
+	// window-sized layers can get resized by the pool
 	int getHeight() const {
+#ifdef KM_BENCHMARK_APP
 		return height;
+#else
+		return fbo->getHeight();
+#endif
 	}
 	
 	int getWidth() const {
+#ifdef KM_BENCHMARK_APP
 		return width;
+#else
+		return fbo->getWidth();
+#endif
 	}
 	
 	void clear(int _alpha=255){
@@ -176,18 +248,20 @@ public:
 //			ofClear(0,_alpha);
 //			frameBuffers[i].end();
 //		}
-		fbo.begin();
+		invalidateCache();
+		
+#ifdef KM_BENCHMARK_APP
+		KM_RECORD_RENDER_CALL(layerClears, 1);
+#else
+		fbo->begin();
 		
 		glDrawBuffer(GL_COLOR_ATTACHMENT0_EXT + 1);	// write to this texture
 		ofClear(0,_alpha);
 		glDrawBuffer(GL_COLOR_ATTACHMENT0_EXT + 0);	// write to this texture
 		ofClear(0,_alpha);
 		
-		fbo.end();
-		
-		maskFbo.begin();
-		ofClear(0,_alpha);
-		maskFbo.end();
+		fbo->end();
+#endif
 	}
 	
 //	ofFbo& operator[]( int n ){
@@ -215,12 +289,22 @@ public:
 	static struct orderByIndexFunctor orderByIndex;
 	
 private:
-	// ensured to be deleted on destruction
+#ifdef KM_BENCHMARK_APP
+	// never allocated, drawing it is a no-op
+	static ofTexture& getNullTexture(){
+		static ofTexture nullTexture;
+		return nullTexture;
+	}
+#endif
+	
+	// returned to the pool on destruction (shared by copies)
 	//ofFbo frameBuffers[2];
-	ofFbo fbo;
-	ofFbo maskFbo;
+	shared_ptr<ofFbo> fbo;
 	bool switched;
+	bool bCacheValid;
+	uint64_t contentKey;
 	string layerName;
+	string profileLabel;
 	int layerIndex;
 	int height, width;
 	int MSAA;
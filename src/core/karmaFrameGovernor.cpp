@@ -0,0 +1,228 @@
+//
+//  karmaFrameGovernor.cpp
+//  karmaMapper
+//
+
+#include "karmaFrameGovernor.h"
+
+#define KM_GOVERNOR_SMOOTHING 0.1f // per frame weight of new measurements
+#define KM_GOVERNOR_OVERLOAD_RATIO 1.1f // slower than target * this = overloaded
+#define KM_GOVERNOR_UNDERLOAD_RATIO 0.6f // busy less than target * this = headroom
+#define KM_GOVERNOR_OVERLOAD_FRAMES 10 // sustained overload before degrading
+#define KM_GOVERNOR_UNDERLOAD_FRAMES 120 // sustained headroom before restoring
+#define KM_GOVERNOR_DEGRADE_COOLDOWN 30 // frames to wait for a change to show its effect
+#define KM_GOVERNOR_RESTORE_COOLDOWN 90
+
+// - - - - - - - -
+// CONSTRUCTORS
+// - - - - - - - -
+karmaFrameGovernor::karmaFrameGovernor(){
+	bEnabled = true;
+	bWasEnabled = true;
+	targetFps = 60;
+	averageFrameMillis = 0;
+	averageBusyMillis = 0;
+	overloadedFrames = 0;
+	underloadedFrames = 0;
+	coolDownFrames = 0;
+}
+
+// - - - - - - - -
+// SETTINGS
+// - - - - - - - -
+bool karmaFrameGovernor::isEnabled() const {
+	return bEnabled;
+}
+
+void karmaFrameGovernor::setEnabled( bool _enabled ){
+	bEnabled = _enabled;
+}
+
+float karmaFrameGovernor::getTargetFps() const {
+	return targetFps;
+}
+
+void karmaFrameGovernor::setTargetFps( float _fps ){
+	if( _fps < 1 ){
+		ofLogWarning("karmaFrameGovernor::setTargetFps") << "Invalid target fps (" << _fps << "), keeping " << targetFps;
+		return;
+	}
+	targetFps = _fps;
+	overloadedFrames = underloadedFrames = 0;
+}
+
+// - - - - - - - -
+// MEASUREMENTS
+// - - - - - - - -
+void karmaFrameGovernor::addEffectCost( basicEffect* _effect, uint64_t _micros ){
+	ofScopedLock lock(costMutex);
+	costs[_effect].frameMicros += _micros;
+}
+
+void karmaFrameGovernor::endFrame( float _frameMillis, float _busyMillis, const vector<basicEffect*>& _effects ){
+	
+	// smooth effect costs, forget removed effects
+	{
+		ofScopedLock lock(costMutex);
+		for(auto it=costs.begin(); it!=costs.end(); ){
+			if( std::find(_effects.begin(), _effects.end(), it->first) == _effects.end() ){
+				it = costs.erase(it);
+				continue;
+			}
+			it->second.averageMillis += ( it->second.frameMicros/1000.f - it->second.averageMillis )*KM_GOVERNOR_SMOOTHING;
+			it->second.frameMicros = 0;
+			++it;
+		}
+	}
+	
+	// forget effects which were removed or reset meanwhile,
+	// and levels their settings don't have anymore (see basicEffect::clampQualityLevel())
+	for(auto it=degraded.begin(); it!=degraded.end(); ){
+		if( std::find(_effects.begin(), _effects.end(), *it) == _effects.end() || (unsigned int) std::count(degraded.begin(), it+1, *it) > (*it)->getQualityLevel() ){
+			it = degraded.erase(it);
+		}
+		else ++it;
+	}
+	
+	// just disabled
+	if( !bEnabled ){
+		if( bWasEnabled ) restoreQuality( _effects );
+		bWasEnabled = false;
+		return;
+	}
+	bWasEnabled = true;
+	
+	averageFrameMillis += (_frameMillis - averageFrameMillis)*KM_GOVERNOR_SMOOTHING;
+	averageBusyMillis += (_busyMillis - averageBusyMillis)*KM_GOVERNOR_SMOOTHING;
+	
+	if( coolDownFrames > 0 ){
+		coolDownFrames--;
+		return;
+	}
+	
+	float targetMillis = 1000.f/targetFps;
+	
+	if( averageFrameMillis > targetMillis*KM_GOVERNOR_OVERLOAD_RATIO ){
+		underloadedFrames = 0;
+		if( ++overloadedFrames >= KM_GOVERNOR_OVERLOAD_FRAMES ){
+			overloadedFrames = 0;
+			if( degradeOne( _effects ) ) coolDownFrames = KM_GOVERNOR_DEGRADE_COOLDOWN;
+		}
+	}
+	else if( averageBusyMillis < targetMillis*KM_GOVERNOR_UNDERLOAD_RATIO ){
+		overloadedFrames = 0;
+		if( ++underloadedFrames >= KM_GOVERNOR_UNDERLOAD_FRAMES ){
+			underloadedFrames = 0;
+			if( restoreOne() ) coolDownFrames = KM_GOVERNOR_RESTORE_COOLDOWN;
+		}
+	}
+	else {
+		overloadedFrames = 0;
+		underloadedFrames = 0;
+	}
+}
+
+void karmaFrameGovernor::restoreQuality( const vector<basicEffect*>& _effects ){
+	for(auto it=_effects.begin(); it!=_effects.end(); ++it){
+		if( (*it)->getQualityLevel() > 0 ) (*it)->setQualityLevel(0);
+	}
+	degraded.clear();
+	overloadedFrames = underloadedFrames = coolDownFrames = 0;
+}
+
+unsigned int karmaFrameGovernor::getNumDegradedEffects() const {
+	return degraded.size();
+}
+
+// - - - - - - - -
+// QUALITY CHANGES
+// - - - - - - - -
+// lowers the quality of the most expensive effect which can still go lower
+bool karmaFrameGovernor::degradeOne( const vector<basicEffect*>& _effects ){
+	basicEffect* target = nullptr;
+	float targetCost = -1;
+	
+	ofScopedLock lock(costMutex);
+	for(auto it=_effects.begin(); it!=_effects.end(); ++it){
+		if( !(*it)->isReady() || (*it)->getQualityLevel() >= (*it)->getMaxQualityLevel() ) continue;
+		
+		auto cost = costs.find(*it);
+		float c = (cost!=costs.end()) ? cost->second.averageMillis : 0;
+		if( c > targetCost ){
+			target = *it;
+			targetCost = c;
+		}
+	}
+	
+	if( target == nullptr ) return false;
+	
+	target->setQualityLevel( target->getQualityLevel()+1 );
+	degraded.push_back( target );
+	ofLogVerbose("karmaFrameGovernor::degradeOne") << "Frames too slow (" << averageFrameMillis << "ms), lowered " << target->getName() << " to quality level " << target->getQualityLevel();
+	
+	return true;
+}
+
+// gives back one quality level to the last degraded effect
+bool karmaFrameGovernor::restoreOne(){
+	if( degraded.size()==0 ) return false;
+	
+	basicEffect* target = degraded.back();
+	degraded.pop_back();
+	target->setQualityLevel( target->getQualityLevel()-1 );
+	ofLogVerbose("karmaFrameGovernor::restoreOne") << "Enough headroom (" << averageBusyMillis << "ms busy), raised " << target->getName() << " to quality level " << target->getQualityLevel();
+	
+	return true;
+}
+
+// - - - - - - - -
+// GUI
+// - - - - - - - -
+void karmaFrameGovernor::drawImGui( const string& _title, bool& _show, const vector<basicEffect*>& _effects ){
+	ImGui::SetNextWindowSize(ImVec2(380,300), ImGuiSetCond_FirstUseEver);
+	if (!ImGui::Begin(_title.c_str(), &_show)){
+		ImGui::End();
+		return;
+	}
+	
+	ImGui::Checkbox("Enabled", &bEnabled);
+	ImGui::SameLine();
+	if( ImGui::Button("Restore full quality") ){
+		restoreQuality( _effects );
+	}
+	
+	if( ImGui::SliderFloat("Target FPS", &targetFps, 10, 120, "%.0f") ){
+		setTargetFps( targetFps );
+	}
+	
+	// global shape level of detail
+	float lodError = shapeGeometryLibrary::getInstance().getLodMaxError();
+	if( ImGui::SliderFloat("Shape simplification", &lodError, 0, 8, "%.1f px") ){
+		shapeGeometryLibrary::getInstance().setLodMaxError( lodError );
+	}
+	
+	ImGui::Text("Frame: %.2fms (target %.2fms) - Busy: %.2fms", averageFrameMillis, 1000.f/targetFps, averageBusyMillis );
+	ImGui::Text("%i effect(s) degraded", (int)degraded.size() );
+	
+	ImGui::Separator();
+	
+	ImGui::Columns(3);
+	ImGui::Text("Effect"); ImGui::NextColumn();
+	ImGui::Text("Cost (ms)"); ImGui::NextColumn();
+	ImGui::Text("Quality level"); ImGui::NextColumn();
+	ImGui::Separator();
+	
+	ofScopedLock lock(costMutex);
+	for(auto it=_effects.begin(); it!=_effects.end(); ++it){
+		auto cost = costs.find(*it);
+		
+		ImGui::Text("%s", (*it)->getName().c_str() ); ImGui::NextColumn();
+		ImGui::Text("%.3f", (cost!=costs.end()) ? cost->second.averageMillis : 0.f ); ImGui::NextColumn();
+		if( (*it)->getMaxQualityLevel() > 0 ) ImGui::Text("%u / %u", (*it)->getQualityLevel(), (*it)->getMaxQualityLevel() );
+		else ImGui::TextDisabled("fixed");
+		ImGui::NextColumn();
+	}
+	ImGui::Columns(1);
+	
+	ImGui::End();
+}
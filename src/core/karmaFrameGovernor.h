@@ -0,0 +1,65 @@
+//
+//  karmaFrameGovernor.h
+//  karmaMapper
+//
+//	Adaptive quality: holds a target frame rate by lowering the quality level of the most expensive effects when frames get too slow, and restoring them when there's headroom again.
+//	Hysteresis (sustained over/under load + cool down after each change) prevents quality from flickering.
+//	Effect costs are measured on the CPU (update + render calls), GPU load only shows up in the frame time.
+//
+
+#pragma once
+
+#include "ofMain.h"
+#include "ofxImGui.h"
+#include "basicEffect.h"
+
+class karmaFrameGovernor {
+public:
+	karmaFrameGovernor();
+	
+	bool isEnabled() const;
+	void setEnabled( bool _enabled ); // disabling restores full quality on the next endFrame()
+	float getTargetFps() const;
+	void setTargetFps( float _fps );
+	
+	// accumulates the time spent in an effect this frame. Thread safe.
+	void addEffectCost( basicEffect* _effect, uint64_t _micros );
+	
+	// call once per frame (main thread) after everything rendered
+	// _frameMillis: real frame period, _busyMillis: time spent updating and rendering
+	void endFrame( float _frameMillis, float _busyMillis, const vector<basicEffect*>& _effects );
+	
+	// puts all effects back to full quality
+	void restoreQuality( const vector<basicEffect*>& _effects );
+	
+	unsigned int getNumDegradedEffects() const;
+	void drawImGui( const string& _title, bool& _show, const vector<basicEffect*>& _effects );
+
+private:
+	bool degradeOne( const vector<basicEffect*>& _effects );
+	bool restoreOne();
+	
+	struct effectCost {
+		uint64_t frameMicros = 0; // accumulating for the current frame
+		float averageMillis = 0; // smoothed
+	};
+	
+	bool bEnabled;
+	bool bWasEnabled;
+	float targetFps;
+	
+	ofMutex costMutex;
+	map<basicEffect*, effectCost> costs;
+	
+	// most recently degraded last, restored first
+	vector<basicEffect*> degraded;
+	
+	float averageFrameMillis;
+	float averageBusyMillis;
+	unsigned int overloadedFrames;
+	unsigned int underloadedFrames;
+	unsigned int coolDownFrames;
+};
+
+#define GUIGovernorPanel "Adaptive Quality"
+#define GUIToggleGovernor "Show Adaptive Quality"
@@ -0,0 +1,108 @@
+//
+//  karmaMappedFile.cpp
+//  karmaMapper
+//
+
+#include "karmaMappedFile.h"
+
+#ifdef TARGET_WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// - - - - - - - -
+// CONSTRUCTORS
+// - - - - - - - -
+karmaMappedFile::karmaMappedFile() : data(nullptr), size(0) {
+#ifdef TARGET_WIN32
+	fileHandle = INVALID_HANDLE_VALUE;
+	mappingHandle = NULL;
+#endif
+}
+
+karmaMappedFile::~karmaMappedFile(){
+	close();
+}
+
+// - - - - - - - -
+// MAPPING
+// - - - - - - - -
+bool karmaMappedFile::open( const string& _path ){
+	close();
+	string path = ofToDataPath( _path, true );
+
+#ifdef TARGET_WIN32
+	HANDLE file = CreateFileA( path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL );
+	if( file == INVALID_HANDLE_VALUE ){
+		ofLogError("karmaMappedFile::open") << "Could not open " << path;
+		return false;
+	}
+	
+	LARGE_INTEGER fileSize;
+	if( !GetFileSizeEx( file, &fileSize ) || fileSize.QuadPart == 0 ){
+		ofLogError("karmaMappedFile::open") << "Empty or unreadable file: " << path;
+		CloseHandle( file );
+		return false;
+	}
+	
+	HANDLE mapping = CreateFileMappingA( file, NULL, PAGE_READONLY, 0, 0, NULL );
+	const void* view = (mapping==NULL) ? NULL : MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+	if( view == NULL ){
+		ofLogError("karmaMappedFile::open") << "Could not map " << path;
+		if( mapping != NULL ) CloseHandle( mapping );
+		CloseHandle( file );
+		return false;
+	}
+	
+	fileHandle = file;
+	mappingHandle = mapping;
+	data = (const unsigned char*)view;
+	size = (size_t)fileSize.QuadPart;
+#else
+	int fd = ::open( path.c_str(), O_RDONLY );
+	if( fd < 0 ){
+		ofLogError("karmaMappedFile::open") << "Could not open " << path;
+		return false;
+	}
+	
+	struct stat info;
+	if( fstat( fd, &info ) != 0 || info.st_size == 0 ){
+		ofLogError("karmaMappedFile::open") << "Empty or unreadable file: " << path;
+		::close( fd );
+		return false;
+	}
+	
+	void* view = mmap( NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+	::close( fd ); // the mapping keeps its own reference
+	if( view == MAP_FAILED ){
+		ofLogError("karmaMappedFile::open") << "Could not map " << path;
+		return false;
+	}
+	
+	data = (const unsigned char*)view;
+	size = info.st_size;
+#endif
+	
+	return true;
+}
+
+void karmaMappedFile::close(){
+	if( data == nullptr ) return;
+
+#ifdef TARGET_WIN32
+	UnmapViewOfFile( data );
+	CloseHandle( (HANDLE)mappingHandle );
+	CloseHandle( (HANDLE)fileHandle );
+	fileHandle = INVALID_HANDLE_VALUE;
+	mappingHandle = NULL;
+#else
+	munmap( (void*)data, size );
+#endif
+	
+	data = nullptr;
+	size = 0;
+}
@@ -0,0 +1,35 @@
+//
+//  karmaMappedFile.h
+//  karmaMapper
+//
+//	Read-only memory mapped file. The OS pages the data in when it's touched, nothing is copied.
+//
+
+#pragma once
+
+#include "ofMain.h"
+
+class karmaMappedFile {
+public:
+	karmaMappedFile();
+	~karmaMappedFile();
+	
+	// _path is absolute or relative to the data folder
+	bool open( const string& _path );
+	void close();
+	
+	bool isOpen() const { return data != nullptr; }
+	const unsigned char* getData() const { return data; }
+	size_t getSize() const { return size; }
+
+private:
+	karmaMappedFile(const karmaMappedFile&) = delete;
+	karmaMappedFile& operator=(const karmaMappedFile&) = delete;
+	
+	const unsigned char* data;
+	size_t size;
+#ifdef TARGET_WIN32
+	void* fileHandle;
+	void* mappingHandle;
+#endif
+};
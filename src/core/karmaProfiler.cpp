@@ -0,0 +1,315 @@
+//
+//  karmaProfiler.cpp
+//  karmaMapper
+//
+//
+
+#include "karmaProfiler.h"
+
+thread_local unsigned int karmaProfilerScope::currentDepth = 0;
+
+// - - - - - - - -
+// CONSTRUCTORS
+// - - - - - - - -
+karmaProfiler::karmaProfiler() : frames( new karmaProfilerFrame[KM_PROFILER_NUM_FRAMES] ) {
+	recordingFrame = 0;
+	bEnabled = true;
+	bRecording = false;
+	epoch = std::chrono::high_resolution_clock::now();
+	guiSelectedAge = 0;
+
+	for(unsigned int i=0; i<KM_PROFILER_NUM_FRAMES; ++i){
+		frames[i].frameNum = 0;
+		frames[i].start = 0;
+		frames[i].duration = 0;
+		frames[i].numSamples = 0;
+	}
+}
+
+karmaProfiler& karmaProfiler::getInstance(){
+	static karmaProfiler instance;
+	return instance;
+}
+
+// - - - - - - - -
+// RECORDING
+// - - - - - - - -
+void karmaProfiler::beginFrame(){
+	if( !bEnabled ){
+		bRecording = false;
+		return;
+	}
+
+	karmaProfilerFrame& frame = frames[ recordingFrame.load() % KM_PROFILER_NUM_FRAMES ];
+	frame.numSamples.store(0, std::memory_order_relaxed);
+	frame.frameNum = ofGetFrameNum();
+	frame.start = getTimeMicros();
+	frame.duration = 0;
+
+	bRecording.store(true, std::memory_order_release);
+}
+
+void karmaProfiler::endFrame(){
+	if( !bRecording ) return;
+
+	karmaProfilerFrame& frame = frames[ recordingFrame.load() % KM_PROFILER_NUM_FRAMES ];
+	frame.duration = getTimeMicros() - frame.start;
+
+	bRecording.store(false, std::memory_order_release);
+	recordingFrame.fetch_add(1, std::memory_order_acq_rel);
+}
+
+void karmaProfiler::addSample(const char* _name, const uint64_t& _start, const uint64_t& _end, const unsigned int& _depth){
+	if( !bRecording.load(std::memory_order_acquire) ) return;
+
+	karmaProfilerFrame& frame = frames[ recordingFrame.load(std::memory_order_acquire) % KM_PROFILER_NUM_FRAMES ];
+
+	// reserve a slot, drop samples on overflow
+	uint32_t slot = frame.numSamples.fetch_add(1, std::memory_order_relaxed);
+	if( slot >= KM_PROFILER_MAX_SAMPLES ) return;
+
+	karmaProfilerSample& sample = frame.samples[slot];
+	std::strncpy(sample.name, _name, KM_PROFILER_NAME_LENGTH-1);
+	sample.name[KM_PROFILER_NAME_LENGTH-1] = '\0';
+	sample.start = _start;
+	sample.duration = (_end>_start)?(_end-_start):0;
+	sample.depth = _depth;
+	sample.thread = getThreadIndex();
+}
+
+uint64_t karmaProfiler::getTimeMicros() const {
+	return std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::high_resolution_clock::now() - epoch ).count();
+}
+
+uint16_t karmaProfiler::getThreadIndex(){
+	static std::atomic<uint16_t> numThreads(0);
+	static thread_local uint16_t threadIndex = numThreads.fetch_add(1);
+	return threadIndex;
+}
+
+bool karmaProfiler::isEnabled() const {
+	return bEnabled;
+}
+
+void karmaProfiler::setEnabled(const bool& _enabled){
+	bEnabled = _enabled;
+}
+
+// - - - - - - - -
+// GETTERS
+// - - - - - - - -
+// _age 0 = last completed frame
+const karmaProfilerFrame* karmaProfiler::getCompletedFrame( unsigned int _age ) const {
+	uint64_t recorded = recordingFrame.load(std::memory_order_acquire);
+
+	// the last slot is reserved for the frame being recorded
+	if( _age+1 > recorded || _age >= KM_PROFILER_NUM_FRAMES-1 ) return nullptr;
+
+	return &frames[ (recorded-1-_age) % KM_PROFILER_NUM_FRAMES ];
+}
+
+float karmaProfiler::getLastFrameMillis() const {
+	const karmaProfilerFrame* frame = getCompletedFrame(0);
+	return (frame==nullptr)?0.f:(frame->duration/1000.f);
+}
+
+float karmaProfiler::getAverageFrameMillis( unsigned int _numFrames ) const {
+	float total = 0.f;
+	unsigned int count = 0;
+	for(unsigned int i=0; i<_numFrames; ++i){
+		const karmaProfilerFrame* frame = getCompletedFrame(i);
+		if(frame==nullptr) break;
+		total += frame->duration;
+		++count;
+	}
+	return (count==0)?0.f:(total/count/1000.f);
+}
+
+// - - - - - - - -
+// CHROME TRACE EXPORT
+// - - - - - - - -
+static void writeJSONString(ofstream& _out, const char* _str){
+	_out << '"';
+	for(const char* c=_str; *c!='\0'; ++c){
+		if(*c=='"' || *c=='\\') _out << '\\' << *c;
+		else if( (unsigned char)(*c) < 0x20 ) _out << ' ';
+		else _out << *c;
+	}
+	_out << '"';
+}
+
+// Load the resulting file in chrome://tracing
+bool karmaProfiler::exportChromeTrace(const string& _file, unsigned int _numFrames ) const {
+
+	ofFilePath::createEnclosingDirectory(_file);
+	ofstream out( ofToDataPath(_file).c_str(), std::ios::out | std::ios::trunc );
+	if( !out.is_open() ){
+		ofLogError("karmaProfiler::exportChromeTrace") << "Could not open " << _file << " for writing.";
+		return false;
+	}
+
+	out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	bool first = true;
+	unsigned int numExported = 0;
+
+	// oldest first
+	for(int age=std::min<int>(_numFrames, KM_PROFILER_NUM_FRAMES)-1; age>=0; --age){
+		const karmaProfilerFrame* frame = getCompletedFrame(age);
+		if(frame==nullptr) continue;
+
+		string frameName = "Frame " + ofToString(frame->frameNum);
+		out << (first?"":",") << "{\"name\":";
+		writeJSONString(out, frameName.c_str());
+		out << ",\"cat\":\"frame\",\"ph\":\"X\",\"pid\":1,\"tid\":0,\"ts\":" << frame->start << ",\"dur\":" << frame->duration << "}";
+		first = false;
+
+		uint32_t numSamples = std::min<uint32_t>(frame->numSamples.load(), KM_PROFILER_MAX_SAMPLES);
+		for(uint32_t s=0; s<numSamples; ++s){
+			const karmaProfilerSample& sample = frame->samples[s];
+			out << ",{\"name\":";
+			writeJSONString(out, sample.name);
+			out << ",\"cat\":\"karmaMapper\",\"ph\":\"X\",\"pid\":1,\"tid\":" << (sample.thread+1) << ",\"ts\":" << sample.start << ",\"dur\":" << sample.duration << "}";
+		}
+		++numExported;
+	}
+	out << "]}";
+	out.close();
+
+	ofLogNotice("karmaProfiler::exportChromeTrace") << "Exported " << numExported << " frames to " << _file;
+	return true;
+}
+
+// - - - - - - - -
+// GUI
+// - - - - - - - -
+static bool orderSamplesForDisplay(const karmaProfilerSample* a, const karmaProfilerSample* b){
+	if(a->thread != b->thread) return a->thread < b->thread;
+	if(a->start != b->start) return a->start < b->start;
+	return a->depth < b->depth;
+}
+
+void karmaProfiler::drawImGui(const string& _title, bool& _show){
+	ImGui::SetNextWindowSize(ImVec2(450,500), ImGuiSetCond_FirstUseEver);
+	if (!ImGui::Begin(_title.c_str(), &_show)){
+		ImGui::End();
+		return;
+	}
+
+	bool enabled = isEnabled();
+	if( ImGui::Checkbox("Record", &enabled) ){
+		setEnabled(enabled);
+		if(enabled) guiSelectedAge = 0;
+	}
+	ImGui::SameLine();
+	if( ImGui::Button("Export Chrome trace") ){
+		exportChromeTrace( "profiler/karmaProfiler-" + ofGetTimestampString() + ".json" );
+	}
+
+	ImGui::Text("Last frame: %.2f ms    Average: %.2f ms", getLastFrameMillis(), getAverageFrameMillis() );
+
+	// frame history (oldest left)
+	static float frameTimes[KM_PROFILER_NUM_FRAMES];
+	unsigned int numFrames = 0;
+	float maxTime = 1000.f/60.f;
+	for(int age=KM_PROFILER_NUM_FRAMES-2; age>=0; --age){
+		const karmaProfilerFrame* frame = getCompletedFrame(age);
+		if(frame==nullptr) continue;
+		frameTimes[numFrames] = frame->duration/1000.f;
+		maxTime = MAX(maxTime, frameTimes[numFrames]);
+		++numFrames;
+	}
+	ImGui::PlotHistogram("", frameTimes, numFrames, 0, "Frame times (ms)", 0.f, maxTime, ImVec2(ImGui::GetContentRegionAvailWidth(), 80));
+	if( numFrames>0 && ImGui::IsItemHovered() ){
+		float relX = (ImGui::GetMousePos().x - ImGui::GetItemRectMin().x) / MAX(1.f, ImGui::GetItemRectSize().x);
+		unsigned int hovered = ofClamp(relX*numFrames, 0, numFrames-1);
+		ImGui::SetTooltip("%.2f ms", frameTimes[hovered]);
+
+		// select a frame, pause recording to keep it around
+		if( ImGui::IsMouseClicked(0) ){
+			guiSelectedAge = numFrames-1-hovered;
+			setEnabled(false);
+		}
+	}
+	if( isEnabled() ) guiSelectedAge = 0;
+
+	const karmaProfilerFrame* frame = getCompletedFrame(guiSelectedAge);
+	if( frame==nullptr ){
+		ImGui::TextWrapped("No frames recorded yet.");
+		ImGui::End();
+		return;
+	}
+
+	uint32_t numSamples = std::min<uint32_t>(frame->numSamples.load(), KM_PROFILER_MAX_SAMPLES);
+	ImGui::Separator();
+	ImGui::Text("Frame %llu : %.2f ms, %u samples%s", (unsigned long long)frame->frameNum, frame->duration/1000.f, numSamples, (frame->numSamples.load()>KM_PROFILER_MAX_SAMPLES)?" (truncated)":"" );
+
+	// samples are recorded when scopes close, sort them back in call order
+	static vector<const karmaProfilerSample*> sorted;
+	sorted.clear();
+	for(uint32_t s=0; s<numSamples; ++s){
+		sorted.push_back( &frame->samples[s] );
+	}
+	std::sort(sorted.begin(), sorted.end(), orderSamplesForDisplay);
+
+	ImGui::BeginChild("profilerSamples");
+	ImGui::Columns(3);
+	ImGui::Text("Scope"); ImGui::NextColumn();
+	ImGui::Text("ms"); ImGui::NextColumn();
+	ImGui::Text("%% frame"); ImGui::NextColumn();
+	ImGui::Separator();
+
+	int curThread = -1;
+	for(auto it=sorted.cbegin(); it!=sorted.cend(); ++it){
+		const karmaProfilerSample& s = **it;
+		if( s.thread != curThread ){
+			curThread = s.thread;
+			ImGui::TextDisabled("Thread %i", curThread);
+			ImGui::NextColumn(); ImGui::NextColumn(); ImGui::NextColumn();
+		}
+		ImGui::Text("%*s%s", s.depth*2, "", s.name);
+		ImGui::NextColumn();
+		ImGui::Text("%.3f", s.duration/1000.f);
+		ImGui::NextColumn();
+		ImGui::Text("%.1f", (frame->duration>0)?(100.f*s.duration/frame->duration):0.f);
+		ImGui::NextColumn();
+	}
+	ImGui::Columns(1);
+	ImGui::EndChild();
+
+	ImGui::End();
+}
+
+// - - - - - - - -
+// SCOPED TIMER
+// - - - - - - - -
+karmaProfilerScope::karmaProfilerScope(const char* _name){
+	start(_name);
+}
+
+karmaProfilerScope::karmaProfilerScope(const string& _name){
+	start(_name.c_str());
+}
+
+void karmaProfilerScope::start(const char* _name){
+	karmaProfiler& profiler = karmaProfiler::getInstance();
+	bActive = profiler.isEnabled();
+	if( !bActive ) return;
+
+	std::strncpy(name, _name, KM_PROFILER_NAME_LENGTH-1);
+	name[KM_PROFILER_NAME_LENGTH-1] = '\0';
+	depth = currentDepth++;
+	startTime = profiler.getTimeMicros();
+}
+
+karmaProfilerScope::~karmaProfilerScope(){
+	stop();
+}
+
+void karmaProfilerScope::stop(){
+	if( !bActive ) return;
+
+	karmaProfiler& profiler = karmaProfiler::getInstance();
+	profiler.addSample(name, startTime, profiler.getTimeMicros(), depth);
+	--currentDepth;
+	bActive = false;
+}
@@ -0,0 +1,113 @@
+//
+//  karmaProfiler.h
+//  karmaMapper
+//
+//	Per-frame hierarchical CPU profiler.
+//	Scoped timers write their samples into a ring buffer of recent frames (lock-free).
+//	Frames can be inspected in an ImGui panel or exported to chrome://tracing (JSON).
+//
+
+#pragma once
+
+#include "ofMain.h"
+#include "ofxImGui.h"
+#include "KMSettings.h"
+#include <atomic>
+#include <chrono>
+
+#define KM_PROFILER_NUM_FRAMES 128
+#define KM_PROFILER_MAX_SAMPLES 512
+#define KM_PROFILER_NAME_LENGTH 40
+
+struct karmaProfilerSample {
+	char name[KM_PROFILER_NAME_LENGTH];
+	uint64_t start; // micros since profiler creation
+	uint32_t duration; // micros
+	uint16_t depth; // nesting level within its thread
+	uint16_t thread; // small thread identifier
+};
+
+struct karmaProfilerFrame {
+	uint64_t frameNum;
+	uint64_t start;
+	uint32_t duration;
+	std::atomic<uint32_t> numSamples;
+	karmaProfilerSample samples[KM_PROFILER_MAX_SAMPLES];
+};
+
+class karmaProfiler {
+public:
+	static karmaProfiler& getInstance();
+
+	// frame boundaries (main thread only)
+	void beginFrame();
+	void endFrame();
+
+	// can be called from any thread while a frame is recording
+	void addSample(const char* _name, const uint64_t& _start, const uint64_t& _end, const unsigned int& _depth);
+	uint64_t getTimeMicros() const;
+	static uint16_t getThreadIndex();
+
+	bool isEnabled() const;
+	void setEnabled(const bool& _enabled);
+
+	// stats on completed frames
+	float getLastFrameMillis() const;
+	float getAverageFrameMillis( unsigned int _numFrames = 60 ) const;
+
+	bool exportChromeTrace(const string& _file, unsigned int _numFrames = KM_PROFILER_NUM_FRAMES ) const;
+	void drawImGui(const string& _title, bool& _show);
+
+private:
+	karmaProfiler();
+	karmaProfiler(const karmaProfiler&) = delete;
+	karmaProfiler& operator=(const karmaProfiler&) = delete;
+
+	const karmaProfilerFrame* getCompletedFrame( unsigned int _age ) const;
+
+	std::unique_ptr<karmaProfilerFrame[]> frames;
+	std::atomic<uint64_t> recordingFrame; // slot = recordingFrame % KM_PROFILER_NUM_FRAMES
+	std::atomic<bool> bEnabled;
+	std::atomic<bool> bRecording;
+	std::chrono::high_resolution_clock::time_point epoch;
+
+	// gui state
+	unsigned int guiSelectedAge;
+};
+
+// RAII timer, records a sample when going out of scope
+class karmaProfilerScope {
+public:
+	karmaProfilerScope(const char* _name);
+	karmaProfilerScope(const string& _name);
+	~karmaProfilerScope();
+
+	// ends the scope early
+	void stop();
+
+private:
+	void start(const char* _name);
+
+	char name[KM_PROFILER_NAME_LENGTH];
+	uint64_t startTime;
+	unsigned int depth;
+	bool bActive;
+
+	static thread_local unsigned int currentDepth;
+};
+
+#define KM_PROFILE_CONCAT_INNER(a, b) a ## b
+#define KM_PROFILE_CONCAT(a, b) KM_PROFILE_CONCAT_INNER(a, b)
+
+#ifdef KM_ENABLE_PROFILER
+	#define KM_PROFILE_SCOPE(_name) karmaProfilerScope KM_PROFILE_CONCAT(kmProfilerScope, __LINE__)(_name)
+	#define KM_PROFILE_BEGIN(_var, _name) karmaProfilerScope _var(_name)
+	#define KM_PROFILE_END(_var) _var.stop()
+#else
+	#define KM_PROFILE_SCOPE(_name)
+	#define KM_PROFILE_BEGIN(_var, _name)
+	#define KM_PROFILE_END(_var)
+#endif
+
+#define GUIProfilerPanel "Profiler"
+#define GUIToggleProfiler "Show Profiler"
@@ -0,0 +1,70 @@
+//
+//  karmaRandom.h
+//  karmaMapper
+//
+//	Small seedable random stream (PCG32). Each effect owns one so its output only depends on its seed.
+//	Unlike ofRandom(), the sequence is the same on every platform and it doesn't share state between threads.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+class karmaRandom {
+public:
+	karmaRandom( uint64_t _seed = 1, uint64_t _stream = 0 ){
+		seed(_seed, _stream);
+	}
+	
+	void seed( uint64_t _seed, uint64_t _stream = 0 ){
+		state = 0u;
+		increment = (_stream << 1u) | 1u;
+		next();
+		state += _seed;
+		next();
+	}
+	
+	uint32_t next(){
+		uint64_t old = state;
+		state = old * 6364136223846793005ULL + increment;
+		uint32_t xorShifted = (uint32_t)( ((old >> 18u) ^ old) >> 27u );
+		uint32_t rot = (uint32_t)( old >> 59u );
+		return (xorShifted >> rot) | (xorShifted << ((-rot) & 31));
+	}
+	
+	// [0,1)
+	float getFloat(){
+		return (next() >> 8) * (1.f / 16777216.f);
+	}
+	
+	// [0,_max), like ofRandom(max)
+	float operator()( float _max ){
+		return getFloat() * _max;
+	}
+	
+	// [_min,_max), like ofRandom(min, max)
+	float getRange( float _min, float _max ){
+		return _min + getFloat() * (_max-_min);
+	}
+	
+	// [0,_size), for picking a random item
+	unsigned int getIndex( unsigned int _size ){
+		if( _size == 0 ) return 0;
+		return (unsigned int)( ((uint64_t)next() * _size) >> 32 );
+	}
+	
+	// stable string hash (FNV-1a), to derive seeds from names
+	static uint64_t hash( const std::string& _str ){
+		uint64_t h = 14695981039346656037ULL;
+		for(auto it=_str.begin(); it!=_str.end(); ++it){
+			h ^= (unsigned char)(*it);
+			h *= 1099511628211ULL;
+		}
+		return h;
+	}
+
+private:
+	uint64_t state;
+	uint64_t increment;
+};
@@ -0,0 +1,46 @@
+//
+//  karmaRenderRecorder.h
+//  karmaMapper
+//
+//	Null render backend used by the benchmark target.
+//	Instead of talking to the GPU, karmaMapper's draw entry points (layers, shapes) count what they would have sent.
+//	In other targets the recording macro compiles to nothing.
+//
+
+#pragma once
+
+#include "KMSettings.h"
+#include <cstdint>
+
+struct karmaRecordedCalls {
+	uint64_t shapeDraws = 0;
+	uint64_t vertices = 0;
+	uint64_t layerAllocations = 0;
+	uint64_t layerBinds = 0;
+	uint64_t layerSwaps = 0;
+	uint64_t layerClears = 0;
+	uint64_t layerComposites = 0;
+	uint64_t layerCacheHits = 0; // layers composited without re-rendering
+	uint64_t renderTargetAllocations = 0; // pooled FBOs created or re-allocated
+	uint64_t batchDraws = 0; // batched shape draws (one per effect)
+	uint64_t batchUploadedBytes = 0; // scene vertex buffer uploads
+	
+	void reset(){
+		*this = karmaRecordedCalls();
+	}
+};
+
+class karmaRenderRecorder {
+public:
+	// rendering happens on the main thread, no need for atomics
+	static karmaRecordedCalls& get(){
+		static karmaRecordedCalls calls;
+		return calls;
+	}
+};
+
+#ifdef KM_BENCHMARK_APP
+	#define KM_RECORD_RENDER_CALL(_field, _count) karmaRenderRecorder::get()._field += (_count)
+#else
+	#define KM_RECORD_RENDER_CALL(_field, _count)
+#endif
@@ -0,0 +1,264 @@
+//
+//  karmaRenderTargetPool.cpp
+//  karmaMapper
+//
+
+#include "karmaRenderTargetPool.h"
+
+// - - - - - - - -
+// CONSTRUCTORS
+// - - - - - - - -
+karmaRenderTargetPool::karmaRenderTargetPool() : bShutdown(false), bResizePending(false), pendingWidth(0), pendingHeight(0), numAllocations(0) {
+	ofAddListener( ofEvents().windowResized, this, &karmaRenderTargetPool::onWindowResized );
+}
+
+// nothing to release here, the window is gone by now (see shutdown())
+karmaRenderTargetPool::~karmaRenderTargetPool(){
+	
+}
+
+karmaRenderTargetPool& karmaRenderTargetPool::getInstance(){
+	static karmaRenderTargetPool instance;
+	return instance;
+}
+
+// - - - - - - - -
+// TARGETS
+// - - - - - - - -
+shared_ptr<ofFbo> karmaRenderTargetPool::acquire( const ofFbo::Settings& _settings, bool _windowSized ){
+	shared_ptr<renderTarget> target = findOrAllocate( _settings, _windowSized );
+	
+	// aliasing constructor: shares ownership of the whole target
+	return shared_ptr<ofFbo>( target, &target->fbo );
+}
+
+shared_ptr<ofFbo> karmaRenderTargetPool::acquireWindowSized( int _internalformat, int _numSamples, int _numColorbuffers ){
+	ofFbo::Settings s;
+	s.width = ofGetWidth();
+	s.height = ofGetHeight();
+	s.internalformat = _internalformat;
+	s.numColorbuffers = _numColorbuffers;
+#ifdef KM_BENCHMARK_APP
+	s.numSamples = _numSamples;
+#else
+	s.numSamples = MIN( _numSamples, ofFbo::maxSamples() );
+#endif
+	
+	return acquire( s, true );
+}
+
+bool karmaRenderTargetPool::beginFrame(){
+	if( !bResizePending ) return false;
+	bResizePending = false;
+	
+	// re-allocate all window-sized targets at once
+	for(auto it=targets.begin(); it!=targets.end(); ++it){
+		renderTarget& t = **it;
+		if( !t.bWindowSized ) continue;
+		if( t.settings.width == pendingWidth && t.settings.height == pendingHeight ) continue;
+		
+		t.settings.width = pendingWidth;
+		t.settings.height = pendingHeight;
+		allocateTarget( t );
+	}
+	
+	ofLogVerbose("karmaRenderTargetPool::beginFrame") << "Rebuilt window-sized render targets at " << pendingWidth << "x" << pendingHeight << ".";
+	return true;
+}
+
+void karmaRenderTargetPool::endFrame(){
+	for(auto it=targets.begin(); it!=targets.end(); ){
+		renderTarget& t = **it;
+		
+		if( isFree(*it) ){
+			t.idleFrames++;
+			if( t.idleFrames > KM_RENDERTARGET_KEEP_FRAMES ){
+				it = targets.erase(it); // frees GPU memory
+				continue;
+			}
+		}
+		else {
+			t.idleFrames = 0;
+		}
+		++it;
+	}
+}
+
+void karmaRenderTargetPool::trim(){
+	for(auto it=targets.begin(); it!=targets.end(); ){
+		if( isFree(*it) ) it = targets.erase(it);
+		else ++it;
+	}
+}
+
+void karmaRenderTargetPool::shutdown(){
+	if( bShutdown ) return;
+	bShutdown = true;
+	
+	ofRemoveListener( ofEvents().windowResized, this, &karmaRenderTargetPool::onWindowResized );
+	
+	// targets still referenced outlive the pool's list, empty their FBOs now
+	for(auto it=targets.begin(); it!=targets.end(); ++it){
+		(*it)->fbo.clear();
+		(*it)->bytes = 0;
+	}
+	targets.clear();
+	bResizePending = false;
+}
+
+uint64_t karmaRenderTargetPool::getAllocatedBytes() const {
+	uint64_t bytes = 0;
+	for(auto it=targets.cbegin(); it!=targets.cend(); ++it){
+		bytes += (*it)->bytes;
+	}
+	return bytes;
+}
+
+uint64_t karmaRenderTargetPool::getUsedBytes() const {
+	uint64_t bytes = 0;
+	for(auto it=targets.cbegin(); it!=targets.cend(); ++it){
+		if( !isFree(*it) ) bytes += (*it)->bytes;
+	}
+	return bytes;
+}
+
+unsigned int karmaRenderTargetPool::getNumTargets() const {
+	return targets.size();
+}
+
+// rough, drivers add some padding
+uint64_t karmaRenderTargetPool::estimateBytes( const ofFbo::Settings& _settings ){
+	uint64_t bytesPerPixel = 4;
+	switch( _settings.internalformat ){
+		case GL_LUMINANCE:
+		case GL_R8:
+			bytesPerPixel = 1;
+			break;
+		case GL_RGBA16F:
+		case GL_RGBA16:
+			bytesPerPixel = 8;
+			break;
+		case GL_RGB32F:
+			bytesPerPixel = 12;
+			break;
+		case GL_RGBA32F:
+			bytesPerPixel = 16;
+			break;
+		default:
+			break;
+	}
+	
+	uint64_t pixels = (uint64_t)_settings.width * _settings.height;
+	uint64_t numColorbuffers = MAX(1, _settings.numColorbuffers);
+	
+	// textures
+	uint64_t bytes = pixels * bytesPerPixel * numColorbuffers;
+	
+	// multisampled render buffers, resolved into the textures
+	if( _settings.numSamples > 0 ){
+		bytes += pixels * bytesPerPixel * numColorbuffers * _settings.numSamples;
+	}
+	
+	// depth & stencil (packed)
+	if( _settings.useDepth || _settings.useStencil ){
+		bytes += pixels * 4 * MAX(1, _settings.numSamples);
+	}
+	
+	return bytes;
+}
+
+// - - - - - - - -
+// GUI
+// - - - - - - - -
+void karmaRenderTargetPool::drawImGui( const string& _title, bool& _show ){
+	ImGui::SetNextWindowSize(ImVec2(420,300), ImGuiSetCond_FirstUseEver);
+	if (!ImGui::Begin(_title.c_str(), &_show)){
+		ImGui::End();
+		return;
+	}
+	
+	ImGui::Text("VRAM: %.1f MB in use, %.1f MB allocated", getUsedBytes()/1048576.f, getAllocatedBytes()/1048576.f );
+	ImGui::Text("%u target(s), %llu allocation(s) since start", getNumTargets(), (unsigned long long) numAllocations );
+	if( ImGui::Button("Free unused targets") ){
+		trim();
+	}
+	
+	ImGui::Separator();
+	
+	ImGui::Columns(4);
+	ImGui::Text("Size"); ImGui::NextColumn();
+	ImGui::Text("Format"); ImGui::NextColumn();
+	ImGui::Text("MB"); ImGui::NextColumn();
+	ImGui::Text("State"); ImGui::NextColumn();
+	ImGui::Separator();
+	
+	for(auto it=targets.begin(); it!=targets.end(); ++it){
+		renderTarget& t = **it;
+		
+		ImGui::Text("%ix%i%s", t.settings.width, t.settings.height, t.bWindowSized?" (window)":"" ); ImGui::NextColumn();
+		ImGui::Text("0x%X x%i, %i samples", t.settings.internalformat, t.settings.numColorbuffers, t.settings.numSamples ); ImGui::NextColumn();
+		ImGui::Text("%.1f", t.bytes/1048576.f ); ImGui::NextColumn();
+		if( !isFree(*it) ) ImGui::Text("in use");
+		else ImGui::TextDisabled("free (%u frames)", t.idleFrames);
+		ImGui::NextColumn();
+	}
+	ImGui::Columns(1);
+	
+	ImGui::End();
+}
+
+// - - - - - - - -
+// INTERNALS
+// - - - - - - - -
+bool karmaRenderTargetPool::isFree( const shared_ptr<renderTarget>& _target ) const {
+	return _target.use_count() == 1;
+}
+
+bool karmaRenderTargetPool::isSameSettings( const ofFbo::Settings& _a, const ofFbo::Settings& _b ){
+	return	_a.width == _b.width &&
+			_a.height == _b.height &&
+			_a.internalformat == _b.internalformat &&
+			_a.numSamples == _b.numSamples &&
+			_a.numColorbuffers == _b.numColorbuffers &&
+			_a.useDepth == _b.useDepth &&
+			_a.useStencil == _b.useStencil &&
+			_a.textureTarget == _b.textureTarget;
+}
+
+shared_ptr<karmaRenderTargetPool::renderTarget> karmaRenderTargetPool::findOrAllocate( const ofFbo::Settings& _settings, bool _windowSized ){
+	for(auto it=targets.begin(); it!=targets.end(); ++it){
+		renderTarget& t = **it;
+		if( !isFree(*it) ) continue;
+		if( t.bWindowSized != _windowSized ) continue;
+		if( !isSameSettings(t.settings, _settings) ) continue;
+		
+		t.idleFrames = 0;
+		return *it;
+	}
+	
+	shared_ptr<renderTarget> target( new renderTarget() );
+	target->settings = _settings;
+	target->bWindowSized = _windowSized;
+	allocateTarget( *target );
+	targets.push_back( target );
+	
+	return target;
+}
+
+void karmaRenderTargetPool::allocateTarget( renderTarget& _target ){
+	_target.bytes = estimateBytes( _target.settings );
+	numAllocations++;
+
+#ifdef KM_BENCHMARK_APP
+	KM_RECORD_RENDER_CALL(renderTargetAllocations, 1);
+#else
+	_target.fbo.allocate( _target.settings );
+#endif
+}
+
+void karmaRenderTargetPool::onWindowResized( ofResizeEventArgs& _args ){
+	// resize events come in bursts while dragging, only the last one counts
+	bResizePending = true;
+	pendingWidth = _args.width;
+	pendingHeight = _args.height;
+}
@@ -0,0 +1,81 @@
+//
+//  karmaRenderTargetPool.h
+//  karmaMapper
+//
+//	Shared pool of render targets (FBOs), keyed by size, format and sample count.
+//	Released targets are kept around for a while and handed to the next request with the same settings instead of allocating new VRAM.
+//	Window-sized targets are re-allocated once when the window got resized, at the start of the next frame.
+//	GL objects: only use it from the main thread. In the benchmark target nothing gets allocated, memory is only accounted.
+//	The app has to call shutdown() from its exit(), the GL context is gone by the time statics get destroyed.
+//
+
+#pragma once
+
+#include "ofMain.h"
+#include "ofxImGui.h"
+#include "karmaRenderRecorder.h"
+
+// unused targets are freed after this many frames
+#define KM_RENDERTARGET_KEEP_FRAMES 120
+
+class karmaRenderTargetPool {
+public:
+	static karmaRenderTargetPool& getInstance();
+	
+	// persistent target, yours as long as you keep the pointer
+	// _windowSized targets follow the window size, their contents are lost on resize
+	shared_ptr<ofFbo> acquire( const ofFbo::Settings& _settings, bool _windowSized = false );
+	shared_ptr<ofFbo> acquireWindowSized( int _internalformat = GL_RGBA, int _numSamples = 0, int _numColorbuffers = 1 );
+	
+	// called by the controller around rendering
+	bool beginFrame(); // applies pending resizes, returns true if targets got re-allocated
+	void endFrame(); // frees targets unused for a while
+	
+	// frees all unused targets now
+	void trim();
+	
+	// frees all targets, even the ones still in use, and stops following the window
+	// call from the app's exit() while there's still a GL context
+	void shutdown();
+	
+	uint64_t getAllocatedBytes() const;
+	uint64_t getUsedBytes() const;
+	unsigned int getNumTargets() const;
+	
+	static uint64_t estimateBytes( const ofFbo::Settings& _settings );
+	
+	void drawImGui( const string& _title, bool& _show );
+
+private:
+	karmaRenderTargetPool();
+	~karmaRenderTargetPool();
+	karmaRenderTargetPool(const karmaRenderTargetPool&) = delete;
+	karmaRenderTargetPool& operator=(const karmaRenderTargetPool&) = delete;
+	
+	struct renderTarget {
+		ofFbo fbo;
+		ofFbo::Settings settings;
+		uint64_t bytes = 0;
+		bool bWindowSized = false;
+		unsigned int idleFrames = 0;
+	};
+	
+	// users hold an aliased pointer, the target is free when only the pool references it
+	bool isFree( const shared_ptr<renderTarget>& _target ) const;
+	static bool isSameSettings( const ofFbo::Settings& _a, const ofFbo::Settings& _b );
+	shared_ptr<renderTarget> findOrAllocate( const ofFbo::Settings& _settings, bool _windowSized );
+	void allocateTarget( renderTarget& _target );
+	
+	void onWindowResized( ofResizeEventArgs& _args );
+	
+	list< shared_ptr<renderTarget> > targets;
+	
+	bool bShutdown;
+	bool bResizePending;
+	int pendingWidth;
+	int pendingHeight;
+	uint64_t numAllocations;
+};
+
+#define GUIRenderTargetsPanel "Render Targets"
+#define GUIToggleRenderTargets "Show Render Targets"
@@ -0,0 +1,133 @@
+//
+//  karmaThreadPool.cpp
+//  karmaMapper
+//
+
+#include "karmaThreadPool.h"
+
+// lets tasks queued from within a worker go to its own queue
+static thread_local const karmaThreadPool* currentPool = nullptr;
+static thread_local unsigned int currentWorker = 0;
+
+// - - - - - - - -
+// CONSTRUCTORS
+// - - - - - - - -
+karmaThreadPool::karmaThreadPool( unsigned int _numThreads ) : nextQueue(0), numQueued(0), bRunning(true) {
+	if( _numThreads == 0 ){
+		unsigned int cores = std::thread::hardware_concurrency();
+		_numThreads = (cores>1) ? cores-1 : 1;
+	}
+	
+	for(unsigned int i=0; i<_numThreads; ++i){
+		queues.emplace_back( new workerQueue() );
+	}
+	for(unsigned int i=0; i<_numThreads; ++i){
+		threads.emplace_back( &karmaThreadPool::workerThread, this, i );
+	}
+	
+	ofLogVerbose("karmaThreadPool::karmaThreadPool") << "Started " << _numThreads << " worker threads.";
+}
+
+karmaThreadPool::~karmaThreadPool(){
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		bRunning = false;
+	}
+	sleepCondition.notify_all();
+	
+	for(auto it=threads.begin(); it!=threads.end(); ++it){
+		if( it->joinable() ) it->join();
+	}
+}
+
+// - - - - - - - -
+// TASKS
+// - - - - - - - -
+void karmaThreadPool::run( karmaTaskGroup& _group, const std::function<void()>& _task ){
+	_group.numPending++;
+	
+	unsigned int q = (currentPool == this) ? currentWorker : (nextQueue++ % queues.size());
+	
+	numQueued++;
+	{
+		ofScopedLock lock( queues[q]->mutex );
+		queues[q]->tasks.push_back( task{ _task, &_group } );
+	}
+	
+	// wake up a sleeping worker
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+	}
+	sleepCondition.notify_one();
+}
+
+void karmaThreadPool::wait( karmaTaskGroup& _group ){
+	bool bIsWorker = (currentPool == this);
+	unsigned int start = bIsWorker ? currentWorker : 0;
+	
+	// help instead of blocking
+	while( !_group.isDone() ){
+		task t;
+		if( (bIsWorker && popTask(start, t)) || stealTask(start, t) ){
+			execute(t);
+		}
+		else {
+			// remaining tasks are running on other threads
+			std::this_thread::yield();
+		}
+	}
+}
+
+unsigned int karmaThreadPool::getNumThreads() const {
+	return threads.size();
+}
+
+// - - - - - - - -
+// INTERNALS
+// - - - - - - - -
+void karmaThreadPool::workerThread( unsigned int _index ){
+	currentPool = this;
+	currentWorker = _index;
+	
+	while( bRunning ){
+		task t;
+		if( popTask(_index, t) || stealTask(_index, t) ){
+			execute(t);
+			continue;
+		}
+		
+		// nothing to do, sleep until something gets queued
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		sleepCondition.wait(lock, [this]{ return numQueued.load() > 0 || !bRunning; });
+	}
+}
+
+bool karmaThreadPool::popTask( unsigned int _queue, task& _task ){
+	workerQueue& q = *queues[_queue];
+	ofScopedLock lock( q.mutex );
+	if( q.tasks.empty() ) return false;
+	
+	_task = std::move( q.tasks.back() );
+	q.tasks.pop_back();
+	numQueued--;
+	return true;
+}
+
+bool karmaThreadPool::stealTask( unsigned int _thief, task& _task ){
+	for(unsigned int i=1; i<=queues.size(); ++i){
+		workerQueue& q = *queues[ (_thief+i) % queues.size() ];
+		ofScopedLock lock( q.mutex );
+		if( q.tasks.empty() ) continue;
+		
+		_task = std::move( q.tasks.front() );
+		q.tasks.pop_front();
+		numQueued--;
+		return true;
+	}
+	return false;
+}
+
+void karmaThreadPool::execute( task& _task ){
+	_task.function();
+	_task.group->numPending--;
+}
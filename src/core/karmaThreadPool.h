@@ -0,0 +1,70 @@
+//
+//  karmaThreadPool.h
+//  karmaMapper
+//
+//	Small work-stealing thread pool.
+//	Each worker owns a task queue. Idle workers steal from the others, and a thread waiting on a group helps running its tasks.
+//
+
+#pragma once
+
+#include "ofMain.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+
+// a bunch of tasks you can wait for
+class karmaTaskGroup {
+public:
+	karmaTaskGroup() : numPending(0) {}
+	
+	bool isDone() const { return numPending.load() == 0; }
+
+private:
+	friend class karmaThreadPool;
+	std::atomic<int> numPending;
+};
+
+class karmaThreadPool {
+public:
+	// 0 threads = one per hardware core, minus the main thread
+	karmaThreadPool( unsigned int _numThreads = 0 );
+	~karmaThreadPool();
+	
+	// queues a task. Can be called from any thread, including from within a task.
+	void run( karmaTaskGroup& _group, const std::function<void()>& _task );
+	
+	// blocks until all tasks of the group are done, running queued tasks meanwhile
+	void wait( karmaTaskGroup& _group );
+	
+	unsigned int getNumThreads() const;
+
+private:
+	karmaThreadPool(const karmaThreadPool&) = delete;
+	karmaThreadPool& operator=(const karmaThreadPool&) = delete;
+	
+	struct task {
+		std::function<void()> function;
+		karmaTaskGroup* group;
+	};
+	
+	struct workerQueue {
+		ofMutex mutex;
+		std::deque<task> tasks;
+	};
+	
+	void workerThread( unsigned int _index );
+	bool popTask( unsigned int _queue, task& _task ); // from the back of its own queue
+	bool stealTask( unsigned int _thief, task& _task ); // from the front of the other queues
+	void execute( task& _task );
+	
+	vector< std::thread > threads;
+	vector< std::unique_ptr<workerQueue> > queues; // one per worker
+	std::atomic<unsigned int> nextQueue; // round-robin for tasks queued from other threads
+	std::atomic<int> numQueued;
+	std::atomic<bool> bRunning;
+	
+	std::mutex sleepMutex;
+	std::condition_variable sleepCondition;
+};
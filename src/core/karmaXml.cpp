@@ -0,0 +1,659 @@
+//
+//  karmaXml.cpp
+//  karmaMapper
+//
+
+#include "karmaXml.h"
+
+// bytes kept before the writer hits the disk
+#define KM_XML_WRITER_FLUSH_SIZE 65536
+
+static inline bool isXmlSpace( char _c ){
+	return _c==' ' || _c=='\t' || _c=='\n' || _c=='\r';
+}
+
+static inline bool isXmlNameEnd( char _c ){
+	return isXmlSpace(_c) || _c=='>' || _c=='/' || _c=='=';
+}
+
+static const char* findSequence( const char* _begin, const char* _end, const char* _sequence ){
+	size_t length = strlen(_sequence);
+	for(const char* c=_begin; c+length<=_end; ++c){
+		if( *c == _sequence[0] && memcmp(c, _sequence, length)==0 ) return c;
+	}
+	return nullptr;
+}
+
+static bool startsWith( const char* _begin, const char* _end, const char* _prefix ){
+	size_t length = strlen(_prefix);
+	return (size_t)(_end-_begin) >= length && memcmp(_begin, _prefix, length)==0;
+}
+
+static void trim( string& _text ){
+	size_t first = 0;
+	while( first < _text.size() && isXmlSpace(_text[first]) ) ++first;
+	size_t last = _text.size();
+	while( last > first && isXmlSpace(_text[last-1]) ) --last;
+	if( first > 0 || last < _text.size() ) _text = _text.substr(first, last-first);
+}
+
+static void appendUTF8( string& _out, unsigned long _code ){
+	if( _code < 0x80 ){
+		_out += (char) _code;
+	}
+	else if( _code < 0x800 ){
+		_out += (char) (0xC0 | (_code>>6));
+		_out += (char) (0x80 | (_code & 0x3F));
+	}
+	else if( _code < 0x10000 ){
+		_out += (char) (0xE0 | (_code>>12));
+		_out += (char) (0x80 | ((_code>>6) & 0x3F));
+		_out += (char) (0x80 | (_code & 0x3F));
+	}
+	else {
+		_out += (char) (0xF0 | (_code>>18));
+		_out += (char) (0x80 | ((_code>>12) & 0x3F));
+		_out += (char) (0x80 | ((_code>>6) & 0x3F));
+		_out += (char) (0x80 | (_code & 0x3F));
+	}
+}
+
+// - - - - - - - -
+// ELEMENTS
+// - - - - - - - -
+// walks the start tag's attributes
+static bool findAttribute( const char* _begin, const char* _end, const char* _name, string& _value ){
+	size_t nameLength = strlen(_name);
+	const char* c = _begin;
+	while( c < _end ){
+		while( c < _end && isXmlSpace(*c) ) ++c;
+		const char* nameBegin = c;
+		while( c < _end && !isXmlNameEnd(*c) ) ++c;
+		const char* nameEnd = c;
+		while( c < _end && isXmlSpace(*c) ) ++c;
+		if( nameBegin == nameEnd || c >= _end || *c != '=' ) return false;
+		++c;
+		while( c < _end && isXmlSpace(*c) ) ++c;
+		if( c >= _end || (*c!='"' && *c!='\'') ) return false;
+		char quote = *c++;
+		const char* valueBegin = c;
+		while( c < _end && *c != quote ) ++c;
+		if( c >= _end ) return false;
+		
+		if( (size_t)(nameEnd-nameBegin) == nameLength && memcmp(nameBegin, _name, nameLength)==0 ){
+			_value = karmaXmlReader::decode( valueBegin, c );
+			return true;
+		}
+		++c;
+	}
+	return false;
+}
+
+bool karmaXmlElement::hasAttribute( const char* _name ) const {
+	string value;
+	return findAttribute( attributesBegin, attributesEnd, _name, value );
+}
+
+string karmaXmlElement::getAttribute( const char* _name, const string& _default ) const {
+	string value;
+	if( !findAttribute( attributesBegin, attributesEnd, _name, value ) ) return _default;
+	return value;
+}
+
+int karmaXmlElement::getAttribute( const char* _name, int _default ) const {
+	string value;
+	if( !findAttribute( attributesBegin, attributesEnd, _name, value ) ) return _default;
+	char* parsedEnd = nullptr;
+	long parsed = strtol( value.c_str(), &parsedEnd, 10 );
+	return (parsedEnd == value.c_str()) ? _default : (int) parsed;
+}
+
+float karmaXmlElement::getAttribute( const char* _name, float _default ) const {
+	string value;
+	if( !findAttribute( attributesBegin, attributesEnd, _name, value ) ) return _default;
+	char* parsedEnd = nullptr;
+	float parsed = strtof( value.c_str(), &parsedEnd );
+	return (parsedEnd == value.c_str()) ? _default : parsed;
+}
+
+string karmaXmlElement::getValue( const string& _default ) const {
+	return text.empty() ? _default : text;
+}
+
+int karmaXmlElement::getValue( int _default ) const {
+	char* parsedEnd = nullptr;
+	long parsed = strtol( text.c_str(), &parsedEnd, 10 );
+	return (parsedEnd == text.c_str()) ? _default : (int) parsed;
+}
+
+float karmaXmlElement::getValue( float _default ) const {
+	char* parsedEnd = nullptr;
+	float parsed = strtof( text.c_str(), &parsedEnd );
+	return (parsedEnd == text.c_str()) ? _default : parsed;
+}
+
+double karmaXmlElement::getValue( double _default ) const {
+	char* parsedEnd = nullptr;
+	double parsed = strtod( text.c_str(), &parsedEnd );
+	return (parsedEnd == text.c_str()) ? _default : parsed;
+}
+
+bool karmaXmlElement::getValue( bool _default ) const {
+	if( text == "true" ) return true;
+	if( text == "false" ) return false;
+	return getValue( (int)_default ) != 0;
+}
+
+// remembers where the excluded children are
+class karmaXmlExcludeVisitor : public karmaXmlVisitor {
+public:
+	karmaXmlExcludeVisitor( const char* _name ) : name(_name) {}
+	
+	virtual bool onXmlElementStart( const karmaXmlElement& _element ){
+		return _element.getDepth() == 0;
+	}
+	
+	virtual bool onXmlElementEnd( const karmaXmlElement& _element ){
+		if( _element.is(name) ) spans.push_back( make_pair(_element.getSource(), _element.getSource()+_element.getSourceSize()) );
+		return true;
+	}
+	
+	const char* name;
+	vector< pair<const char*, const char*> > spans;
+};
+
+string karmaXmlElement::getInnerSource( const char* _excludeChild ) const {
+	if( contentBegin == nullptr || contentEnd < contentBegin ) return "";
+	if( _excludeChild == nullptr || !bHasChildren ) return string( contentBegin, contentEnd );
+	
+	karmaXmlExcludeVisitor excluded( _excludeChild );
+	karmaXmlReader reader;
+	if( !reader.parse( contentBegin, contentEnd-contentBegin, excluded ) ) return string( contentBegin, contentEnd );
+	
+	string inner;
+	inner.reserve( contentEnd-contentBegin );
+	const char* c = contentBegin;
+	for(auto it=excluded.spans.cbegin(); it!=excluded.spans.cend(); ++it){
+		inner.append( c, it->first );
+		c = it->second;
+	}
+	inner.append( c, contentEnd );
+	return inner;
+}
+
+// - - - - - - - -
+// READER
+// - - - - - - - -
+karmaXmlReader::karmaXmlReader() : data(nullptr), cursor(nullptr), end(nullptr), depth(0) {
+
+}
+
+bool karmaXmlReader::open( const string& _path ){
+	error.clear();
+	if( !file.open(_path) ){
+		error = "Can't open " + _path;
+		return false;
+	}
+	return true;
+}
+
+void karmaXmlReader::close(){
+	file.close();
+}
+
+bool karmaXmlReader::parse( karmaXmlVisitor& _visitor ){
+	if( !file.isOpen() ) return fail("No file opened.");
+	return parse( (const char*) file.getData(), file.getSize(), _visitor );
+}
+
+bool karmaXmlReader::parse( const char* _data, size_t _size, karmaXmlVisitor& _visitor ){
+	data = _data;
+	cursor = _data;
+	end = _data + _size;
+	depth = 0;
+	error.clear();
+	
+	// skipped elements don't get any callbacks, neither do their children
+	int skipDepth = -1;
+	
+	while( cursor < end ){
+		const char* tag = (const char*) memchr( cursor, '<', end-cursor );
+		if( tag == nullptr ) tag = end;
+		
+		// text of the current leaf
+		if( tag > cursor && depth > 0 && skipDepth < 0 ){
+			karmaXmlElement& current = stack[depth-1];
+			if( !current.bHasChildren ) current.text += decode( cursor, tag );
+		}
+		cursor = tag;
+		if( cursor >= end ) break;
+		
+		// declarations, comments
+		if( startsWith(cursor, end, "<?") ){
+			const char* close = findSequence( cursor, end, "?>" );
+			if( close == nullptr ) return fail("Unterminated declaration.");
+			cursor = close+2;
+			continue;
+		}
+		if( startsWith(cursor, end, "<!--") ){
+			const char* close = findSequence( cursor, end, "-->" );
+			if( close == nullptr ) return fail("Unterminated comment.");
+			cursor = close+3;
+			continue;
+		}
+		if( startsWith(cursor, end, "<![CDATA[") ){
+			const char* close = findSequence( cursor, end, "]]>" );
+			if( close == nullptr ) return fail("Unterminated CDATA section.");
+			if( depth > 0 && skipDepth < 0 && !stack[depth-1].bHasChildren ) stack[depth-1].text.append( cursor+9, close );
+			cursor = close+3;
+			continue;
+		}
+		if( startsWith(cursor, end, "<!") ){
+			const char* close = (const char*) memchr( cursor, '>', end-cursor );
+			if( close == nullptr ) return fail("Unterminated <! tag.");
+			cursor = close+1;
+			continue;
+		}
+		
+		// end tag
+		if( startsWith(cursor, end, "</") ){
+			const char* close = (const char*) memchr( cursor, '>', end-cursor );
+			if( close == nullptr ) return fail("Unterminated end tag.");
+			const char* nameBegin = cursor+2;
+			const char* nameEnd = close;
+			while( nameEnd > nameBegin && isXmlSpace(*(nameEnd-1)) ) --nameEnd;
+			
+			if( depth == 0 ) return fail("Unexpected end tag </" + string(nameBegin, nameEnd) + ">.");
+			karmaXmlElement& element = stack[depth-1];
+			if( element.name.compare( 0, string::npos, nameBegin, nameEnd-nameBegin ) != 0 ){
+				return fail("Expected </" + element.name + "> but found </" + string(nameBegin, nameEnd) + ">.");
+			}
+			element.contentEnd = cursor;
+			element.sourceEnd = close+1;
+			cursor = close+1;
+			
+			if( skipDepth < 0 ){
+				if( !element.bHasChildren ){
+					trim( element.text );
+					_visitor.onXmlValue( element );
+				}
+				if( !_visitor.onXmlElementEnd( element ) ) return fail("Could not load <" + element.name + ">.");
+			}
+			--depth;
+			if( skipDepth == (int)depth ) skipDepth = -1;
+			continue;
+		}
+		
+		// start tag
+		const char* nameBegin = cursor+1;
+		const char* nameEnd = nameBegin;
+		while( nameEnd < end && !isXmlNameEnd(*nameEnd) ) ++nameEnd;
+		if( nameEnd == nameBegin ) return fail("Tag without a name.");
+		
+		// find the end of the tag, attribute values can contain '>'
+		const char* close = nameEnd;
+		char quote = 0;
+		while( close < end ){
+			if( quote != 0 ){
+				if( *close == quote ) quote = 0;
+			}
+			else if( *close == '"' || *close == '\'' ) quote = *close;
+			else if( *close == '>' ) break;
+			++close;
+		}
+		if( close >= end ) return fail("Unterminated tag <" + string(nameBegin, nameEnd) + ">.");
+		bool bSelfClosing = *(close-1) == '/';
+		
+		if( depth > 0 ) stack[depth-1].bHasChildren = true;
+		karmaXmlElement& element = push();
+		element.name.assign( nameBegin, nameEnd );
+		element.attributesBegin = nameEnd;
+		element.attributesEnd = bSelfClosing ? close-1 : close;
+		element.sourceBegin = cursor;
+		element.contentBegin = close+1;
+		cursor = close+1;
+		
+		if( skipDepth < 0 && !_visitor.onXmlElementStart( element ) ) skipDepth = depth-1;
+		
+		if( bSelfClosing ){
+			element.contentEnd = element.contentBegin;
+			element.sourceEnd = cursor;
+			if( skipDepth < 0 ){
+				_visitor.onXmlValue( element );
+				if( !_visitor.onXmlElementEnd( element ) ) return fail("Could not load <" + element.name + ">.");
+			}
+			--depth;
+			if( skipDepth == (int)depth ) skipDepth = -1;
+		}
+	}
+	
+	if( depth > 0 ) return fail("Unclosed element <" + stack[depth-1].name + ">.");
+	return true;
+}
+
+string karmaXmlReader::decode( const char* _begin, const char* _end ){
+	const char* amp = (const char*) memchr( _begin, '&', _end-_begin );
+	if( amp == nullptr ) return string( _begin, _end );
+	
+	string out( _begin, amp );
+	const char* c = amp;
+	while( c < _end ){
+		if( *c != '&' ){
+			out += *c++;
+			continue;
+		}
+		const char* semicolon = (const char*) memchr( c, ';', MIN(_end-c, 12) );
+		if( semicolon == nullptr ){
+			out += *c++;
+			continue;
+		}
+		string entity( c+1, semicolon );
+		if( entity == "lt" ) out += '<';
+		else if( entity == "gt" ) out += '>';
+		else if( entity == "amp" ) out += '&';
+		else if( entity == "quot" ) out += '"';
+		else if( entity == "apos" ) out += '\'';
+		else if( entity.size() > 1 && entity[0] == '#' ){
+			bool bHex = entity[1] == 'x' || entity[1] == 'X';
+			appendUTF8( out, strtoul( entity.c_str() + (bHex?2:1), nullptr, bHex?16:10 ) );
+		}
+		else {
+			// unknown, keep it as is
+			out.append( c, semicolon+1 );
+		}
+		c = semicolon+1;
+	}
+	return out;
+}
+
+bool karmaXmlReader::fail( const string& _message ){
+	// line number, for humans
+	unsigned int line = 1;
+	if( data != nullptr && cursor != nullptr ){
+		for(const char* c=data; c<cursor && c<end; ++c){
+			if( *c == '\n' ) ++line;
+		}
+	}
+	error = _message + " (line " + ofToString(line) + ")";
+	return false;
+}
+
+karmaXmlElement& karmaXmlReader::push(){
+	if( stack.size() == depth ) stack.emplace_back();
+	karmaXmlElement& element = stack[depth];
+	element.text.clear();
+	element.depth = depth;
+	element.bHasChildren = false;
+	element.parent = depth > 0 ? &stack[depth-1] : nullptr;
+	element.sourceEnd = nullptr;
+	element.contentEnd = nullptr;
+	++depth;
+	return element;
+}
+
+// - - - - - - - -
+// FORWARDER
+// - - - - - - - -
+karmaXmlForwarder::karmaXmlForwarder() : target(nullptr), baseDepth(0), skipDepth(-1) {
+	
+}
+
+void karmaXmlForwarder::begin( unsigned int _depth ){
+	target = nullptr;
+	baseDepth = _depth;
+	skipDepth = -1;
+	pending.clear();
+}
+
+bool karmaXmlForwarder::setTarget( karmaXmlVisitor* _target ){
+	target = _target;
+	if( target == nullptr ) return true;
+	
+	bool bContinue = true;
+	for(auto it=pending.cbegin(); it!=pending.cend() && bContinue; ++it){
+		bContinue = forward( it->first, it->second );
+	}
+	pending.clear();
+	return bContinue;
+}
+
+bool karmaXmlForwarder::onXmlElementStart( const karmaXmlElement& _element ){
+	if( target == nullptr ) pending.push_back( make_pair(XML_ELEMENT_START, _element) );
+	else forward( XML_ELEMENT_START, _element );
+	return true;
+}
+
+void karmaXmlForwarder::onXmlValue( const karmaXmlElement& _element ){
+	if( target == nullptr ) pending.push_back( make_pair(XML_VALUE, _element) );
+	else forward( XML_VALUE, _element );
+}
+
+bool karmaXmlForwarder::onXmlElementEnd( const karmaXmlElement& _element ){
+	if( target == nullptr ){
+		pending.push_back( make_pair(XML_ELEMENT_END, _element) );
+		return true;
+	}
+	return forward( XML_ELEMENT_END, _element );
+}
+
+// copies the element with its depth and parents re-based, the source spans stay valid while parsing
+bool karmaXmlForwarder::forward( eventType _type, const karmaXmlElement& _element ){
+	unsigned int depth = _element.depth - baseDepth;
+	
+	// the target doesn't get skipped elements, nor their end
+	if( skipDepth >= 0 ){
+		if( _type == XML_ELEMENT_END && (int)depth == skipDepth ) skipDepth = -1;
+		return true;
+	}
+	
+	if( stack.size() <= depth ) stack.resize( depth+1 );
+	karmaXmlElement& element = stack[depth];
+	element = _element;
+	element.depth = depth;
+	element.parent = depth > 0 ? &stack[depth-1] : nullptr;
+	
+	if( _type == XML_ELEMENT_START ){
+		if( !target->onXmlElementStart( element ) ) skipDepth = depth;
+		return true;
+	}
+	if( _type == XML_VALUE ){
+		target->onXmlValue( element );
+		return true;
+	}
+	return target->onXmlElementEnd( element );
+}
+
+// - - - - - - - -
+// WRITER
+// - - - - - - - -
+karmaXmlWriter::karmaXmlWriter() : written(0), bToFile(false), bStartTagOpen(false), bFailed(false) {
+
+}
+
+karmaXmlWriter::~karmaXmlWriter(){
+	if( bToFile ) close();
+}
+
+bool karmaXmlWriter::open( const string& _path ){
+	if( bToFile ) close();
+	
+	buffer.clear();
+	openElements.clear();
+	written = 0;
+	bStartTagOpen = false;
+	bFailed = false;
+	
+	out.open( ofToDataPath(_path, true).c_str(), ios::out | ios::binary | ios::trunc );
+	if( !out.is_open() ){
+		ofLogError("karmaXmlWriter::open") << "Can't write to " << _path;
+		bFailed = true;
+		return false;
+	}
+	bToFile = true;
+	return true;
+}
+
+bool karmaXmlWriter::close(){
+	if( !openElements.empty() ){
+		ofLogError("karmaXmlWriter::close") << "Unclosed element <" << openElements.back() << ">.";
+		bFailed = true;
+		while( !openElements.empty() ) endElement();
+	}
+	closeStartTag();
+	if( !buffer.empty() ) buffer += '\n';
+	
+	if( bToFile ){
+		flush(true);
+		out.close();
+		bToFile = false;
+	}
+	return !bFailed;
+}
+
+void karmaXmlWriter::beginElement( const string& _name ){
+	closeStartTag();
+	newLine();
+	buffer += '<';
+	buffer += _name;
+	openElements.push_back( _name );
+	bStartTagOpen = true;
+}
+
+void karmaXmlWriter::addAttribute( const string& _name, const string& _value ){
+	if( !bStartTagOpen ){
+		ofLogError("karmaXmlWriter::addAttribute") << "No start tag to add " << _name << " to.";
+		bFailed = true;
+		return;
+	}
+	buffer += ' ';
+	buffer += _name;
+	buffer += "=\"";
+	buffer += encode(_value);
+	buffer += '"';
+}
+
+void karmaXmlWriter::endElement(){
+	if( openElements.empty() ){
+		ofLogError("karmaXmlWriter::endElement") << "No element to end.";
+		bFailed = true;
+		return;
+	}
+	
+	if( bStartTagOpen ){
+		buffer += " />";
+		bStartTagOpen = false;
+		openElements.pop_back();
+	}
+	else {
+		string name = openElements.back();
+		openElements.pop_back();
+		newLine();
+		buffer += "</";
+		buffer += name;
+		buffer += '>';
+	}
+	flush();
+}
+
+void karmaXmlWriter::addValue( const string& _name, const string& _value ){
+	closeStartTag();
+	newLine();
+	buffer += '<';
+	buffer += _name;
+	buffer += '>';
+	buffer += encode(_value);
+	buffer += "</";
+	buffer += _name;
+	buffer += '>';
+}
+
+void karmaXmlWriter::addValue( const string& _name, const char* _value ){
+	addValue( _name, string(_value) );
+}
+
+void karmaXmlWriter::addValue( const string& _name, int _value ){
+	addValue( _name, ofToString(_value) );
+}
+
+void karmaXmlWriter::addValue( const string& _name, unsigned int _value ){
+	addValue( _name, ofToString(_value) );
+}
+
+void karmaXmlWriter::addValue( const string& _name, float _value ){
+	char text[32];
+	snprintf( text, sizeof(text), "%.9g", _value );
+	addValue( _name, string(text) );
+}
+
+void karmaXmlWriter::addValue( const string& _name, double _value ){
+	char text[32];
+	snprintf( text, sizeof(text), "%.17g", _value );
+	addValue( _name, string(text) );
+}
+
+void karmaXmlWriter::addValue( const string& _name, bool _value ){
+	addValue( _name, string(_value?"1":"0") );
+}
+
+void karmaXmlWriter::addRaw( const string& _xml ){
+	size_t begin = 0;
+	// drop the declaration, the document has one
+	while( begin < _xml.size() && isXmlSpace(_xml[begin]) ) ++begin;
+	if( _xml.compare( begin, 2, "<?" ) == 0 ){
+		size_t close = _xml.find( "?>", begin );
+		begin = (close==string::npos) ? _xml.size() : close+2;
+	}
+	while( begin < _xml.size() && isXmlSpace(_xml[begin]) ) ++begin;
+	size_t end = _xml.size();
+	while( end > begin && isXmlSpace(_xml[end-1]) ) --end;
+	if( end <= begin ) return;
+	
+	closeStartTag();
+	newLine();
+	buffer.append( _xml, begin, end-begin );
+	flush();
+}
+
+string karmaXmlWriter::encode( const string& _text ){
+	if( _text.find_first_of("<>&\"'") == string::npos ) return _text;
+	
+	string out;
+	out.reserve( _text.size()+16 );
+	for(auto c=_text.cbegin(); c!=_text.cend(); ++c){
+		switch( *c ){
+			case '<': out += "&lt;"; break;
+			case '>': out += "&gt;"; break;
+			case '&': out += "&amp;"; break;
+			case '"': out += "&quot;"; break;
+			case '\'': out += "&apos;"; break;
+			default: out += *c;
+		}
+	}
+	return out;
+}
+
+void karmaXmlWriter::closeStartTag(){
+	if( !bStartTagOpen ) return;
+	buffer += '>';
+	bStartTagOpen = false;
+}
+
+// indented like ofxXmlSettings does
+void karmaXmlWriter::newLine(){
+	if( !buffer.empty() || written > 0 ) buffer += '\n';
+	// called before pushing (begin) or after popping (end)
+	buffer.append( openElements.size()*4, ' ' );
+}
+
+void karmaXmlWriter::flush( bool _force ){
+	if( !bToFile || buffer.empty() ) return;
+	if( !_force && buffer.size() < KM_XML_WRITER_FLUSH_SIZE ) return;
+	
+	out.write( buffer.data(), buffer.size() );
+	written += buffer.size();
+	if( !out.good() ){
+		ofLogError("karmaXmlWriter::flush") << "Write failed.";
+		bFailed = true;
+	}
+	buffer.clear();
+}
@@ -0,0 +1,170 @@
+//
+//  karmaXml.h
+//  karmaMapper
+//
+//	Streaming XML, no DOM: the reader walks the (memory mapped) file once and calls a visitor, the writer appends to the file as it goes.
+//	Reads what ofxXmlSettings writes (several root tags, leaf values) and writes files ofxXmlSettings can read back.
+//	Elements can hand their source span to another visitor, or to a legacy ofxXmlSettings loader as a small fragment.
+//
+
+#pragma once
+
+#include "ofMain.h"
+#include "karmaMappedFile.h"
+
+class karmaXmlReader;
+
+// the element currently visited, only valid during the callback
+class karmaXmlElement {
+public:
+	const string& getName() const { return name; }
+	bool is( const char* _name ) const { return name == _name; }
+	unsigned int getDepth() const { return depth; } // 0 = root tags
+	const karmaXmlElement* getParent() const { return parent; }
+	bool isChildOf( const char* _name ) const { return parent != nullptr && parent->is(_name); }
+	
+	// attributes of the start tag, parsed on request
+	bool hasAttribute( const char* _name ) const;
+	string getAttribute( const char* _name, const string& _default = "" ) const;
+	int getAttribute( const char* _name, int _default ) const;
+	float getAttribute( const char* _name, float _default ) const;
+	
+	// text of leaf elements (onXmlValue)
+	const string& getText() const { return text; }
+	string getValue( const string& _default ) const;
+	string getValue( const char* _default ) const { return getValue( string(_default) ); }
+	int getValue( int _default ) const;
+	float getValue( float _default ) const;
+	double getValue( double _default ) const;
+	bool getValue( bool _default ) const;
+	
+	// raw bytes of the whole element and of its content, complete in onXmlElementEnd
+	const char* getSource() const { return sourceBegin; }
+	size_t getSourceSize() const { return sourceEnd - sourceBegin; }
+	string getInnerSource( const char* _excludeChild = nullptr ) const; // without the direct children named _excludeChild
+
+private:
+	friend class karmaXmlReader;
+	friend class karmaXmlForwarder;
+	
+	string name;
+	string text;
+	unsigned int depth = 0;
+	bool bHasChildren = false;
+	const karmaXmlElement* parent = nullptr;
+	const char* attributesBegin = nullptr;
+	const char* attributesEnd = nullptr;
+	const char* sourceBegin = nullptr;
+	const char* sourceEnd = nullptr;
+	const char* contentBegin = nullptr;
+	const char* contentEnd = nullptr;
+};
+
+class karmaXmlVisitor {
+public:
+	virtual ~karmaXmlVisitor(){}
+	
+	// return false to skip the element, neither it nor its children get more callbacks
+	virtual bool onXmlElementStart( const karmaXmlElement& _element ){ return true; }
+	// elements without child elements, right before onXmlElementEnd()
+	virtual void onXmlValue( const karmaXmlElement& _element ){}
+	// return false to stop parsing (reported as an error)
+	virtual bool onXmlElementEnd( const karmaXmlElement& _element ){ return true; }
+};
+
+class karmaXmlReader {
+public:
+	karmaXmlReader();
+	
+	// maps the file, _path is absolute or relative to the data folder
+	bool open( const string& _path );
+	void close();
+	bool parse( karmaXmlVisitor& _visitor ); // the opened file
+	bool parse( const char* _data, size_t _size, karmaXmlVisitor& _visitor ); // the data has to stay valid while parsing
+	
+	const string& getError() const { return error; }
+	
+	static string decode( const char* _begin, const char* _end ); // entities
+
+private:
+	bool fail( const string& _message );
+	karmaXmlElement& push();
+	
+	karmaMappedFile file;
+	const char* data;
+	const char* cursor;
+	const char* end;
+	string error;
+	
+	// open elements. A deque so parent pointers stay valid, entries are re-used.
+	deque<karmaXmlElement> stack;
+	unsigned int depth;
+};
+
+// passes an element and its children on to another visitor as if it was a root tag (depth 0)
+// events arriving before setTarget() are kept and replayed then, ie until the element's type is read
+class karmaXmlForwarder : public karmaXmlVisitor {
+public:
+	karmaXmlForwarder();
+	
+	// call from onXmlElementStart() of the forwarded element, before forwarding it
+	void begin( unsigned int _depth );
+	bool setTarget( karmaXmlVisitor* _target ); // false if the target stopped parsing while replaying
+	karmaXmlVisitor* getTarget() const { return target; }
+	
+	virtual bool onXmlElementStart( const karmaXmlElement& _element );
+	virtual void onXmlValue( const karmaXmlElement& _element );
+	virtual bool onXmlElementEnd( const karmaXmlElement& _element );
+
+private:
+	enum eventType { XML_ELEMENT_START, XML_VALUE, XML_ELEMENT_END };
+	bool forward( eventType _type, const karmaXmlElement& _element );
+	
+	karmaXmlVisitor* target;
+	unsigned int baseDepth;
+	int skipDepth; // the target skipped this element
+	vector< pair<eventType, karmaXmlElement> > pending;
+	deque<karmaXmlElement> stack; // open elements, re-based
+};
+
+class karmaXmlWriter {
+public:
+	karmaXmlWriter();
+	~karmaXmlWriter();
+	
+	// streams to the file (absolute or relative to the data folder), otherwise everything stays in getString()
+	bool open( const string& _path );
+	bool close(); // false on write errors or unclosed elements
+	const string& getString() const { return buffer; }
+	
+	void beginElement( const string& _name );
+	void addAttribute( const string& _name, const string& _value ); // right after beginElement()
+	void endElement();
+	
+	// <name>value</name>
+	void addValue( const string& _name, const string& _value );
+	void addValue( const string& _name, const char* _value );
+	void addValue( const string& _name, int _value );
+	void addValue( const string& _name, unsigned int _value );
+	void addValue( const string& _name, float _value );
+	void addValue( const string& _name, double _value );
+	void addValue( const string& _name, bool _value ); // 0 or 1, like ofxXmlSettings
+	
+	// already serialized elements, ie from ofxXmlSettings::copyXmlToString()
+	void addRaw( const string& _xml );
+	
+	static string encode( const string& _text );
+
+private:
+	void closeStartTag();
+	void newLine();
+	void flush( bool _force = false );
+	
+	string buffer;
+	size_t written;
+	ofstream out;
+	bool bToFile;
+	bool bStartTagOpen;
+	bool bFailed;
+	vector<string> openElements;
+};
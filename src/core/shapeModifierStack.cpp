@@ -0,0 +1,94 @@
+//
+//  shapeModifierStack.cpp
+//  karmaMapper
+//
+
+#include "shapeModifierStack.h"
+
+// shapes per pool task
+#define KM_MODIFIER_STACK_CHUNK 64
+
+shapeModifierStack::shapeModifierStack() : numStacks(0), numModifiers(0) {
+
+}
+
+void shapeModifierStack::clear(){
+	for(unsigned int i=0; i<numStacks; ++i){
+		stacks[i].modifiers.clear();
+	}
+	numStacks = 0;
+	numModifiers = 0;
+	stackIndex.clear();
+}
+
+void shapeModifierStack::add( const basicEffect& _effect ){
+	const vector<shapeModifier>& modifiers = _effect.getModifiers();
+	if( modifiers.empty() || !_effect.isReady() ) return;
+	
+	unsigned int spanNumber = 0;
+	const vector<basicShape*>& shapes = _effect.getShapes();
+	for(auto it=shapes.cbegin(); it!=shapes.cend(); ++it){
+		if( !(*it)->isReady() || !(*it)->isType("vertexShape") ) continue;
+		
+		auto found = stackIndex.find( *it );
+		unsigned int index = 0;
+		if( found == stackIndex.end() ){
+			index = numStacks++;
+			if( stacks.size() < numStacks ) stacks.resize( numStacks );
+			stacks[index].shape = (vertexShape*) (*it);
+			stackIndex[ *it ] = index;
+		}
+		else index = found->second;
+		
+		vector<stackedModifier>& stack = stacks[index].modifiers;
+		for(auto m=modifiers.cbegin(); m!=modifiers.cend(); ++m){
+			stackedModifier entry;
+			entry.modifier = &(*m);
+			entry.spanNumber = spanNumber;
+			stack.push_back( entry );
+			numModifiers++;
+		}
+		spanNumber++;
+	}
+}
+
+void shapeModifierStack::evaluate( const animationParams& _params, karmaThreadPool* _pool ){
+	if( _pool == nullptr || numStacks <= KM_MODIFIER_STACK_CHUNK ){
+		evaluate( 0, numStacks, _params );
+		return;
+	}
+	
+	karmaTaskGroup group;
+	for(unsigned int begin=0; begin<numStacks; begin+=KM_MODIFIER_STACK_CHUNK){
+		unsigned int end = MIN( begin+KM_MODIFIER_STACK_CHUNK, numStacks );
+		_pool->run( group, [this, begin, end, &_params](){
+			evaluate( begin, end, _params );
+		});
+	}
+	_pool->wait( group );
+}
+
+// shapes don't share anything, chunks can run concurrently
+void shapeModifierStack::evaluate( unsigned int _begin, unsigned int _end, const animationParams& _params ){
+	vector<vertexSpan> span(1);
+	
+	for(unsigned int i=_begin; i<_end; ++i){
+		shapeStack& stack = stacks[i];
+		span[0] = stack.shape->getVertices( POINT_POSITION_RELATIVE );
+		
+		for(auto m=stack.modifiers.cbegin(); m!=stack.modifiers.cend(); ++m){
+			deformationKernels::apply( span, m->modifier->deformation, _params, m->modifier->amount, m->spanNumber );
+		}
+		
+		// derived data, once
+		stack.shape->onShapeModified();
+	}
+}
+
+unsigned int shapeModifierStack::getNumShapes() const {
+	return numStacks;
+}
+
+unsigned int shapeModifierStack::getNumModifiers() const {
+	return numModifiers;
+}
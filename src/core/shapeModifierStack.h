@@ -0,0 +1,49 @@
+//
+//  shapeModifierStack.h
+//  karmaMapper
+//
+//	Collects the modifiers effects asked for during their update into one stack per vertex shape, in layer & effect order.
+//	Each shape's stack is then applied in one go while its vertices are hot, and the derived data (absolute vertices, bounding box) is computed once.
+//	So the result doesn't depend on which parallel update finished first, and N deforming effects cost one pass instead of N.
+//
+
+#pragma once
+
+#include "ofMain.h"
+#include "basicEffect.h"
+#include "vertexShape.h"
+#include "deformationKernels.h"
+#include "karmaThreadPool.h"
+
+class shapeModifierStack {
+public:
+	shapeModifierStack();
+	
+	// call clear(), then add() the effects in evaluation order once they're all updated
+	void clear();
+	void add( const basicEffect& _effect );
+	
+	// applies the stacks, shapes are spread over the pool if there's one
+	void evaluate( const animationParams& _params, karmaThreadPool* _pool = nullptr );
+	
+	unsigned int getNumShapes() const; // since clear()
+	unsigned int getNumModifiers() const;
+
+private:
+	struct stackedModifier {
+		const shapeModifier* modifier; // owned by the effect, valid until its next update
+		unsigned int spanNumber; // rank of the shape in the effect, for phase offsets
+	};
+	
+	struct shapeStack {
+		vertexShape* shape = nullptr;
+		vector<stackedModifier> modifiers; // re-used
+	};
+	
+	void evaluate( unsigned int _begin, unsigned int _end, const animationParams& _params );
+	
+	vector<shapeStack> stacks; // entries are re-used across frames, numStacks are in use
+	unsigned int numStacks;
+	unsigned int numModifiers;
+	unordered_map<basicShape*, unsigned int> stackIndex;
+};
@@ -11,6 +11,7 @@
 //
 
 #include "basicEffect.h"
+#include <atomic>
 
 // - - - - - - -
 // CONSTRUCTORS
@@ -18,6 +19,9 @@
 
 basicEffect::basicEffect(){
 	
+	effectIndex = 0;
+	revision = 0;
+	qualityLevel = 0;
 	basicEffect::reset();
 	
 	// effect type must match with class
@@ -81,9 +85,7 @@ bool basicEffect::render(karmaFboLayer& renderLayer, const animationParams& para
 	if(overallBoundingBox.width > 0) ofDrawRectangle( overallBoundingBox );
 	
 	// by default, basicEffect uses the shape's default rendering mode
-	for(int i=0; i<shapes.size(); i++){
-		shapes[i]->sendToGPU();
-	}
+	shapesBatcher::getInstance().draw( shapeBatch, shapes, nullptr, getLodError() );
 	
 	ofPopStyle();
 	
@@ -98,8 +100,21 @@ bool basicEffect::render(karmaFboLayer& renderLayer, const animationParams& para
 void basicEffect::update(karmaFboLayer& renderLayer, const animationParams& params){
 	ofScopedLock lock(effectMutex);
 	
+	modifiers.clear();
+	
 	if( !isReady() ) return;
-	aliveSince = ofGetSystemTime() - startTime;
+	
+	// first update since reset()
+	if( startTime < 0 ){
+		startTime = params.elapsedTime;
+		random.seed( params.seed ^ karmaRandom::hash( effectName ), effectIndex );
+	}
+	aliveSince = (params.elapsedTime - startTime)*1000;
+}
+
+// basicEffect's render() only draws the committed shapes
+bool basicEffect::canUpdateAheadOfRender() const {
+	return effectType=="basicEffect";
 }
 
 // Usefull ?
@@ -113,10 +128,11 @@ void basicEffect::reset(){
 	
 	// todo: do this in _reset() which then calls reset();
 	aliveSince=0;
-	startTime=ofGetSystemTime();
+	startTime=-1;
 
 	shapes.clear();
 	shapes.resize(0);
+	modifiers.clear();
 	
 	bInitialised = true;
 	bHasError = false;
@@ -127,14 +143,18 @@ void basicEffect::reset(){
 	bUsePingpong = false;
 	
 	overallBoundingBox = ofRectangle(0,0,0,0);
+	
+	markOutputChanged();
 }
 
 void basicEffect::enable(){
 	bEnabled=true;
+	markOutputChanged();
 }
 
 void basicEffect::disable(){
 	bEnabled=false;
+	markOutputChanged();
 }
 
 void basicEffect::setShowGuiWindow(const bool &_b){
@@ -177,6 +197,10 @@ bool basicEffect::showGuiWindow( const shapesDB& _scene ) {
 	
 	ImGui::ColorEdit4("Effect Color", &mainColor[0]);
 	
+	if( getMaxQualityLevel() > 0 ){
+		ImGui::TextDisabled("Quality level: %u / %u%s", qualityLevel, getMaxQualityLevel(), (qualityLevel>0)?" (lowered to keep the frame rate)":"" );
+	}
+	
 	ImGui::Spacing();
 	ImGui::Spacing();
 	
@@ -212,7 +236,7 @@ bool basicEffect::showGuiWindow( const shapesDB& _scene ) {
 			}
 			
 			else {
-				auto groups = _scene.getAllShapesByGroup();
+				const auto& groups = _scene.getAllShapesByGroup();
 				for (auto g=groups.cbegin(); g!=groups.cend(); ++g){
 					if( ImGui::Selectable( ofToString(g->first).c_str(), false) ){
 						for( auto s=g->second.cbegin(); s!=g->second.cend(); ++s ){
@@ -253,6 +277,11 @@ bool basicEffect::showGuiWindow( const shapesDB& _scene ) {
 	
 	printCustomEffectGui();
 	
+	// any interaction with the settings can change the output
+	if( ImGui::IsWindowFocused() && ImGui::IsAnyItemActive() ){
+		markOutputChanged();
+	}
+	
 	// spacing
 	ImGui::Text(" ");
 	
@@ -284,19 +313,7 @@ bool basicEffect::saveToXML(ofxXmlSettings& xml) const{
 		xml.popTag();
 	}
 	
-	// remember bound shapes
-	xml.addTag("boundShapes");
-	xml.pushTag("boundShapes");
-	int s = 0;
-	for(auto it=shapes.cbegin(); it!=shapes.cend(); ++it){
-		
-		xml.addValue("shape", (*it)->getName() );
-		xml.addAttribute("shape", "type", (*it)->getShapeType(), s);
-		xml.addAttribute("shape", "name", (*it)->getName(), s);
-		
-		s++;
-	}
-	xml.popTag(); // pop boundShapes
+	// bound shapes are streamed, see saveBoundShapes()
 	
 	//xml.addValue("groupID", getGroupID() );
 	//xml.addValue("shapeName", shapeName );
@@ -322,9 +339,39 @@ bool basicEffect::loadFromXML(ofxXmlSettings& xml){
 		xml.popTag();
 	}
 	
+	markOutputChanged();
+	
 	return true; // todo
 }
 
+// remember bound shapes
+bool basicEffect::saveBoundShapes( karmaXmlWriter& _xml ) const {
+	_xml.beginElement("boundShapes");
+	for(auto it=shapes.cbegin(); it!=shapes.cend(); ++it){
+		_xml.beginElement("shape");
+		_xml.addAttribute("type", (*it)->getShapeType() );
+		_xml.addAttribute("name", (*it)->getName() );
+		_xml.endElement();
+	}
+	_xml.endElement();
+	
+	return true;
+}
+
+bool basicEffect::onXmlElementStart( const karmaXmlElement& _element ){
+	// the controller binds the shapes
+	return !( _element.getDepth() == 1 && _element.is("boundShapes") );
+}
+
+bool basicEffect::onXmlElementEnd( const karmaXmlElement& _element ){
+	if( _element.getDepth() != 0 ) return true;
+	
+	// already checked by the stream reader, empty elements give an empty document
+	ofxXmlSettings xml;
+	xml.loadFromBuffer( _element.getInnerSource("boundShapes") );
+	return loadFromXML( xml );
+}
+
 
 // - - - - - - -
 // EFFECT PROPERTIES
@@ -338,7 +385,7 @@ bool basicEffect::isLoading() const {
 	return bInitialised && bIsLoading;
 }
 
-string basicEffect::getName() const {
+const string& basicEffect::getName() const {
 	return effectName;
 }
 
@@ -363,11 +410,62 @@ const int& basicEffect::getIndex() const {
 	return effectIndex;
 }
 
+const vector<shapeModifier>& basicEffect::getModifiers() const {
+	return modifiers;
+}
+
+void basicEffect::addModifier( const deformationSettings& _deformation, float _amount ){
+	if( _deformation.type == DEFORM_NONE ) return;
+	
+	modifiers.emplace_back();
+	modifiers.back().deformation = _deformation;
+	modifiers.back().amount = _amount;
+}
+
+unsigned int basicEffect::getRevision() const {
+	return revision;
+}
+
+void basicEffect::setQualityLevel( unsigned int _level ){
+	if( _level > getMaxQualityLevel() ) _level = getMaxQualityLevel();
+	if( _level == qualityLevel ) return;
+	
+	qualityLevel = _level;
+	onQualityLevelChanged();
+	markOutputChanged();
+}
+
+void basicEffect::clampQualityLevel(){
+	if( qualityLevel > getMaxQualityLevel() ) setQualityLevel( getMaxQualityLevel() );
+}
+
+unsigned int basicEffect::getQualityLevel() const {
+	return qualityLevel;
+}
+
+float basicEffect::getLodError() const {
+	float error = shapeGeometryLibrary::getInstance().getLodMaxError();
+	if( qualityLevel == 0 ) return error;
+	
+	return MAX( error, KM_SHAPE_LOD_TOLERANCE ) * (1 << qualityLevel);
+}
+
+float basicEffect::getQualityFactor() const {
+	return 1.f/(1 << qualityLevel);
+}
+
+void basicEffect::markOutputChanged(){
+	// unique across effects, a new effect can't look like a deleted one
+	static std::atomic<unsigned int> revisionCounter(0);
+	revision = ++revisionCounter;
+}
+
 // - - - - - - -
 // CONTROLLER FUNCTIONS
 // - - - - - - -
 
 bool basicEffect::randomizePresets(){
+	markOutputChanged();
 	return true;
 }
 
@@ -382,7 +480,9 @@ bool basicEffect::usesPingPong() const {
 
 bool basicEffect::setUsePingPong(const bool& _usePingpong){
 	bUsePingpong = _usePingpong;
-
+	clampQualityLevel(); // might have been a quality step
+	markOutputChanged();
+	
 	return true;
 }
 
@@ -395,26 +495,15 @@ void basicEffect::updateBoundingBox(){
 		return;
 	}
 	
-	// cache variables
-	ofVec2f LTCorner( ofGetWidth(), ofGetHeight() );
-	ofVec2f RBCorner( 0, 0);
-	
 	// analyse all contained boundingBoxes
-	for(int i=shapes.size()-1; i>=0; i--){
-		if( !shapes[i]->isReady() ) continue;
-		
-		// cache needed vars
-		ofVec2f tmpLTCorner( shapes[i]->getBoundingBox().x, shapes[i]->getBoundingBox().y);
-		ofVec2f tmpRBCorner( shapes[i]->getBoundingBox().x+shapes[i]->getBoundingBox().width, shapes[i]->getBoundingBox().y+shapes[i]->getBoundingBox().height);
-		
-		if(tmpLTCorner.x < LTCorner.x) LTCorner.x = tmpLTCorner.x;
-		if(tmpLTCorner.y < LTCorner.y) LTCorner.y = tmpLTCorner.y;
-		if(tmpRBCorner.x < RBCorner.x) RBCorner.x = tmpRBCorner.x;
-		if(tmpRBCorner.y < RBCorner.y) RBCorner.y = tmpRBCorner.y;
+	shapeBoxes.clear();
+	for(auto it=shapes.cbegin(); it!=shapes.cend(); ++it){
+		if( (*it)->isReady() ) shapeBoxes.push_back( (*it)->getBoundingBox() );
 	}
 	
-	overallBoundingBox = ofRectangle( LTCorner.x, LTCorner.y-LTCorner.x, RBCorner.x, RBCorner.y-LTCorner.y);
-	
+	if( !vertexKernels::getBounds( shapeBoxes, overallBoundingBox ) ){
+		overallBoundingBox = ofRectangle( ofGetWidth()/2, ofGetHeight()/2, 0, 0);
+	}
 }
 
 // - - - - - - -
@@ -433,6 +522,7 @@ bool basicEffect::bindWithShape(basicShape* _shape){
 	shapes.insert(shapes.end(), _shape);
 	
 	updateBoundingBox();
+	markOutputChanged();
 	
 	return true;
 }
@@ -475,6 +565,7 @@ bool basicEffect::bindWithShapes(list<basicShape *>& _shapes){
 	}
 	
 	updateBoundingBox();
+	markOutputChanged();
 	
 	return success;
 }
@@ -490,6 +581,7 @@ bool basicEffect::detachFromAllShapes(){
 	for(int i=shapes.size()-1; i>=0; i--){
 		shapes.erase(shapes.begin()+i);
 	}
+	markOutputChanged();
 	
 	return (shapes.size()==0); // should always be true
 }
@@ -505,6 +597,7 @@ bool basicEffect::detachFromShape(basicShape* _shape){
 	for(auto it=shapes.begin(); it!=shapes.end(); ++it){
 		if( (*it)!=NULL && _shape == (*it) ){
 			shapes.erase(it);
+			markOutputChanged();
 			break;
 		}
 	}
@@ -519,6 +612,10 @@ int basicEffect::getNumShapes() const{
 	return shapes.size();
 }
 
+const vector<basicShape*>& basicEffect::getShapes() const {
+	return shapes;
+}
+
 
 // Bind with factory
 namespace effect
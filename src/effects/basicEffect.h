@@ -15,12 +15,25 @@
 #include "ofxImGui.h"
 #include "shapesDB.h"
 #include "karmaFboLayer.h"
+#include "karmaRandom.h"
+#include "shapesBatcher.h"
+#include "vertexKernels.h"
+#include "deformationKernels.h"
+#include "karmaXml.h"
 //#include "shapesServer.h"
 
 namespace karmaThreadsSharedMemory {
 	
 }
 
+// what an effect's rendered output depends on (flags)
+// used by the controller to skip re-rendering layers that didn't change
+enum effectOutputDependency {
+	EFFECT_OUTPUT_STATIC = 0, // only its own settings
+	EFFECT_OUTPUT_USES_SHAPES = 1 << 0, // geometry of the bound shapes
+	EFFECT_OUTPUT_USES_TIME = 1 << 1 // anything changing on its own: time, animationParams, audio, randomness, feedback...
+};
+
 // Basic parent class for effects
 
 // todo: make a better hasError collection + notification system
@@ -71,7 +84,7 @@ namespace karmaThreadsSharedMemory {
 // forward declaration
 struct animationParams;
 
-class basicEffect {
+class basicEffect : public karmaXmlVisitor {
 	
 public:
 	// constructors
@@ -84,6 +97,38 @@ public:
 	virtual bool render(karmaFboLayer& renderLayer, const animationParams& params);
 	virtual void update(karmaFboLayer& renderLayer, const animationParams& params);
 	//virtual void update();
+	
+	// parallel updates
+	// return true if update() can run on a worker thread: no GL calls, no shared globals (ofRandom, ...) and only altering the shapes listed in getShapeWriteSet()
+	virtual bool canUpdateInParallel() const { return false; }
+	virtual void getShapeWriteSet( vector<basicShape*>& _shapes ) const {}
+	
+	// deformations requested by the last update(), for all bound vertex shapes (see addModifier())
+	const vector<shapeModifier>& getModifiers() const;
+	// return true if update() can run on a worker while the previous frame renders: no GL calls in update(),
+	// render() only reads committed shape data (getRender*()) and what commitRenderState() copied.
+	// Subclasses have to opt in.
+	virtual bool canUpdateAheadOfRender() const;
+	// copies what render() needs from the last update(), main thread, once the update is final
+	virtual void commitRenderState() {}
+	
+	// layer caching
+	// effectOutputDependency flags. Defaults to time so effects which don't tell are always rendered.
+	virtual unsigned int getOutputDependencies() const { return EFFECT_OUTPUT_USES_TIME; }
+	// changes whenever a setting altering the output changes
+	unsigned int getRevision() const;
+	
+	// adaptive quality (see karmaFrameGovernor)
+	// 0 is full quality, each level above is cheaper to run. 0 levels = not adjustable.
+	virtual unsigned int getMaxQualityLevel() const { return 0; }
+	void setQualityLevel( unsigned int _level );
+	unsigned int getQualityLevel() const;
+	// simplification error (px) for drawing shapes: the global one, doubled by each quality level
+	float getLodError() const;
+	
+	// bytes of textures, FBOs & co the effect holds, for preloading budgets (see configurationLoader::preload())
+	virtual size_t getMemoryEstimate() const { return 0; }
+	
 	virtual void reset();
 	void enable();
 	void disable();
@@ -100,11 +145,18 @@ public:
 	// LOAD & SAVE FUNCTIONS
 	virtual bool saveToXML(ofxXmlSettings& xml ) const;
 	virtual bool loadFromXML(ofxXmlSettings& xml);
+	// <boundShapes>, written and bound by the controller
+	bool saveBoundShapes( karmaXmlWriter& _xml ) const;
+	// streamed loading, the controller passes the <effect> element (depth 0) and its children.
+	// By default the element (without <boundShapes>) goes to loadFromXML() as a small ofxXmlSettings document.
+	// Effects can override these to read their settings straight from the stream.
+	virtual bool onXmlElementStart( const karmaXmlElement& _element );
+	virtual bool onXmlElementEnd( const karmaXmlElement& _element );
 	
 	// effect properties
 	bool isReady() const;
 	bool isLoading() const;
-	string getName() const;
+	const string& getName() const;
 	bool isType(const string _type) const;
 	string getType() const;
 	virtual const string getShortStatus()const;
@@ -132,13 +184,14 @@ public:
 	bool detachFromAllShapes();
 	bool detachFromShape(basicShape* _shape);
 	int getNumShapes() const;
+	const vector<basicShape*>& getShapes() const;
 	
 	// todo
 	// overallBoundingBox getter
 	
 	// todo: make this read-only
-	unsigned int aliveSince;
-	unsigned long long startTime; // to compare against ofGetSystemTime();
+	unsigned int aliveSince; // ms, on the animation clock
+	float startTime; // animation clock time (sec) of the first update after reset(), -1 until then
 	
 	static bool orderByIndex (const basicEffect* first, const basicEffect* second){
 		return ( first->getIndex() < second->getIndex() );
@@ -165,12 +218,37 @@ protected:
 	// animation preferences class
 	
 	vector<basicShape*> shapes;
+	shapesBatch shapeBatch; // draws shapes in one call, see shapesBatcher::draw()
+	
+	// use this rather than ofRandom() so effects replay identically
+	// seeded from animationParams::seed and the effect's name on the first update after reset()
+	karmaRandom random;
+	
+	// call when something changes render() output, invalidates cached layers
+	void markOutputChanged();
+	
+	// rather than altering the shapes in update(), deforming effects can add modifiers there
+	// the controller stacks them per shape in layer & effect order and applies them in one pass (see shapeModifierStack)
+	// basicEffect::update() clears them. Shapes don't need to be in the write set.
+	void addModifier( const deformationSettings& _deformation, float _amount = 1.f );
+	vector<shapeModifier> modifiers;
+	
+	// called after the quality level changed, apply it here
+	virtual void onQualityLevelChanged(){}
+	// call when settings changed getMaxQualityLevel(), lowers the level if it's above
+	void clampQualityLevel();
+	// 1, 1/2, 1/4... for scaling instance counts with the quality level
+	float getQualityFactor() const;
+	unsigned int qualityLevel;
 	
 	ofRectangle overallBoundingBox; // computes boundingbox containing all shapes
+	vector<ofRectangle> shapeBoxes; // re-used by the bounding box functions
 	//ofPlanePrimitive
 	ofMutex effectMutex;
 	
-//private:
+private:
+	unsigned int revision; // see markOutputChanged()
+	
 	// todo: implement something to make threads safer
 	// maybe a class like this to hold any shared data ?
 	// http://stackoverflow.com/a/13300836/58565
@@ -95,36 +95,17 @@ void distortEffect::update(karmaFboLayer& renderLayer, const animationParams& pa
 	
 	if(shapes.size()<1) return;
 	
-	int offset = 0;
-	for(auto it=shapes.begin(); it!=shapes.end(); it++){
-		if( !(*it)->isReady() ) continue;
-		
-		if( (*it)->isType("vertexShape") ){
-			
-			// todo: basicEffect should have a nice downcast getter function like .asType<vertexShape>()
-			list<basicPoint>& pts = ((vertexShape*)(*it))->getPoints(POINT_POSITION_RELATIVE);
-		
-			if( bVariateInSeason ){
-				
-				for(auto itb=pts.begin(); itb!=pts.end(); ++itb){
-					(*itb) += basicPoint(
-						( sin( params.elapsedTime *(TWO_PI+(offset/3%4)))*25 + cos( params.elapsedTime* (TWO_PI+(offset/5%8)/4))*25) * (params.seasons[seasonVariation] *0.9f + 0.05f),
-						( cos( params.elapsedTime *(TWO_PI+(offset/4%7)))*25 - sin( params.elapsedTime* (TWO_PI+(offset/8%3)))*25) * (params.seasons[seasonVariation]*0.9f + 0.05f)
-					);
-					offset++;
-				}
-				
-			}
-			else if( bReactToBpm && BPMCurrentMagnitude>0 ){
-				for(auto itb=pts.begin(); itb!=pts.end(); ++itb){
-					(*itb) *= 1+0.1*BPMCurrentMagnitude;
-				}
-				
-				BPMCurrentMagnitude -= 0.01f; // todo: make this time-based ?
-			}
-			
-			(*it)->onShapeModified();
-		}
+	// the controller applies these to the bound vertex shapes
+	if( deformation.type != DEFORM_NONE ){
+		const float amount = bVariateInSeason ? params.seasons[seasonVariation]*0.9f + 0.05f : 1.f;
+		addModifier( deformation, amount );
+	}
+	if( bReactToBpm && BPMCurrentMagnitude>0 && ( bStackBpmScale || deformation.type == DEFORM_NONE ) ){
+		deformationSettings bpmScale;
+		bpmScale.type = DEFORM_SCALE;
+		bpmScale.amplitude = 0.1f*BPMCurrentMagnitude;
+		addModifier( bpmScale );
+		BPMCurrentMagnitude -= 0.01f; // todo: make this time-based ?
 	}
 }
 
@@ -132,9 +113,11 @@ void distortEffect::update(karmaFboLayer& renderLayer, const animationParams& pa
 void distortEffect::reset(){
 	basicEffect::reset();
 	
+	deformation = deformationSettings();
 	bVariateInSeason = false;
 	seasonVariation = 1;
 	bReactToBpm = true;
+	bStackBpmScale = false;
 	BPMMetronom = 1;
 	BPMCurrentMagnitude = 0;
 	
@@ -153,15 +136,30 @@ bool distortEffect::printCustomEffectGui(){
 		
 		ImGui::TextWrapped("This effect alters the points of a vertex shape.");
 		
-		ImGui::Checkbox("Move in seasons.", &bVariateInSeason );
-		if(bVariateInSeason){
-			ImGui::SliderInt("Season #", &seasonVariation, 0, 3);
+		if( ImGui::ListBoxHeader("Deformation", DEFORM_TWIST+1) ){
+			for(int i=DEFORM_NONE; i<=DEFORM_TWIST; ++i){
+				if( ImGui::Selectable( deformationKernels::getName((deformationType)i), deformation.type == i ) ){
+					deformation.type = (deformationType)i;
+				}
+			}
+			ImGui::ListBoxFooter();
+		}
+		if( deformation.type != DEFORM_NONE ){
+			ImGui::DragFloat( deformation.type == DEFORM_TWIST ? "Angle (rad)" : "Amplitude (px)", &deformation.amplitude, deformation.type == DEFORM_TWIST ? 0.01f : 0.5f );
+			ImGui::DragFloat("Frequency (rad/px)", &deformation.frequency, 0.001f, 0.f, 1.f);
+			ImGui::DragFloat("Speed (Hz)", &deformation.speed, 0.01f);
+			
+			ImGui::Checkbox("Move in seasons.", &bVariateInSeason );
+			if(bVariateInSeason){
+				ImGui::SliderInt("Season #", &seasonVariation, 0, 3);
+			}
 		}
 		ImGui::Checkbox("React to BPM.", &bReactToBpm );
 		if(bReactToBpm){
 			ImGui::DragInt("BPM time mesure", &BPMMetronom, 1);
 			//BPMCurrentMagnitude
 			ImGui::DragFloat("BPM Magnitude", &BPMMagnitude, 0.05);
+			ImGui::Checkbox("Scale on top of the deformation", &bStackBpmScale );
 			
 		}
 	}
@@ -177,10 +175,16 @@ bool distortEffect::printCustomEffectGui(){
 bool distortEffect::saveToXML(ofxXmlSettings& xml) const{
 	bool ret = basicEffect::saveToXML(xml);
 	
+	xml.addValue("DeformationType", (int) deformation.type);
+	xml.addValue("DeformationAmplitude", deformation.amplitude);
+	xml.addValue("DeformationFrequency", deformation.frequency);
+	xml.addValue("DeformationSpeed", deformation.speed);
+	
 	xml.addValue("VariateInSeason", bVariateInSeason);
 	xml.addValue("SeasonNb", seasonVariation);
 	
 	xml.addValue("ReactToBPM", bReactToBpm);
+	xml.addValue("StackBPMScale", bStackBpmScale);
 	xml.addValue("BPMMetronom", BPMMetronom);
 	xml.addValue("BPMMagnitude", BPMMagnitude);
 	
@@ -195,7 +199,15 @@ bool distortEffect::loadFromXML(ofxXmlSettings& xml){
 	bVariateInSeason = xml.getValue("VariateInSeason", false);
 	seasonVariation = xml.getValue("SeasonNb", 0);
 	
+	// older files only had the seasons wobble
+	deformationSettings defaults;
+	deformation.type = (deformationType) ofClamp( xml.getValue("DeformationType", bVariateInSeason ? DEFORM_NOISE : DEFORM_NONE ), DEFORM_NONE, DEFORM_TWIST );
+	deformation.amplitude = xml.getValue("DeformationAmplitude", defaults.amplitude );
+	deformation.frequency = xml.getValue("DeformationFrequency", defaults.frequency );
+	deformation.speed = xml.getValue("DeformationSpeed", defaults.speed );
+	
 	bReactToBpm = xml.getValue("ReactToBPM", true);
+	bStackBpmScale = xml.getValue("StackBPMScale", false);
 	BPMMetronom = xml.getValue("BPMMetronom", 1);
 	BPMMagnitude = xml.getValue("BPMMagnitude", 1);
 	BPMCurrentMagnitude = 0;
@@ -15,6 +15,7 @@
 #include "basicEffect.h"
 #include "animationParams.h"
 #include "mirReceiver.h"
+#include "deformationKernels.h"
 
 struct animationParams;
 
@@ -31,6 +32,12 @@ public:
 	void update(karmaFboLayer& renderLayer, const animationParams& params);
 	void reset();
 	
+	// deforms through modifiers, doesn't write shapes itself
+	virtual bool canUpdateInParallel() const { return true; }
+	virtual bool canUpdateAheadOfRender() const { return true; }
+	// only alters shapes, doesn't draw
+	virtual unsigned int getOutputDependencies() const { return EFFECT_OUTPUT_STATIC; }
+	
 	// #########
 	// GUI STUFF
 	virtual bool printCustomEffectGui();
@@ -47,10 +54,12 @@ public:
 	
 	
 protected:
-	bool bVariateInSeason;
+	deformationSettings deformation;
+	bool bVariateInSeason; // scales the deformation
 	int seasonVariation; // season number
 	//int
 	bool bReactToBpm;
+	bool bStackBpmScale; // false: no BPM scaling while deforming (like older versions)
 	int BPMMetronom;
 	float BPMMagnitude;
 	float BPMCurrentMagnitude;
@@ -64,9 +64,7 @@ bool gpuGlitchEffect::render(karmaFboLayer& renderLayer, const animationParams &
 		fbo.getTexture().bind(); // todo, doesn't work... need to use a shader here ?
 		
 		// draw shape so GPU gets their vertex data
-		for(auto it=shapes.begin(); it!=shapes.end(); ++it){
-			(*it)->sendToGPU();
-		}
+		shapesBatcher::getInstance().draw( shapeBatch, shapes, nullptr, getLodError() );
 		
 		fbo.getTexture().unbind();
 		
@@ -112,16 +110,25 @@ void gpuGlitchEffect::reset(){
 	effectMutex.unlock();
 }
 
+size_t gpuGlitchEffect::getMemoryEstimate() const {
+	if( !fbo.isAllocated() ) return 0;
+	return (size_t) fbo.getWidth() * fbo.getHeight() * 4 * MAX(1, fboSettings.numSamples);
+}
+
 // - - - - - - -
 // GPUGLITCHEFFECT METHODS
 // - - - - - - -
 void gpuGlitchEffect::refreshGlitches(){
 	fbo.clear();
 	
-	int cnt = 1+ofRandomuf()*maxAllocations;
-	vector<ofFbo> tmpFbos(cnt);
-	for( auto it=tmpFbos.begin(); it!=tmpFbos.end(); ++it){
-		it->allocate(round(fbo.getWidth()*(0.5+ofRandomuf()/2.0) ), round(fbo.getHeight()*(0.5+ofRandomuf()/2.0) ));
+	// temporary allocations shuffle the GPU memory around
+	// not pooled: they're freed right away so the fbo below lands on their uninitialised memory
+	{
+		int cnt = 1+ofRandomuf()*maxAllocations;
+		vector<ofFbo> tmpFbos(cnt);
+		for( auto it=tmpFbos.begin(); it!=tmpFbos.end(); ++it){
+			it->allocate(round(fboSettings.width*(0.5+ofRandomuf()/2.0) ), round(fboSettings.height*(0.5+ofRandomuf()/2.0) ));
+		}
 	}
 //	while(cnt >= 1){
 //		
@@ -36,6 +36,7 @@ public:
 	bool render(karmaFboLayer& renderLayer, const animationParams& params);
 	void update(karmaFboLayer& renderLayer, const animationParams& params);
 	void reset();
+	virtual size_t getMemoryEstimate() const;
 	
 	// #########
 	// GPUGLITCHEFFECT METHODS
@@ -51,7 +52,7 @@ public:
 	virtual bool loadFromXML(ofxXmlSettings& xml);
 	
 protected:
-	ofFbo fbo;
+	ofFbo fbo; // not pooled, it has to land on uninitialised memory
 	ofFbo::Settings fboSettings;
 	int maxAllocations;
 	
@@ -165,7 +165,7 @@ bool imageBeatEffect::grabSomeShapes(){
 imageBeatEffectItem imageBeatEffect::getRandomBeatItem(){
 	//ofScopedLock lock(effectMutex);
 	
-	basicShape* shape = shapes[ round( ofRandom(-0.49f,shapes.size()-0.51f)) ];
+	basicShape* shape = shapes[ random.getIndex( shapes.size() ) ];
 
 	// return
 	return imageBeatEffectItem( shape );
@@ -208,9 +208,7 @@ void imageBeatEffect::onSetEventListener(mirOnSetEventArgs &_args){
 		if(amount > 20) amount = 20;
 		for(int i=0; i<amount;i++){
 			basicShape* shape;
-			int rand = round( ofRandom(-0.49f, shapes.size()-0.51f ) );
-			//cout << rand << endl;
-			shape = shapes[ rand ];
+			shape = shapes[ random.getIndex( shapes.size() ) ];
 			beatsToAdd.push_back(shape);
 		}
 			
@@ -79,7 +79,7 @@ void imageGrainEffect::update(){
 	
 	//if( shapes.size()==0 ) return;
 
-	basicPoint* shapePos = shapes[round(ofRandom(0, shapes.size()-.51f))]->getPositionPtr();
+	basicPoint* shapePos = shapes[ random.getIndex( shapes.size() ) ]->getPositionPtr();
 	if( items.size() < 20 && ofRandom(0,5)>3 ) items.push_back(imageGrainItem(ofPoint(shapePos->x, shapePos->y)));
 	
 	for(int i=items.size()-1; i>=0; i--){
@@ -85,7 +85,7 @@ void imageMeltingEffect::update(){
 	// add item if volume peak detected
 	if( volume > lastVolumePeakAmount*1.6f ){
 		lastVolumePeakAmount = volume;
-		int randomShape = round(ofRandom(0, shapes.size()-0.51f));
+		int randomShape = random.getIndex( shapes.size() );
 		
 		// add a texture for the shape ?
 		if( shapeTextures.find(randomShape) == shapeTextures.end() ){
@@ -34,6 +34,7 @@ public:
 	bool render(karmaFboLayer& renderLayer, const animationParams& params);
 	void update(karmaFboLayer& renderLayer, const animationParams& params);
 	void reset();
+	virtual unsigned int getOutputDependencies() const { return EFFECT_OUTPUT_STATIC; } // draws nothing yet
 	
 	// #########
 	// GUI STUFF
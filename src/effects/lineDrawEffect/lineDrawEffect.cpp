@@ -50,7 +50,8 @@ bool lineDrawEffect::render(karmaFboLayer& renderLayer, const animationParams &p
 	ofNoFill();
 	
 	// draw shape so GPU gets their vertex data
-	for(auto it=lines.begin(); it!=lines.end(); ++it){
+	// (only changes in commitRenderState())
+	for(auto it=renderLines.cbegin(); it!=renderLines.cend(); ++it){
 		(*it).render();
 	}
 	ofPopStyle();
@@ -73,39 +74,37 @@ void lineDrawEffect::update(karmaFboLayer& renderLayer, const animationParams& p
 	// do basic Effect function
 	basicEffect::update( renderLayer, params );
 	
+	ofScopedLock lock(effectMutex);
+	
+	// the frame governor lowers the amount of lines when frames get too slow
 	if(bStressTestMode){
-		if( params.fps >= fStressTestTargetFPS){
-			fStressTestMultiplier += (params.idleTimeMillis/(1000.0/fStressTestTargetFPS))*fStressTestAddTolerance;
-			//cout << fStressTestMultiplier << endl;
-		}
-		else {
-			fStressTestMultiplier -= (fStressTestTargetFPS-params.fps)*fStressTestRemoveTolerance;
-		}
-		if(fStressTestMultiplier<0) fStressTestMultiplier=0;
+		int numLines = ceil( iStressTestLines*getQualityFactor() );
 		
-			
 		for(auto s=shapes.begin(); s!=shapes.end(); ++s){
 			if( (*s)->isType("vertexShape") ){
 				vertexShape* shape = (vertexShape*) *s;
-				for(int i=0; i<fStressTestMultiplier; ++i){
-					lines.push_back( lineDrawEffectLine( shape, fLineBeatDuration, ofColor(mainColor[0]*255, mainColor[1]*255,mainColor[2]*255, mainColor[3]*255) ) );
+				for(int i=0; i<numLines; ++i){
+					lines.push_back( lineDrawEffectLine( shape, fLineBeatDuration, ofColor(mainColor[0]*255, mainColor[1]*255,mainColor[2]*255, mainColor[3]*255), random ) );
 				}
 			}
 		}
 	}
 	
-	// check for dead lines
-	for(auto it=lines.rbegin(); it!= lines.rend(); it--){
+	// age lines, remove dead ones
+	for(auto it=lines.begin(); it!=lines.end(); ){
+		(*it).update( params );
 		
-		// remve dead ones
-		if( !(*it).isAlive() ) {
-			it++;
-			it= std::list<lineDrawEffectLine>::reverse_iterator( lines.erase( it.base() ));
-			it--;
-		}
+		if( (*it).isAlive() ) ++it;
+		else it = lines.erase( it );
 	}
 }
 
+// the next update() can run while render() draws this copy
+void lineDrawEffect::commitRenderState(){
+	ofScopedLock lock(effectMutex);
+	renderLines.assign( lines.begin(), lines.end() );
+}
+
 // resets all values
 void lineDrawEffect::reset(){
 	basicEffect::reset();
@@ -116,10 +115,7 @@ void lineDrawEffect::reset(){
 	fLineBeatDuration = 1.0;
 	
 	bStressTestMode = true; // tmp
-	fStressTestMultiplier = 1;
-	fStressTestAddTolerance = 0.01;
-	fStressTestRemoveTolerance = 0.28;
-	fStressTestTargetFPS = 60;
+	iStressTestLines = 8;
 	
 	// do stuff
 	ofEnableAlphaBlending();
@@ -130,6 +126,7 @@ void lineDrawEffect::reset(){
 //	fbo.end();
 	
 	lines.clear();
+	renderLines.clear();
 	
 	ofRemoveListener(mirReceiver::mirTempoEvent, this, &lineDrawEffect::tempoEventListener);
 	ofAddListener(mirReceiver::mirTempoEvent, this, &lineDrawEffect::tempoEventListener);
@@ -177,7 +174,7 @@ bool lineDrawEffect::printCustomEffectGui(){
 				if( (*s)->isType("vertexShape") ){
 					int duration = 2; // sec
 					vertexShape* shape = (vertexShape*) *s;
-					lines.push_back( lineDrawEffectLine( shape, fLineBeatDuration, ofColor(mainColor[0]*255, mainColor[1]*255,mainColor[2]*255, mainColor[3]*255) ));
+					lines.push_back( lineDrawEffectLine( shape, fLineBeatDuration, ofColor(mainColor[0]*255, mainColor[1]*255,mainColor[2]*255, mainColor[3]*255), random ));
 				}
 			}
 		}
@@ -187,10 +184,8 @@ bool lineDrawEffect::printCustomEffectGui(){
 		ImGui::Checkbox("Stress Test Mode", &bStressTestMode);
 		if(bStressTestMode){
 			ImGui::Indent();
-			ImGui::InputInt("fStressTestTargetFPS", &fStressTestTargetFPS);
-			ImGui::DragFloat("fStressTestMultiplier", &fStressTestMultiplier);
-			ImGui::SliderFloat("fStressTestAddTolerance", &fStressTestAddTolerance, 0.01, 10);
-			ImGui::SliderFloat("fStressTestRemoveTolerance", &fStressTestRemoveTolerance, 0.001, 10);
+			ImGui::SliderInt("Lines per shape per frame", &iStressTestLines, 0, 100);
+			ImGui::TextWrapped("Currently %i (quality level %u)", (int)ceil( iStressTestLines*getQualityFactor() ), getQualityLevel() );
 			ImGui::Unindent();
 		}
 	}
@@ -258,7 +253,7 @@ void lineDrawEffect::tempoEventListener(mirTempoEventArgs &_args){
 	
 	if(_args.isTempoBis) for(auto s=shapes.begin(); s!=shapes.end(); ++s){
 		if( (*s)->isType("vertexShape") ){
-			lines.push_back( lineDrawEffectLine( (vertexShape*)*s, (1.0f/(mirReceiver::mirCache.bpm/60.0f) )*fLineBeatDuration, ofColor(mainColor[0]*255, mainColor[1]*255,mainColor[2]*255, mainColor[3]*255) ));
+			lines.push_back( lineDrawEffectLine( (vertexShape*)*s, (1.0f/(mirReceiver::mirCache.bpm/60.0f) )*fLineBeatDuration, ofColor(mainColor[0]*255, mainColor[1]*255,mainColor[2]*255, mainColor[3]*255), random ));
 		}
 	}
 }
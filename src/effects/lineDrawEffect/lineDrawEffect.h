@@ -33,6 +33,9 @@ public:
 	bool render(karmaFboLayer& renderLayer, const animationParams& params);
 	void update(karmaFboLayer& renderLayer, const animationParams& params);
 	void reset();
+	virtual bool canUpdateAheadOfRender() const { return true; }
+	virtual void commitRenderState();
+	virtual unsigned int getMaxQualityLevel() const { return 3; } // stress test lines: 1, 1/2, 1/4, 1/8
 	
 	// #########
 	// GUI STUFF
@@ -52,14 +55,12 @@ protected:
 	//ofFbo fbo; // for compatibility issues, we need a specific fbo object
 	//float linesColor[4];
 	list<lineDrawEffectLine> lines;
+	vector<lineDrawEffectLine> renderLines; // as committed, render() draws these
 	
 	float fLineBeatDuration;
 	
 	bool bStressTestMode;
-	float fStressTestMultiplier;
-	float fStressTestAddTolerance;
-	float fStressTestRemoveTolerance;
-	int fStressTestTargetFPS;
+	int iStressTestLines; // per shape per frame, at full quality
 	
 private:
 	
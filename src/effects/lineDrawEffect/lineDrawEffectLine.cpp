@@ -10,7 +10,7 @@
 
 lineDrawEffectLine::lineDrawEffectLine(basicPoint* _from, basicPoint* _to) {
 	bAlive = true;
-	startTime = ofGetElapsedTimef();
+	startTime = -1;
 	
 	//color.setHsb(ofRandom(255), 200, 200);
 	color.set(255);
@@ -25,17 +25,16 @@ lineDrawEffectLine::lineDrawEffectLine( basicShape* targetShape ){
 //	posTo = rememberShape->getPositionPtr();
 }
 
-lineDrawEffectLine::lineDrawEffectLine( vertexShape* _targetShape, float _lifeTime, ofColor _color ){
+lineDrawEffectLine::lineDrawEffectLine( vertexShape* _targetShape, float _lifeTime, ofColor _color, karmaRandom& _random ){
 	bAlive = true;
 	lifeTime = _lifeTime;
 	if( lifeTime < 0.05f ) lifeTime = 1.0f;
-	startTime = ofGetElapsedTimef();
-	points.shape = _targetShape;
+	startTime = -1;
 	
-	points.points.push_back( _targetShape->getRandomVertexPtr() );
-	points.points.push_back( _targetShape->getRandomVertexPtr() );
-	points.points.push_back( _targetShape->getRandomVertexPtr() );
-	points.points.push_back( _targetShape->getRandomVertexPtr() );
+	shapeHandles& handles = shapeHandles::getInstance();
+	for(points.numPoints=0; points.numPoints<4; points.numPoints++){
+		points.points[points.numPoints] = handles.getHandle( _targetShape, _targetShape->getRandomVertexIndex(_random) );
+	}
 	
 	color = _color;
 //	posFrom = _targetShape->getRandomVertexPtr();
@@ -48,44 +47,47 @@ lineDrawEffectLine::~lineDrawEffectLine() {
 	// no need to delete posFrom, rememberShape and posTo because they are references
 }
 
-void lineDrawEffectLine::render(){
+void lineDrawEffectLine::update( const animationParams& params ){
 	if(!bAlive) return;
 	
-	float aliveSince = ofGetElapsedTimef()-startTime;
-	
-	if(aliveSince>1.f) bAlive = false;
+	if( startTime < 0 ) startTime = params.elapsedTime;
+	float aliveSince = params.elapsedTime-startTime;
+	state = aliveSince/lifeTime;
 	
-	// tmp
-	else render( aliveSince/lifeTime );
+	// shape is gone or got edited ?
+	basicPoint p[4];
+	if( aliveSince>1.f || state>1 || shapeHandles::getInstance().resolve( points.points, points.numPoints, p ) != points.numPoints ){
+		bAlive = false;
+	}
 }
 
-void lineDrawEffectLine::render(float state) {
+void lineDrawEffectLine::render() const {
 	if(!bAlive) return;
 	
-	if( points.shape == nullptr || !points.shape->isReady() ) return;
+	// committed vertices, absolute
+	basicPoint p[4];
+	if( shapeHandles::getInstance().resolve( points.points, points.numPoints, p ) != points.numPoints ) return;
 	
 	//float opacity = abs( (state*2)-1 );
 	float opacity = 1-(state);
 		
 	ofPushStyle();
-	ofPushMatrix();
-	ofTranslate( points.shape->getPositionPtr()->x, points.shape->getPositionPtr()->y );
 	
 	ofSetColor(color, color.a*opacity );
 	ofNoFill();
 	//ofSetLineWidth(5);
 	
-	switch( points.points.size() ){
+	switch( points.numPoints ){
 		case 2:
-			ofDrawLine(points.points[0]->x, points.points[0]->y, points.points[1]->x, points.points[1]->y);
+			ofDrawLine(p[0].x, p[0].y, p[1].x, p[1].y);
 			break;
 			
 		case 3:
-			ofDrawLine(points.points[0]->x, points.points[0]->y, ofLerp( points.points[1]->x, points.points[2]->x, state), ofLerp(points.points[1]->y, points.points[2]->y, state) );
+			ofDrawLine(p[0].x, p[0].y, ofLerp( p[1].x, p[2].x, state), ofLerp(p[1].y, p[2].y, state) );
 			break;
 			
 		case 4:
-			ofDrawLine(ofLerp( points.points[0]->x, points.points[3]->x, state), ofLerp(points.points[0]->y, points.points[3]->y, state), ofLerp( points.points[1]->x, points.points[2]->x, state), ofLerp(points.points[1]->y, points.points[2]->y, state) );
+			ofDrawLine(ofLerp( p[0].x, p[3].x, state), ofLerp(p[0].y, p[3].y, state), ofLerp( p[1].x, p[2].x, state), ofLerp(p[1].y, p[2].y, state) );
 			break;
 			
 		default:
@@ -96,11 +98,7 @@ void lineDrawEffectLine::render(float state) {
 	//ofCircle(posFrom->x, posFrom->y, 5);
 	//ofCircle(posTo->x, posTo->y, 5);
 	
-	ofPopMatrix();
 	ofPopStyle();
-	
-	// dead ?
-	if(state > 1) bAlive = false;
 }
 
 bool lineDrawEffectLine::isAlive() const{
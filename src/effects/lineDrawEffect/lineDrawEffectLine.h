@@ -11,17 +11,19 @@
 #include "ofMain.h"
 #include "shapes.h"
 #include "mirEvents.h"
+#include "animationParams.h"
+#include "karmaRandom.h"
+#include "shapeHandles.h"
 
 // todo: implement (animation) modes or a random preset generator
 
 struct linePoints {
 	linePoints(){
-		shape = nullptr;
-		points.clear();
+		numPoints = 0;
 	}
 	
-	basicShape* shape;
-	vector< basicPoint* > points;
+	vertexHandle points[4];
+	unsigned int numPoints;
 };
 
 class lineDrawEffectLine {
@@ -29,17 +31,20 @@ class lineDrawEffectLine {
 public:
 	lineDrawEffectLine( basicPoint* _from, basicPoint* _to);
 	lineDrawEffectLine( basicShape* targetShape );
-	lineDrawEffectLine( vertexShape* targetShape, float _lifeTime, ofColor _color );
+	lineDrawEffectLine( vertexShape* targetShape, float _lifeTime, ofColor _color, karmaRandom& _random );
 	~lineDrawEffectLine();
 	
-	void render();
-	void render(float state);
+	// ages the line, in the effect's update()
+	void update( const animationParams& params );
+	// draws it as it was at the last update()
+	void render() const;
 	bool isAlive() const;
 	
 protected:
 	linePoints points;
 	ofColor color;
-	float startTime;
+	float startTime; // animation time, set on first update
+	float state = 0; // 0 to 1 over its life time
 	float lifeTime = 1.0f;
 	bool bAlive;
 
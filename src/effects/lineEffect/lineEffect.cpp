@@ -29,6 +29,7 @@ lineEffect::lineEffect(){
 	toShape=NULL;
 	
 	lines.clear();
+	renderLines.clear();
 	tempoCalls=0;
 }
 
@@ -53,13 +54,14 @@ bool lineEffect::initialise(const animationParams& params){
 	// todo: this could be set to the basicShape::getBoundingBox() size for better performance
 	// tmp
 	//renderer.allocate( ofGetCurrentRenderer()->getViewportWidth(), ofGetCurrentRenderer()->getViewportHeight(), GL_RGBA, 8); // lower this to get better FPS
-	renderer.allocate( 1500, 1200, GL_RGBA, 8);
-	renderer.begin();
+	renderer.reset();
+	renderer = karmaRenderTargetPool::getInstance().acquireWindowSized( GL_RGBA, 8 );
+	renderer->begin();
 	ofClear(0,0,0,0); // fill with total invisibility! >D
 	//ofEnableSmoothing(); // enables smooth lines (makes no difference)
-	renderer.end();
+	renderer->end();
 	
-	bInitialised = renderer.isAllocated();
+	bInitialised = renderer->isAllocated();
 	
 	return bInitialised;
 }
@@ -85,8 +87,8 @@ bool lineEffect::render(karmaFboLayer& renderLayer, const animationParams& param
 	effectMutex.unlock();
 	
 	// partial frame buffering
-	if(renderer.isAllocated()){
-		renderer.begin();
+	if(renderer && renderer->isAllocated()){
+		renderer->begin();
 		
 		// tmp (to re-enable)
 		// fade FBO alpha over time
@@ -96,20 +98,19 @@ bool lineEffect::render(karmaFboLayer& renderLayer, const animationParams& param
 		glBlendFunc(GL_SRC_ALPHA, GL_ONE);
 		ofSetColor(0,0,0,50);
 		ofFill();
-		ofDrawRectangle(0,0,renderer.getWidth(), renderer.getHeight());
+		ofDrawRectangle(0,0,renderer->getWidth(), renderer->getHeight());
 		ofDisableBlendMode(); // resets blending modes manually enabled above
 	}
 	
-	effectMutex.lock();
+	// only changes in commitRenderState()
 	ofSetColor(255);
-	for(auto it=lines.begin(); it!= lines.end(); ++it){
+	for(auto it=renderLines.cbegin(); it!= renderLines.cend(); ++it){
 		(*it).render();
 	}
-	effectMutex.unlock();
 	
-	if(renderer.isAllocated()){
-		renderer.end();
-		renderer.draw(0,0);
+	if(renderer && renderer->isAllocated()){
+		renderer->end();
+		renderer->draw(0,0);
 	}
 }
 
@@ -123,8 +124,8 @@ void lineEffect::update(karmaFboLayer& renderLayer, const animationParams& param
 	
 	// initial shape setup. Dirty to do it here. // todo
 	if( shapes.size()>0 ){
-		if(fromShape==NULL) fromShape = shapes[ round( ofRandom(-0.49f, shapes.size()-0.51f) )];
-		if(toShape==NULL) toShape = shapes[ round( ofRandom(-0.49f, -0.51f+shapes.size()) )];
+		if(fromShape==NULL) fromShape = shapes[ random.getIndex( shapes.size() ) ];
+		if(toShape==NULL) toShape = shapes[ random.getIndex( shapes.size() ) ];
 	}
 	
 	// tmp
@@ -145,21 +146,21 @@ void lineEffect::update(karmaFboLayer& renderLayer, const animationParams& param
 	// add lines ?
 	//if(lines.size() < shapes.size()*90) lines.push_back( getRandomLine(true) );
 	
-	// check for dead lines
-	for(std::list<lineEffectLine>::reverse_iterator it=lines.rbegin(); it!= lines.rend(); it--){
-		
-		//lineEffectLine bla = *it;
+	// age lines, remove dead ones
+	for(auto it=lines.begin(); it!=lines.end(); ){
+		(*it).update( params );
 		
-		// replace dead one with new one
-		if( !(*it).isAlive() ) {
-			//*it = getRandomLine();
-			it++;
-			it= std::list<lineEffectLine>::reverse_iterator( lines.erase( it.base() ));
-			it--;
-		}
+		if( (*it).isAlive() ) ++it;
+		else it = lines.erase( it );
 	}
 }
 
+// the next update() can run while render() draws this copy
+void lineEffect::commitRenderState(){
+	ofScopedLock lock(effectMutex);
+	renderLines.assign( lines.begin(), lines.end() );
+}
+
 // resets all values
 // overrule this function with your own.
 void lineEffect::reset(){
@@ -206,10 +207,10 @@ void lineEffect::reset(){
 // note: when you call this function, mutex must be locked
 lineEffectLine lineEffect::getRandomLine( const bool onSameShape){
 	
-	basicShape* fromShape = shapes[ round( ofRandom(-0.49f, shapes.size()-0.51f) )];
+	basicShape* fromShape = shapes[ random.getIndex( shapes.size() ) ];
 	basicShape* toShape;
 	if( onSameShape ) toShape = fromShape;
-	else toShape = shapes[ round( ofRandom(-0.49f, shapes.size()-0.51f) )];
+	else toShape = shapes[ random.getIndex( shapes.size() ) ];
 	
 	return getRandomLine(fromShape, toShape);
 	
@@ -219,35 +220,25 @@ lineEffectLine lineEffect::getRandomLine( const bool onSameShape){
 // note: when you call this function, mutex must be locked
 lineEffectLine lineEffect::getRandomLine(basicShape *_sh1, basicShape *_sh2) {
 	
-	basicPoint* from;
-	basicPoint* to;
 	if( !_sh1->isReady() || !_sh2->isReady() ){
-		from = &basicPoint::nullPoint;
-		to = &basicPoint::nullPoint;
+		return lineEffectLine( &basicPoint::nullPoint, &basicPoint::nullPoint );
 	}
-	else if( _sh1->isType("vertexShape") ){
-		from = ((vertexShape*) _sh1)->getRandomVertexPtr(POINT_POSITION_ABSOLUTE);
+	else if( _sh1->isType("vertexShape") && _sh2->isType("vertexShape") ){
+		vertexShape* from = (vertexShape*) _sh1;
+		vertexShape* to = (vertexShape*) _sh2;
+		unsigned int fromIndex = from->getRandomVertexIndex(random);
 		
-		if( _sh1 == _sh2 ){
-			to = ((vertexShape*) _sh2)->getNextVertexPtr( *from,POINT_POSITION_ABSOLUTE);
-			if(to == &basicPoint::nullPoint) while( _sh1!=_sh2 && from==to ){
-				to = ((vertexShape*) _sh2)->getRandomVertexPtr(POINT_POSITION_ABSOLUTE);
-			}
-			
-		}
-		else {
-			to = ((vertexShape*) _sh2)->getRandomVertexPtr( POINT_POSITION_ABSOLUTE);
-			if(to == &basicPoint::nullPoint) while( _sh1!=_sh2 && from==to ){
-				to = ((vertexShape*) _sh2)->getRandomVertexPtr(POINT_POSITION_ABSOLUTE);
-			}
-		}
+		// same shape: connect to the next vertex
+		unsigned int toIndex = (_sh1 == _sh2) ? to->getNextVertexIndex(fromIndex) : to->getRandomVertexIndex(random);
+		
+		shapeHandles& handles = shapeHandles::getInstance();
+		return lineEffectLine( handles.getHandle(from, fromIndex), handles.getHandle(to, toIndex) );
 	}
 	else {
-		from = _sh1->getPositionPtr();
-		to = _sh2->getPositionPtr();
+		// vertex 0 of a point is its (committed) position
+		shapeHandles& handles = shapeHandles::getInstance();
+		return lineEffectLine( handles.getHandle(_sh1, 0), handles.getHandle(_sh2, 0) );
 	}
-	
-	return lineEffectLine( from, to );
 }
 
 void lineEffect::floatListener(durationFloatEventArgs &_args){
@@ -304,7 +295,7 @@ void lineEffect::onSetEventListener(mirOnSetEventArgs &_args){
 		
 		if(tempoCalls%10==0){
 			fromShape = toShape;
-			toShape = shapes[ round( ofRandom(-0.49f, -0.51f+shapes.size()) )];
+			toShape = shapes[ random.getIndex( shapes.size() ) ];
 			cout << "onSetChange" << endl;
 		}
 	}
@@ -19,6 +19,7 @@
 //#include "ofxAbletonLiveSet.h"
 #include "mirReceiver.h"
 #include "durationReceiver.h"
+#include "karmaRenderTargetPool.h"
 
 class lineEffect : public basicEffect {
 	
@@ -30,6 +31,8 @@ public:
 	virtual bool render(karmaFboLayer& renderLayer, const animationParams& params);
 	virtual void update(karmaFboLayer& renderLayer, const animationParams& params);
 	virtual void reset();
+	virtual bool canUpdateAheadOfRender() const { return true; }
+	virtual void commitRenderState();
 	
 	//bool grabSomeShapes();
 	
@@ -44,10 +47,11 @@ protected:
 	lineEffectLine getRandomLine(basicShape* _sh1, basicShape* _sh2);
 	//map<int, vector<int> > shapeGroups; // <groupID, vector<shapeIndexes> >
 	list<lineEffectLine> lines;
+	vector<lineEffectLine> renderLines; // as committed, render() draws these
 	int tempoCalls;
 	
 	//ofMutex lineEffectMutex;
-	ofFbo renderer;
+	shared_ptr<ofFbo> renderer; // pooled, window-sized
 	
 	//void clearWithTransparency(float transparency);
 	
@@ -10,7 +10,8 @@
 
 lineEffectLine::lineEffectLine(basicPoint* _from, basicPoint* _to) {
 	bAlive = true;
-	startTime = ofGetElapsedTimef();
+	startTime = -1;
+	state = 0;
 	
 	//color.setHsb(ofRandom(255), 200, 200);
 	color.set(255);
@@ -19,16 +20,22 @@ lineEffectLine::lineEffectLine(basicPoint* _from, basicPoint* _to) {
 	posTo = _to;
 }
 
+lineEffectLine::lineEffectLine( const vertexHandle& _from, const vertexHandle& _to ) : lineEffectLine( &basicPoint::nullPoint, &basicPoint::nullPoint ) {
+	from = _from;
+	to = _to;
+}
+
 lineEffectLine::lineEffectLine( basicShape* targetShape ){
 	rememberShape = targetShape;
 	posFrom = rememberShape->getPositionPtr();
 	posTo = rememberShape->getPositionPtr();
 }
 
-lineEffectLine::lineEffectLine( vertexShape* _targetShape ){
+lineEffectLine::lineEffectLine( vertexShape* _targetShape, karmaRandom& _random ){
 	rememberShape = _targetShape;
-	posFrom = _targetShape->getRandomVertexPtr();
-	posTo = _targetShape->getRandomVertexPtr();
+	posFrom = posTo = &basicPoint::nullPoint;
+	from = shapeHandles::getInstance().getHandle( _targetShape, _targetShape->getRandomVertexIndex(_random) );
+	to = shapeHandles::getInstance().getHandle( _targetShape, _targetShape->getRandomVertexIndex(_random) );
 }
 
 lineEffectLine::~lineEffectLine() {
@@ -36,20 +43,24 @@ lineEffectLine::~lineEffectLine() {
 	// no need to delete posFrom, rememberShape and posTo because they are references
 }
 
-void lineEffectLine::render(){
+void lineEffectLine::update( const animationParams& params ){
 	if(!bAlive) return;
 	
-	float aliveSince = ofGetElapsedTimef()-startTime;
-	
-	if(aliveSince>LEL_LIFE_SPAN) bAlive = false;
+	if( startTime < 0 ) startTime = params.elapsedTime;
+	float aliveSince = params.elapsedTime-startTime;
+	state = aliveSince/LEL_LIFE_SPAN;
 	
-	// tmp
-	else render( aliveSince/LEL_LIFE_SPAN );
+	basicPoint ends[2];
+	if( aliveSince>LEL_LIFE_SPAN || !getEnds( ends[0], ends[1] ) ) bAlive = false;
 }
 
-void lineEffectLine::render(float state) {
+void lineEffectLine::render() const {
 	if(!bAlive) return;
 	
+	// the shape got edited since the last update
+	basicPoint ends[2];
+	if( !getEnds( ends[0], ends[1] ) ) return;
+	
 	//float opacity = abs( (state*2)-1 );
 	float opacity = 1-abs( (state-0.5f)*2 );
 		
@@ -58,7 +69,7 @@ void lineEffectLine::render(float state) {
 	ofSetColor(color, opacity*255 );
 	ofNoFill();
 	//ofSetLineWidth(5);
-	ofDrawLine(posFrom->x, posFrom->y, posTo->x, posTo->y);
+	ofDrawLine(ends[0].x, ends[0].y, ends[1].x, ends[1].y);
 	
 	//ofFill();
 	//ofCircle(posFrom->x, posFrom->y, 5);
@@ -69,4 +80,26 @@ void lineEffectLine::render(float state) {
 
 bool lineEffectLine::isAlive() const{
 	return bAlive;
-}
\ No newline at end of file
+}
+
+bool lineEffectLine::getEnds( basicPoint& _from, basicPoint& _to ) const {
+	_from = *posFrom;
+	_to = *posTo;
+	if( from.isNull() && to.isNull() ) return true;
+	
+	// both ends in one go
+	vertexHandle handles[2] = { from, to };
+	basicPoint positions[2];
+	unsigned char valid[2];
+	shapeHandles::getInstance().resolve( handles, 2, positions, valid );
+	
+	if( !from.isNull() ){
+		if( !valid[0] ) return false;
+		_from = positions[0];
+	}
+	if( !to.isNull() ){
+		if( !valid[1] ) return false;
+		_to = positions[1];
+	}
+	return true;
+}
@@ -10,6 +10,9 @@
 
 #include "ofMain.h"
 #include "shapes.h"
+#include "animationParams.h"
+#include "karmaRandom.h"
+#include "shapeHandles.h"
 
 #define LEL_LIFE_SPAN 1
 
@@ -19,19 +22,29 @@ class lineEffectLine {
 
 public:
 	lineEffectLine( basicPoint* _from, basicPoint* _to);
+	lineEffectLine( const vertexHandle& _from, const vertexHandle& _to );
 	lineEffectLine( basicShape* targetShape );
-	lineEffectLine( vertexShape* targetShape );
+	lineEffectLine( vertexShape* targetShape, karmaRandom& _random );
 	~lineEffectLine();
 	
-	void render();
-	void render(float state);
+	// ages the line, in the effect's update()
+	void update( const animationParams& params );
+	// draws it as it was at the last update()
+	void render() const;
 	bool isAlive() const;
 	
 protected:
+	// line ends are shape vertexes (absolute, as rendered) or points
+	// false when a shape is gone or got edited
+	bool getEnds( basicPoint& _from, basicPoint& _to ) const;
+	
 	basicPoint* posFrom;
 	basicPoint* posTo;
+	vertexHandle from;
+	vertexHandle to;
 	ofColor color;
-	float startTime;
+	float startTime; // animation time, set on first update
+	float state; // 0 to 1 over its life span
 	bool bAlive;
 
 private:
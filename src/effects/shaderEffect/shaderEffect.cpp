@@ -60,8 +60,12 @@ bool shaderEffect::initialise(const animationParams& params){
 bool shaderEffect::render(karmaFboLayer& renderLayer, const animationParams &params){
 	if(!isReady() || !shader.isLoaded()) return false;
 	
-	if(bUseCustomFbo){
-		fbo.begin();
+	// lower quality levels skip the ping-pong pass, then the dedicated FBO
+	const bool bUseFbo = bUseCustomFbo && !isQualityStepDropped( QUALITY_NO_FBO );
+	const bool bPingPong = usesPingPong() && !isQualityStepDropped( QUALITY_NO_PINGPONG );
+	
+	if(bUseFbo){
+		fbo->begin();
 	}
 	else {
 		renderLayer.begin();
@@ -87,8 +91,8 @@ bool shaderEffect::render(karmaFboLayer& renderLayer, const animationParams &par
 
 		ofSetColor(0.0f, 5.0f*params.seasons.spring + 5.0f*params.seasons.autumn);
 		ofFill();
-		if (bUseCustomFbo) {
-			ofDrawRectangle(0,0, fbo.getWidth(), fbo.getHeight());
+		if (bUseFbo) {
+			ofDrawRectangle(0,0, fbo->getWidth(), fbo->getHeight());
 		}
 		else {
 			ofDrawRectangle(0,0, renderLayer.getWidth(), renderLayer.getHeight());
@@ -109,9 +113,14 @@ bool shaderEffect::render(karmaFboLayer& renderLayer, const animationParams &par
 	effectMutex.unlock();
 	
 	// draw shape so GPU gets their vertex data
-	for(auto it=shapes.begin(); it!=shapes.end(); ++it){
-		shader.setUniform4f("shapeBoundingBox", (*it)->getBoundingBox().x, (*it)->getBoundingBox().y, (*it)->getBoundingBox().width, (*it)->getBoundingBox().height );
-		shader.setUniform2f("shapeCenter", (*it)->getPositionPtr()->x, (*it)->getPositionPtr()->y );
+	// shaders reading the kmShape* attributes get all shapes in one call
+	if( shapesBatcher::getInstance().supportsShader(shader) ){
+		shapesBatcher::getInstance().draw( shapeBatch, shapes, &shader, getLodError() );
+	}
+	else for(auto it=shapes.begin(); it!=shapes.end(); ++it){
+		const ofRectangle& box = (*it)->getRenderBoundingBox();
+		shader.setUniform4f("shapeBoundingBox", box.x, box.y, box.width, box.height );
+		shader.setUniform2f("shapeCenter", (*it)->getRenderPosition().x, (*it)->getRenderPosition().y );
 		//cout << (*it)->getBoundingBox().width << endl;
 		(*it)->sendToGPU();
 	}
@@ -120,15 +129,15 @@ bool shaderEffect::render(karmaFboLayer& renderLayer, const animationParams &par
 	shader.end();
 	
 	// stop rendering on FBO
-	if(bUseCustomFbo){
-		fbo.end();
+	if(bUseFbo){
+		fbo->end();
 		
 		// draw fbo to layer
 		renderLayer.begin();
 		ofPushStyle();
 		ofSetColor(1.0, 1.0, 1.0, 1.0);
 		ofFill();
-		fbo.draw(0,0);
+		fbo->draw(0,0);
 		ofPopStyle();
 		renderLayer.end(false);
 	}
@@ -137,7 +146,7 @@ bool shaderEffect::render(karmaFboLayer& renderLayer, const animationParams &par
 	}
 	
 	// do a pingpong pass ?
-	if( usesPingPong() ){
+	if( bPingPong ){
 		
 		// swap before so the current rendering turns into an fbo texture to use in our shader
 		renderLayer.swap();
@@ -150,8 +159,8 @@ bool shaderEffect::render(karmaFboLayer& renderLayer, const animationParams &par
 		//registerShaderVariables(params);
 		
 		shader.setUniform1i("kmIsPingPongPass", 1);
-		if(bUseCustomFbo){
-			shader.setUniformTexture("pingPongTexture", fbo.getTexture(),5);
+		if(bUseFbo){
+			shader.setUniformTexture("pingPongTexture", fbo->getTexture(),5);
 		}
 		else {
 			// note: between begin() and end() SRC is DST
@@ -218,7 +227,7 @@ void shaderEffect::update(karmaFboLayer& renderLayer, const animationParams& par
 		shaderToyArgs.iResolution[1] = ofGetWindowHeight();
 		shaderToyArgs.iResolution[2] = ofGetWindowMode();
 		
-		shaderToyArgs.iGlobalTime = ofGetElapsedTimef()*shaderToyArgs.iGlobalTimeScale;
+		shaderToyArgs.iGlobalTime = params.elapsedTime*shaderToyArgs.iGlobalTimeScale;
 		
 		shaderToyArgs.iDate[0] = ofGetYear();
 		shaderToyArgs.iDate[1] = ofGetMonth();
@@ -270,6 +279,7 @@ void shaderEffect::reset(){
 	setUseCustomFbo(false);
 	bUseShadertoyVariables = false;
 	bUseMirVariables = false;
+	bStaticOutput = false;
 	bUseTextures = false;
 	textureMode = 0;
 	textures.clear();
@@ -279,10 +289,77 @@ void shaderEffect::reset(){
 	textureTransform[3]=1;
 	//texturesTime.clear();
 	shaderToyArgs = shaderToyVariables();
+	renderShaderToyArgs = shaderToyArgs;
 	
 	effectMutex.unlock();
 }
 
+// the next update() can run while render() uses this copy
+void shaderEffect::commitRenderState(){
+	ofScopedLock lock(effectMutex);
+	renderShaderToyArgs = shaderToyArgs;
+}
+
+unsigned int shaderEffect::getMaxQualityLevel() const {
+	unsigned int levels = 0;
+	for(int step=0; step<QUALITY_NUM_STEPS; ++step){
+		if( hasQualityStep( (shaderQualityStep) step ) ) levels++;
+	}
+	return levels;
+}
+
+// the frame governor changed the quality level
+void shaderEffect::onQualityLevelChanged(){
+	// MSAA changes need a new FBO
+	if( bUseCustomFbo && bFboMultisampled == isQualityStepDropped( QUALITY_NO_MSAA ) ){
+		setUseCustomFbo(true);
+	}
+}
+
+bool shaderEffect::hasQualityStep( shaderQualityStep _step ) const {
+	switch( _step ){
+		case QUALITY_NO_MSAA:
+		case QUALITY_NO_FBO:
+			return bUseCustomFbo;
+		case QUALITY_NO_PINGPONG:
+			return usesPingPong();
+		default:
+			return false;
+	}
+}
+
+// steps the settings don't have are skipped, so each level saves something
+bool shaderEffect::isQualityStepDropped( shaderQualityStep _step ) const {
+	if( !hasQualityStep(_step) ) return false;
+	
+	unsigned int level = 1;
+	for(int step=0; step<_step; ++step){
+		if( hasQualityStep( (shaderQualityStep) step ) ) level++;
+	}
+	return qualityLevel >= level;
+}
+
+// lets the controller cache the layer when nothing animates the shader
+unsigned int shaderEffect::getOutputDependencies() const {
+	// time, mouse, audio & ping-pong feedback change every frame
+	if( !bStaticOutput || bUseShadertoyVariables || bUseMirVariables || bUsePingpong ){
+		return EFFECT_OUTPUT_USES_TIME;
+	}
+	return EFFECT_OUTPUT_USES_SHAPES;
+}
+
+// uploaded textures and the dedicated FBO, assuming rgba
+size_t shaderEffect::getMemoryEstimate() const {
+	size_t bytes = 0;
+	for(auto it=textures.cbegin(); it!=textures.cend(); ++it){
+		if( it->isAllocated() ) bytes += (size_t) it->getWidth() * it->getHeight() * 4;
+	}
+	if( fbo && fbo->isAllocated() ){
+		bytes += (size_t) fbo->getWidth() * fbo->getHeight() * 4 * fbo->getNumTextures();
+	}
+	return bytes;
+}
+
 // - - - - - - -
 // GUI STUFF
 // - - - - - - -
@@ -308,6 +385,11 @@ bool shaderEffect::printCustomEffectGui(){
 			setUsePingPong(bUsePingpong);
 		}
 		
+		ImGui::Checkbox("Static output", &bStaticOutput);
+		if(ImGui::IsItemHovered()){
+			ImGui::SetTooltip("Check if the shader doesn't use time.\nThe layer is then only re-rendered when the settings or shapes change.\n(ignored with shadertoy, mir or ping-pong)");
+		}
+		
 		ImGui::LabelText("Vertex Shader", "%s", vertexShader.c_str() );
 		if(ImGui::Button("Load .vert...")){
 			ofFileDialogResult d = ofSystemLoadDialog("Select vertex shader...");
@@ -457,6 +539,7 @@ bool shaderEffect::saveToXML(ofxXmlSettings& xml) const{
 	
 	xml.addValue( "bUseMirVariables", bUseMirVariables );
 	xml.addValue( "bUseCustomFbo", bUseCustomFbo );
+	xml.addValue( "bStaticOutput", bStaticOutput );
 	xml.addValue( "textureMode", textureMode);
 	
 	xml.addTag("textureTransform");
@@ -488,6 +571,7 @@ bool shaderEffect::loadFromXML(ofxXmlSettings& xml){
 	
 	bUseMirVariables = xml.getValue( "bUseMirVariables", false );
 	setUseCustomFbo( xml.getValue( "bUseCustomFbo", false ) );
+	bStaticOutput = xml.getValue( "bStaticOutput", false );
 	setTextureMode( xml.getValue("textureMode", 0) );
 	
 	if(xml.pushTag("textureTransform")){
@@ -528,8 +612,8 @@ void shaderEffect::registerShaderVariables(const animationParams& params){
 	
 	//if(shader==NULL) return;
 	
-	shader.setUniform1f("timeValX", ofGetElapsedTimef() * 0.1 );
-	shader.setUniform1f("timeValY", -ofGetElapsedTimef() * 0.18 );
+	shader.setUniform1f("timeValX", params.elapsedTime * 0.1 );
+	shader.setUniform1f("timeValY", -params.elapsedTime * 0.18 );
 	
 	shader.setUniform2f("fboCanvas", ofGetWidth(), ofGetHeight() ); // todo: should match FBO instead of window
 	
@@ -544,14 +628,14 @@ void shaderEffect::registerShaderVariables(const animationParams& params){
 	
 	if( bUseMirVariables ) registerMirVariables();
 	
-	if( bUseShadertoyVariables ) registerShaderToyVariables();
+	if( bUseShadertoyVariables ) registerShaderToyVariables(params);
 	
 }
 
 // registers shadertoy variables
-void shaderEffect::registerShaderToyVariables(){
+void shaderEffect::registerShaderToyVariables(const animationParams& params){
 	ofScopedLock( effectMutex );
-	shader.setUniform1f("iResolution", ofGetElapsedTimef() * fTimeFactor );
+	shader.setUniform1f("iResolution", params.elapsedTime * fTimeFactor );
 	
 	// set textures
 	if( bUseTextures ){
@@ -567,7 +651,7 @@ void shaderEffect::registerShaderToyVariables(){
 			//iChannelResolution[(3*i+0)] = t->getWidth();
 			//iChannelResolution[(3*i+1)] = t->getHeight();
 			//iChannelResolution[(3*i+2)] = t->getWidth() / t->getHeight();
-			if(i<4) iChannelTime[i] = shaderToyArgs.iChannelTime[i];
+			if(i<4) iChannelTime[i] = renderShaderToyArgs.iChannelTime[i];
 			
 			//t->setTextureWrap(GL_REPEAT, GL_REPEAT );
 			//glTexParameterf(t->getTextureData().textureID, GL_REPEAT, GL_REPEAT);
@@ -577,7 +661,7 @@ void shaderEffect::registerShaderToyVariables(){
 		}
 		//cout << iChannelResolution[0] << endl;
 		shader.setUniform1fv("iChannelTime", iChannelTime);
-		shader.setUniform3fv("iChannelResolution", shaderToyArgs.iChannelResolution, KM_ARRAY_SIZE(shaderToyArgs.iChannelResolution) );
+		shader.setUniform3fv("iChannelResolution", renderShaderToyArgs.iChannelResolution, KM_ARRAY_SIZE(renderShaderToyArgs.iChannelResolution) );
 		shader.setUniform1i("textureMode", textureMode);
 		shader.setUniform4f("globalTextureTransform", textureTransform[0], textureTransform[1], textureTransform[2], textureTransform[3]);
 
@@ -617,15 +701,19 @@ void shaderEffect::setUseCustomFbo(const bool &_useCustomFbo){
 	//if( bUseCustomFbo == _useCustomFbo ) return;
 	   
 	bUseCustomFbo = _useCustomFbo;
+	clampQualityLevel(); // without FBO there are less quality steps
 	if(bUseCustomFbo){
-		fbo.allocate(ofGetWidth(), ofGetHeight(), GL_RGBA, ofFbo::maxSamples());
-		fbo.begin();
+		bFboMultisampled = !isQualityStepDropped( QUALITY_NO_MSAA );
+		fbo.reset();
+		fbo = karmaRenderTargetPool::getInstance().acquireWindowSized(GL_RGBA, bFboMultisampled ? ofFbo::maxSamples() : 0);
+		fbo->begin();
 		ofClear(0,0,0,0); // clear all, including alpha
-		fbo.end();
+		fbo->end();
 	}
 	else {
-		fbo.clear(); // frees GPU memory
+		fbo.reset(); // back to the pool
 	}
+	markOutputChanged();
 }
 
 void shaderEffect::setTextureMode(const int& _mode) {
@@ -744,6 +832,7 @@ void shaderEffect::onResizeListener(ofResizeEventArgs &resize){
 		shaderToyArgs.iResolution[1] = resize.height;
 		shaderToyArgs.iResolution[2] = ofGetWindowMode();
 	}
+	markOutputChanged();
 }
 
 
@@ -17,12 +17,21 @@
 #include "mirReceiver.h"
 #include "shaderToyVariables.h"
 #include "karmaUtilities.h"
+#include "karmaRenderTargetPool.h"
 
 #define ShaderEffectDefaultFrag "defaultShader.frag"
 #define ShaderEffectDefaultVert "defaultShader.vert"
 
 struct animationParams;
 
+// what the frame governor can give up, in this order. Only the ones the settings use count as a quality level.
+enum shaderQualityStep {
+	QUALITY_NO_MSAA = 0, // on the dedicated FBO
+	QUALITY_NO_PINGPONG,
+	QUALITY_NO_FBO, // render straight into the layer
+	QUALITY_NUM_STEPS
+};
+
 // todo: add a GPU memory extraction feature for stats and handling no more GPU allocatable errors.
 
 class shaderEffect : public basicEffect {
@@ -37,6 +46,12 @@ public:
 	bool render(karmaFboLayer& renderLayer, const animationParams& params);
 	void update(karmaFboLayer& renderLayer, const animationParams& params);
 	void reset();
+	virtual bool canUpdateAheadOfRender() const { return true; }
+	virtual void commitRenderState();
+	virtual unsigned int getOutputDependencies() const;
+	// one level per quality step the current settings have (see shaderQualityStep)
+	virtual unsigned int getMaxQualityLevel() const;
+	virtual size_t getMemoryEstimate() const;
 	
 	// #########
 	// GUI STUFF
@@ -52,7 +67,7 @@ public:
 	
 	bool loadShader(string _vert, string _frag);
 	virtual void registerShaderVariables(const animationParams &params);
-	void registerShaderToyVariables();
+	void registerShaderToyVariables(const animationParams& params);
 	void registerMirVariables();
 	void setUseCustomFbo(const bool& _useCustomFbo);
 	void setTextureMode( const int& _mode);
@@ -61,18 +76,25 @@ public:
 	void onResizeListener( ofResizeEventArgs& resize );
 	
 protected:
+	virtual void onQualityLevelChanged();
+	bool hasQualityStep( shaderQualityStep _step ) const;
+	bool isQualityStepDropped( shaderQualityStep _step ) const;
+	
 	int onSetCalls;
 	string vertexShader, fragmentShader;
 	ofShader shader;
-	ofFbo fbo; // tmp, until there's a layering system
+	shared_ptr<ofFbo> fbo; // pooled, follows the window size
 	float fTimeFactor;
 	
 	shaderToyVariables shaderToyArgs;
+	shaderToyVariables renderShaderToyArgs; // as committed, render() reads this one
 	bool bUseShadertoyVariables;
 	
 	//shaderToyVariables shaderToyArgs;
 	bool bUseMirVariables;
 	bool bUseCustomFbo;
+	bool bFboMultisampled;
+	bool bStaticOutput; // user says the shader doesn't animate by itself
 	bool bUseTextures;
 	int textureMode; // note: nothing to do with GL texture modes
 	float textureTransform[4]; // offset(x,y) scale(w,h)
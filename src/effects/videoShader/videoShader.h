@@ -43,6 +43,8 @@ public:
 	bool render(karmaFboLayer& renderLayer, const animationParams& params);
 	void update(karmaFboLayer& renderLayer, const animationParams& params);
 	void reset();
+	virtual unsigned int getOutputDependencies() const { return EFFECT_OUTPUT_USES_TIME; } // video frames
+	virtual bool canUpdateAheadOfRender() const { return false; } // uploads them in update()
 	
 	// #########
 	// GUI STUFF
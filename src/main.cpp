@@ -3,6 +3,9 @@
 
 #ifdef KM_EDITOR_APP
 #include "ofAppEditor.h"
+#elif defined(KM_BENCHMARK_APP)
+#include "ofAppBenchmark.h"
+#include "ofAppNoWindow.h"
 #else
 #include "ofApp.h"
 #endif
@@ -12,6 +15,26 @@
 #endif
 
 //========================================================================
+#ifdef KM_BENCHMARK_APP
+// headless, runs without GL context. See ofAppBenchmark.h
+int main( int argc, char* argv[] ){
+	karmaBenchmarkSettings settings;
+	if( !settings.parseArguments(argc, argv) ) return 1;
+	
+	// scene conversion only
+	if( !settings.convertFrom.empty() ){
+		return shapesScene::convertScene( settings.convertFrom, settings.convertTo, settings.bQuantize ) ? 0 : 1;
+	}
+	
+	// keep stdout clean for the JSON results
+	ofSetLogLevel(OF_LOG_WARNING);
+	
+	ofAppNoWindow window;
+	ofSetupOpenGL(&window, settings.width, settings.height, OF_WINDOW);
+	
+	return ofRunApp( new ofAppBenchmark(settings) );
+}
+#else
 int main( ){
 #ifdef KARMAMAPPER_DEBUG
 	// Useful for debugging shaders and other inner-OF things
@@ -54,4 +77,5 @@ int main( ){
 	ofRunApp(new ofApp());
 #endif
 	
-}
\ No newline at end of file
+}
+#endif // KM_BENCHMARK_APP
@@ -65,7 +65,7 @@ void karmaModule::update(const animationParams& params){
 // - - - - - - - -
 // UTILITIES
 // - - - - - - - -
-string karmaModule::getName() const {
+const string& karmaModule::getName() const {
 	return moduleName;
 }
 
@@ -120,6 +120,15 @@ bool karmaModule::loadFromXML(ofxXmlSettings& xml){
 	return true; // todo
 }
 
+bool karmaModule::onXmlElementEnd( const karmaXmlElement& _element ){
+	if( _element.getDepth() != 0 ) return true;
+	
+	// already checked by the stream reader, empty elements give an empty document
+	ofxXmlSettings xml;
+	xml.loadFromBuffer( _element.getInnerSource() );
+	return loadFromXML( xml );
+}
+
 // Bind with factory
 namespace module
 {
@@ -10,11 +10,12 @@
 #pragma once
 
 #include "ofxXmlSettings.h"
+#include "karmaXml.h"
 #include "animationParams.h"
 #include "ofxImGui.h"
 #include "moduleFactory.h"
 
-class karmaModule {
+class karmaModule : public karmaXmlVisitor {
 	
 	friend class animationController;
 	
@@ -30,7 +31,7 @@ public:
 	virtual void draw(const animationParams& params);
 	
 	// UTILITIES
-	string getName() const;
+	const string& getName() const;
 	bool isType(const string _type) const;
 	string getType() const;
 	bool isEnabled() const;
@@ -39,6 +40,9 @@ public:
 	virtual void drawMenuEntry();
 	virtual bool saveToXML(ofxXmlSettings& xml) const;
 	virtual bool loadFromXML(ofxXmlSettings& xml);
+	// streamed loading, gets the <module> element (depth 0) and its children
+	// by default the element goes to loadFromXML() as a small ofxXmlSettings document
+	virtual bool onXmlElementEnd( const karmaXmlElement& _element );
 	
 	const bool isSingleton;
 	
@@ -78,6 +78,10 @@ void ofApp::exit(){
 	//osc.stop();
 	//analyser.stop();
 	controller.stop();
+	
+	// GL resources have to go while the window is still there
+	karmaRenderTargetPool::getInstance().shutdown();
+	shapesBatcher::getInstance().shutdown();
 }
 
 //--------------------------------------------------------------
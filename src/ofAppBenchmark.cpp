@@ -0,0 +1,396 @@
+//
+//  ofAppBenchmark.cpp
+//  karmaMapper
+//
+
+#ifdef KM_BENCHMARK_APP
+
+#include "ofAppBenchmark.h"
+#include "ofxXmlSettings.h"
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <iomanip>
+#include <new>
+
+// - - - - - - - -
+// ALLOCATION COUNTING
+// - - - - - - - -
+// global new/delete replacement, only compiled in the benchmark target
+static std::atomic<uint64_t> kmBenchmarkAllocCount(0);
+static std::atomic<uint64_t> kmBenchmarkAllocBytes(0);
+
+void* operator new(std::size_t _size){
+	kmBenchmarkAllocCount.fetch_add(1, std::memory_order_relaxed);
+	kmBenchmarkAllocBytes.fetch_add(_size, std::memory_order_relaxed);
+	
+	if( void* p = std::malloc( _size>0 ? _size : 1 ) ) return p;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* _p) noexcept {
+	std::free(_p);
+}
+
+// - - - - - - - -
+// SETTINGS
+// - - - - - - - -
+// ofToInt() silently wraps negative values into huge unsigned ones, check the whole input instead
+static bool parseUnsignedArgument(const string& _arg, const string& _value, unsigned int& _out, unsigned int _min, unsigned int _max){
+	char* end = nullptr;
+	errno = 0;
+	long long parsed = std::strtoll( _value.c_str(), &end, 10 );
+	
+	if( _value.empty() || end==nullptr || *end!='\0' || errno==ERANGE || parsed < (long long)_min || parsed > (long long)_max ){
+		ofLogError("karmaBenchmarkSettings::parseArguments") << "Invalid value for " << _arg << ": " << _value << " (expected " << _min << " to " << _max << ")";
+		return false;
+	}
+	
+	_out = (unsigned int) parsed;
+	return true;
+}
+
+bool karmaBenchmarkSettings::parseArguments(int argc, char* argv[]){
+	for(int i=1; i<argc; ++i){
+		string arg = argv[i];
+		
+		if( arg=="--help" || arg=="-h" ){
+			printUsage();
+			return false;
+		}
+		
+		if( arg=="--convert" ){
+			if( i+2 >= argc ){
+				ofLogError("karmaBenchmarkSettings::parseArguments") << "--convert needs an input and an output file";
+				printUsage();
+				return false;
+			}
+			convertFrom = argv[++i];
+			convertTo = argv[++i];
+			continue;
+		}
+		
+		// all other options take a value
+		if( i+1 >= argc ){
+			ofLogError("karmaBenchmarkSettings::parseArguments") << "Missing value for " << arg;
+			printUsage();
+			return false;
+		}
+		string value = argv[++i];
+		
+		bool bValid = true;
+		unsigned int size = 0;
+		if( arg=="--frames" ) bValid = parseUnsignedArgument(arg, value, frames, 1, 10000000);
+		else if( arg=="--warmup" ) bValid = parseUnsignedArgument(arg, value, warmupFrames, 0, 10000000);
+		else if( arg=="--shapes" ) bValid = parseUnsignedArgument(arg, value, numShapes, 0, 1000000);
+		else if( arg=="--vertices" ) bValid = parseUnsignedArgument(arg, value, numVertices, 3, 1000000);
+		else if( arg=="--effects" ) bValid = parseUnsignedArgument(arg, value, numEffects, 0, 10000);
+		else if( arg=="--layers" ) bValid = parseUnsignedArgument(arg, value, numLayers, 1, 1000);
+		else if( arg=="--seed" ) bValid = parseUnsignedArgument(arg, value, seed, 0, UINT_MAX);
+		else if( arg=="--width" ){
+			bValid = parseUnsignedArgument(arg, value, size, 1, 16384);
+			if( bValid ) width = size;
+		}
+		else if( arg=="--height" ){
+			bValid = parseUnsignedArgument(arg, value, size, 1, 16384);
+			if( bValid ) height = size;
+		}
+		else if( arg=="--effect-types" ) effectTypes = ofSplitString(value, ",", true, true);
+		else if( arg=="--out" ) outputFile = value;
+		else if( arg=="--scene" ) sceneFile = value;
+		else if( arg=="--quantize" ) bQuantize = ofToBool(value);
+		else if( arg=="--pipelined" ) bPipelined = ofToBool(value);
+		else {
+			ofLogError("karmaBenchmarkSettings::parseArguments") << "Unknown argument: " << arg;
+			printUsage();
+			return false;
+		}
+		
+		if( !bValid ){
+			printUsage();
+			return false;
+		}
+	}
+	
+	if( numEffects > 0 && effectTypes.size()==0 ){
+		ofLogError("karmaBenchmarkSettings::parseArguments") << "--effect-types can't be empty.";
+		return false;
+	}
+	
+	return true;
+}
+
+void karmaBenchmarkSettings::printUsage(){
+	cout << "karmaMapper benchmark" << endl;
+	cout << "  --frames N          measured frames (default 600)" << endl;
+	cout << "  --warmup N          frames run before measuring (default 60)" << endl;
+	cout << "  --shapes N          generated vertexShapes (default 200)" << endl;
+	cout << "  --vertices N        vertices per shape (default 16)" << endl;
+	cout << "  --effects N         effect instances, bound to all shapes (default 8)" << endl;
+	cout << "  --layers N          render layers, effects are spread over them (default 1)" << endl;
+	cout << "  --effect-types a,b  effect types to instantiate, round-robin (default basicEffect,distortEffect,lineDrawEffect)" << endl;
+	cout << "  --seed N            random seed (default 1)" << endl;
+	cout << "  --width N --height N  virtual output size (default 1920x1080)" << endl;
+	cout << "  --out file.json     results file, relative to the data folder (default benchmark/results.json)" << endl;
+	cout << "  --pipelined 0|1     update the next frame while the current one renders, if all effects can (default 0)" << endl;
+	cout << "  --scene file        load this scene (xml or ." << KM_BINARY_SCENE_EXTENSION << ") instead of generating one" << endl;
+	cout << "  --convert in out    convert a scene between xml and ." << KM_BINARY_SCENE_EXTENSION << " (by extension), then exit" << endl;
+	cout << "  --quantize 0|1      store 16 bit vertices when converting to ." << KM_BINARY_SCENE_EXTENSION << " (default 0)" << endl;
+}
+
+// - - - - - - - -
+// CONSTRUCTORS
+// - - - - - - - -
+ofAppBenchmark::ofAppBenchmark(const karmaBenchmarkSettings& _settings): settings(_settings), controller( scene ) {
+	bFailed = false;
+	measuredFrames = 0;
+	pipelinedFrames = 0;
+	lastFrameTime = 0;
+	lastAllocCount = 0;
+	lastAllocBytes = 0;
+	sceneLoadMillis = 0;
+}
+
+ofAppBenchmark::~ofAppBenchmark(){
+	ofRemoveListener( ofEvents().draw, this, &ofAppBenchmark::_afterDraw );
+}
+
+void ofAppBenchmark::setup(){
+	// run as fast as possible
+	ofSetFrameRate(0);
+	ofSeedRandom(settings.seed);
+	
+	// identical animation on every run, whatever the machine
+	controller.getAnimationParamsServer().setSeed(settings.seed);
+	controller.getAnimationParamsServer().getClock().setFixedTimestep(true, 60);
+	
+	controller.start();
+	// measure the full workload, no adaptive quality
+	controller.getFrameGovernor().setEnabled(false);
+	controller.setPipelinedUpdates(settings.bPipelined);
+	controller.unloadAllLayers();
+	
+	if( !generateScene() || !generateEffects() ){
+		ofLogError("ofAppBenchmark::setup") << "Could not generate the benchmark scene, exiting.";
+		bFailed = true;
+		ofExit(1);
+		return;
+	}
+	
+	frameTimes.reserve(settings.frames);
+	frameAllocs.reserve(settings.frames);
+	frameAllocBytes.reserve(settings.frames);
+	
+	ofAddListener( ofEvents().draw, this, &ofAppBenchmark::_afterDraw, OF_EVENT_ORDER_AFTER_APP+1000 );
+	
+	ofLogNotice("ofAppBenchmark::setup") << "Running " << settings.warmupFrames << " + " << settings.frames << " frames with " << settings.numShapes << " shapes x " << settings.numVertices << " vertices x " << settings.numEffects << " effects.";
+}
+
+void ofAppBenchmark::exit(){
+	controller.stop();
+	
+	karmaRenderTargetPool::getInstance().shutdown();
+	shapesBatcher::getInstance().shutdown();
+}
+
+// - - - - - - - -
+// SCENE GENERATION
+// - - - - - - - -
+bool ofAppBenchmark::generateScene(){
+	scene.unloadShapes();
+	
+	if( !settings.sceneFile.empty() ){
+		uint64_t start = ofGetElapsedTimeMicros();
+		if( !scene.loadScene( settings.sceneFile ) ) return false;
+		sceneLoadMillis = (ofGetElapsedTimeMicros()-start) / 1000.f;
+		
+		// report what was loaded
+		unsigned int numVertices = 0;
+		for(auto it=scene.getShapesItConstBegin(); it!=scene.getShapesItConstEnd(); ++it){
+			if( (*it)->isType("vertexShape") ) numVertices += ((vertexShape*)*it)->getRenderVertices().size;
+		}
+		settings.numShapes = scene.getNumShapes();
+		settings.numVertices = settings.numShapes>0 ? numVertices/settings.numShapes : 0;
+		return true;
+	}
+	
+	if( settings.numShapes == 0 ) return true;
+	
+	// shapes are laid out on a grid, each one is a circle-ish polygon
+	unsigned int cols = ceil( sqrt( (float)settings.numShapes ) );
+	unsigned int rows = ceil( settings.numShapes / (float)cols );
+	float cellWidth = settings.width / (float)cols;
+	float cellHeight = settings.height / (float)rows;
+	float radius = MIN(cellWidth, cellHeight) * 0.4f;
+	
+	// build each shape through its xml loader, same path as a saved scene
+	for(unsigned int s=0; s<settings.numShapes; ++s){
+		ofxXmlSettings xml;
+		xml.addTag("position");
+		xml.pushTag("position");
+		xml.addValue("X", (s%cols + 0.5f) * cellWidth );
+		xml.addValue("Y", (s/cols + 0.5f) * cellHeight );
+		xml.popTag();
+		xml.addValue("groupID", (int)(s%4) );
+		xml.addValue("shapeName", "benchmarkShape" + ofToString(s) );
+		
+		xml.addTag("vectors");
+		xml.pushTag("vectors");
+		for(unsigned int v=0; v<settings.numVertices; ++v){
+			float angle = TWO_PI * v / settings.numVertices;
+			// some jitter for non-regular polygons
+			float r = radius * ofRandom(0.8f, 1.f);
+			xml.addTag("vector");
+			xml.pushTag("vector", v);
+			xml.addValue("X", cos(angle) * r );
+			xml.addValue("Y", sin(angle) * r );
+			xml.popTag();
+		}
+		xml.popTag(); // pop vectors
+		
+		basicShape* shape = shape::create("vertexShape", basicPoint(0,0) );
+		if( shape == nullptr ){
+			ofLogError("ofAppBenchmark::generateScene") << "Shape type vertexShape not found.";
+			return false;
+		}
+		if( !shape->loadFromXML(xml) || scene.insertShape(shape) == NULL ){
+			ofLogError("ofAppBenchmark::generateScene") << "Failed creating shape " << s;
+			delete shape;
+			return false;
+		}
+	}
+	
+	return true;
+}
+
+bool ofAppBenchmark::generateEffects(){
+	vector<karmaFboLayer*> layers;
+	for(unsigned int l=0; l<settings.numLayers; ++l){
+		layers.push_back( &controller.addLayer("Benchmark Layer " + ofToString(l)) );
+	}
+	
+	for(unsigned int i=0; i<settings.numEffects; ++i){
+		const string& type = settings.effectTypes[ i % settings.effectTypes.size() ];
+		
+		basicEffect* e = effect::create(type);
+		if( e == nullptr ){
+			ofLogError("ofAppBenchmark::generateEffects") << "Effect type not found: " << type;
+			return false;
+		}
+		
+		e->setIndex(i);
+		e->initialise( controller.getAnimationParams() );
+		e->bindWithShapes( scene.getShapesRef() );
+		e->enable();
+		
+		if( !controller.addEffect( e, *layers[ i % layers.size() ] ) ){
+			delete e;
+			return false;
+		}
+	}
+	
+	return true;
+}
+
+// - - - - - - - -
+// MEASUREMENTS
+// - - - - - - - -
+void ofAppBenchmark::_afterDraw(ofEventArgs &e){
+	if( bFailed ) return;
+	
+	uint64_t now = ofGetElapsedTimeMicros();
+	uint64_t allocCount = kmBenchmarkAllocCount.load(std::memory_order_relaxed);
+	uint64_t allocBytes = kmBenchmarkAllocBytes.load(std::memory_order_relaxed);
+	
+	unsigned int frame = ofGetFrameNum();
+	
+	// start measuring after warmup
+	if( frame == settings.warmupFrames ){
+		karmaRenderRecorder::get().reset();
+	}
+	else if( frame > settings.warmupFrames ){
+		frameTimes.push_back( (now - lastFrameTime) / 1000.f );
+		frameAllocs.push_back( allocCount - lastAllocCount );
+		frameAllocBytes.push_back( allocBytes - lastAllocBytes );
+		if( controller.isPipelining() ) pipelinedFrames++;
+		measuredFrames++;
+	}
+	
+	lastFrameTime = now;
+	lastAllocCount = allocCount;
+	lastAllocBytes = allocBytes;
+	
+	if( measuredFrames >= settings.frames ){
+		recordedCalls = karmaRenderRecorder::get();
+		bool success = writeResults();
+		bFailed = true; // stop measuring
+		ofExit( success ? 0 : 1 );
+	}
+}
+
+// nearest-rank percentile on a sorted vector
+template<typename T>
+static T getPercentile(const vector<T>& _sorted, float _percentile){
+	if( _sorted.size()==0 ) return T();
+	size_t rank = ceil( _percentile/100.f * _sorted.size() );
+	rank = MIN( MAX(rank, 1), _sorted.size() );
+	return _sorted[ rank-1 ];
+}
+
+template<typename T>
+static double getMean(const vector<T>& _values){
+	if( _values.size()==0 ) return 0;
+	double sum = 0;
+	for(auto it=_values.begin(); it!=_values.end(); ++it) sum += *it;
+	return sum / _values.size();
+}
+
+bool ofAppBenchmark::writeResults(){
+	vector<float> times = frameTimes;
+	vector<uint64_t> allocs = frameAllocs;
+	std::sort(times.begin(), times.end());
+	std::sort(allocs.begin(), allocs.end());
+	
+	uint64_t totalAllocs = 0;
+	for(auto it=frameAllocs.begin(); it!=frameAllocs.end(); ++it) totalAllocs += *it;
+	
+	double n = MAX(1, measuredFrames);
+	
+	std::stringstream json;
+	json << std::fixed << std::setprecision(4);
+	json << "{" << endl;
+	json << "\t\"version\": \"" << KM_VERSION << "\"," << endl;
+	json << "\t\"vertexKernels\": \"" << vertexKernels::getInstructionSet() << "\"," << endl;
+	json << "\t\"scene\": { \"shapes\": " << settings.numShapes << ", \"verticesPerShape\": " << settings.numVertices << ", \"effects\": " << settings.numEffects << ", \"layers\": " << settings.numLayers << ", \"width\": " << settings.width << ", \"height\": " << settings.height << ", \"seed\": " << settings.seed << ", \"effectTypes\": [";
+	for(auto it=settings.effectTypes.begin(); it!=settings.effectTypes.end(); ++it){
+		json << (it==settings.effectTypes.begin()?"":", ") << "\"" << *it << "\"";
+	}
+	json << "] }," << endl;
+	json << "\t\"sceneFile\": \"" << settings.sceneFile << "\"," << endl;
+	json << "\t\"sceneLoadMillis\": " << sceneLoadMillis << "," << endl;
+	json << "\t\"frames\": " << measuredFrames << "," << endl;
+	json << "\t\"warmupFrames\": " << settings.warmupFrames << "," << endl;
+	json << "\t\"pipelined\": { \"requested\": " << (settings.bPipelined?"true":"false") << ", \"frames\": " << pipelinedFrames << " }," << endl;
+	json << "\t\"frameTimeMillis\": { \"mean\": " << getMean(times) << ", \"min\": " << getPercentile(times, 0) << ", \"p50\": " << getPercentile(times, 50) << ", \"p95\": " << getPercentile(times, 95) << ", \"p99\": " << getPercentile(times, 99) << ", \"max\": " << getPercentile(times, 100) << " }," << endl;
+	json << "\t\"allocations\": { \"total\": " << totalAllocs << ", \"perFrameMean\": " << getMean(allocs) << ", \"perFrameP50\": " << getPercentile(allocs, 50) << ", \"perFrameP99\": " << getPercentile(allocs, 99) << ", \"perFrameMax\": " << getPercentile(allocs, 100) << ", \"bytesPerFrameMean\": " << getMean(frameAllocBytes) << " }," << endl;
+	json << "\t\"recordedCallsPerFrame\": { \"shapeDraws\": " << recordedCalls.shapeDraws/n << ", \"vertices\": " << recordedCalls.vertices/n << ", \"layerBinds\": " << recordedCalls.layerBinds/n << ", \"layerSwaps\": " << recordedCalls.layerSwaps/n << ", \"layerClears\": " << recordedCalls.layerClears/n << ", \"layerComposites\": " << recordedCalls.layerComposites/n << ", \"layerCacheHits\": " << recordedCalls.layerCacheHits/n << ", \"layerAllocations\": " << recordedCalls.layerAllocations/n << ", \"renderTargetAllocations\": " << recordedCalls.renderTargetAllocations/n << ", \"batchDraws\": " << recordedCalls.batchDraws/n << ", \"batchUploadedBytes\": " << recordedCalls.batchUploadedBytes/n << " }," << endl;
+	json << "\t\"renderTargetBytes\": " << karmaRenderTargetPool::getInstance().getAllocatedBytes() << endl;
+	json << "}" << endl;
+	
+	cout << json.str();
+	
+	if( settings.outputFile.empty() ) return true;
+	
+	string path = ofToDataPath(settings.outputFile, true);
+	ofDirectory::createDirectory( ofFilePath::getEnclosingDirectory(path), false, true );
+	if( !ofBufferToFile( path, ofBuffer( json.str().c_str(), json.str().size() ) ) ){
+		ofLogError("ofAppBenchmark::writeResults") << "Could not write " << path;
+		return false;
+	}
+	
+	ofLogNotice("ofAppBenchmark::writeResults") << "Results saved to " << path;
+	return true;
+}
+
+#endif // KM_BENCHMARK_APP
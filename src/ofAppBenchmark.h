@@ -0,0 +1,87 @@
+//
+//  ofAppBenchmark.h
+//  karmaMapper
+//
+//	Headless benchmark target (KM_BENCHMARK_APP).
+//	Generates a scene, runs the animationController for N frames without a GL context and writes frame time percentiles and allocation counts as JSON.
+//
+//	usage: karmaMapper --frames 600 --warmup 60 --shapes 200 --vertices 16 --effects 8 --layers 2 --effect-types basicEffect,distortEffect --out benchmark/results.json
+//	Pipelined updates: add --pipelined 1, "pipelined.frames" in the results tells how many frames really ran that way
+//	(the default effect types all can, videoShader and effects that didn't opt in turn it off, see basicEffect::canUpdateAheadOfRender()).
+//	Also converts scenes: karmaMapper --convert scenes/venue.xml scenes/venue.kmscene [--quantize 1]
+//
+
+#pragma once
+
+#ifdef KM_BENCHMARK_APP
+
+#include "ofMain.h"
+#include "KMSettings.h"
+#include "shapes.h"
+#include "shapesDB.h"
+#include "effects.h"
+#include "animationController.h"
+#include "karmaRenderRecorder.h"
+#include "karmaRenderTargetPool.h"
+#include "vertexKernels.h"
+
+struct karmaBenchmarkSettings {
+	unsigned int frames = 600;
+	unsigned int warmupFrames = 60;
+	unsigned int numShapes = 200;
+	unsigned int numVertices = 16; // per shape
+	unsigned int numEffects = 8;
+	unsigned int numLayers = 1;
+	unsigned int seed = 1;
+	int width = 1920;
+	int height = 1080;
+	vector<string> effectTypes = { "basicEffect", "distortEffect", "lineDrawEffect" };
+	string outputFile = "benchmark/results.json";
+	string sceneFile; // loaded instead of generating shapes
+	bool bPipelined = false; // run the next frame's update while the current one renders
+	
+	// scene conversion mode
+	string convertFrom;
+	string convertTo;
+	bool bQuantize = false;
+	
+	// returns false on invalid arguments or --help
+	bool parseArguments(int argc, char* argv[]);
+	static void printUsage();
+};
+
+class ofAppBenchmark : public ofBaseApp {
+
+public:
+	ofAppBenchmark(const karmaBenchmarkSettings& _settings);
+	~ofAppBenchmark();
+	
+	void setup();
+	void exit();
+	
+	// measures frame boundaries, called after everything else has drawn
+	void _afterDraw( ofEventArgs& e );
+
+private:
+	bool generateScene();
+	bool generateEffects();
+	bool writeResults();
+	
+	karmaBenchmarkSettings settings;
+	shapesDB scene;
+	animationController controller;
+	
+	bool bFailed;
+	unsigned int measuredFrames;
+	unsigned int pipelinedFrames; // measured frames which had the next update running ahead
+	uint64_t lastFrameTime; // micros
+	uint64_t lastAllocCount;
+	uint64_t lastAllocBytes;
+	vector<float> frameTimes; // ms
+	vector<uint64_t> frameAllocs;
+	vector<uint64_t> frameAllocBytes;
+	karmaRecordedCalls recordedCalls;
+	float sceneLoadMillis;
+};
+
+#endif // KM_BENCHMARK_APP
@@ -0,0 +1,83 @@
+//
+//  animationClock.cpp
+//  karmaMapper
+//
+//
+
+#include "animationClock.h"
+
+// - - - - - - - -
+// CONSTRUCTORS
+// - - - - - - - -
+animationClock::animationClock() : bFixedTimestep(false), fixedFps(60.f) {
+	setTimeSource( [](){ return ofGetElapsedTimeMicros()/1000000.0; } );
+}
+
+// - - - - - - - -
+// METHODS
+// - - - - - - - -
+void animationClock::tick(){
+	double previous = elapsedTime;
+	ticks++;
+	
+	if( bFixedTimestep ){
+		// no accumulation, keeps the same value on every run
+		elapsedTime = ticks/(double)fixedFps;
+	}
+	else {
+		elapsedTime = timeSource() - startTime;
+	}
+	
+	deltaTime = elapsedTime - previous;
+}
+
+void animationClock::reset(){
+	startTime = timeSource();
+	elapsedTime = 0;
+	deltaTime = 0;
+	ticks = 0;
+}
+
+void animationClock::setFixedTimestep( bool _enabled, float _fps ){
+	if( _fps <= 0 ){
+		ofLogWarning("animationClock::setFixedTimestep") << "Invalid fps (" << _fps << "), ignoring.";
+		return;
+	}
+	
+	bFixedTimestep = _enabled;
+	fixedFps = _fps;
+	reset();
+}
+
+bool animationClock::isFixedTimestep() const {
+	return bFixedTimestep;
+}
+
+float animationClock::getFixedFps() const {
+	return fixedFps;
+}
+
+void animationClock::setTimeSource( const std::function<double()>& _source ){
+	if( !_source ){
+		ofLogWarning("animationClock::setTimeSource") << "Empty time source, ignoring.";
+		return;
+	}
+	
+	timeSource = _source;
+	reset();
+}
+
+// - - - - - - - -
+// GETTERS
+// - - - - - - - -
+double animationClock::getElapsedTime() const {
+	return elapsedTime;
+}
+
+float animationClock::getDeltaTime() const {
+	return deltaTime;
+}
+
+uint64_t animationClock::getTicks() const {
+	return ticks;
+}
@@ -0,0 +1,44 @@
+//
+//  animationClock.h
+//  karmaMapper
+//
+//	Time source of the animation. Ticks once per update.
+//	In fixed timestep mode every tick advances exactly 1/fps seconds, whatever the real frame rate, so recordings and benchmarks replay identically.
+//	The time source can be replaced (offline rendering, replays, ...).
+
+#pragma once
+
+#include "ofMain.h"
+#include <functional>
+
+class animationClock {
+
+public:
+	animationClock();
+	
+	// call once per update
+	void tick();
+	void reset();
+	
+	void setFixedTimestep( bool _enabled, float _fps = 60.f );
+	bool isFixedTimestep() const;
+	float getFixedFps() const;
+	
+	// returns the time in seconds, only used when not in fixed timestep mode
+	void setTimeSource( const std::function<double()>& _source );
+	
+	double getElapsedTime() const; // sec
+	float getDeltaTime() const; // sec
+	uint64_t getTicks() const;
+
+private:
+	std::function<double()> timeSource;
+	
+	bool bFixedTimestep;
+	float fixedFps;
+	
+	double startTime;
+	double elapsedTime;
+	float deltaTime;
+	uint64_t ticks;
+};
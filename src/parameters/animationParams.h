@@ -61,7 +61,9 @@ struct animationParams {
 	elapsedUpdates(0),
 	elapsedFrames(0),
 	elapsedTime(0.f),
+	deltaTime(0.f),
 	idleTimeMillis(0),
+	seed(1),
 	uniqueID(""),
 	uniqueIDAlt(""),
 	userChain("")
@@ -70,9 +72,13 @@ struct animationParams {
 	float fps;
 	unsigned int elapsedUpdates;
 	unsigned int elapsedFrames;
-	float elapsedTime;
+	float elapsedTime; // from the animation clock, use this rather than ofGetElapsedTimef()
+	float deltaTime; // since last update
 	uint32_t idleTimeMillis;
 	
+	// base seed for the effects' random streams
+	uint32_t seed;
+	
 	// used for customising effects and synchronising their
 	string uniqueID; // hex string
 	string uniqueIDAlt;
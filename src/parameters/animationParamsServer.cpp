@@ -8,6 +8,7 @@
 
 #include "animationParamsServer.h"
 #include <cmath>     // for fmod
+#include "karmaRandom.h"
 //#include <functional> // for std::modulus
 
 // - - - - - - - -
@@ -16,7 +17,11 @@
 
 animationParamsServer::animationParamsServer(){
 	bShowParams = false;
+	params.seed = ofGetUnixTime();
 	randomize();
+	
+	// no GL context in the benchmark target
+#ifndef KM_BENCHMARK_APP
 	paramsGui.setup("Animation Parameters");
 	//paramsGui.add( new ofxGuiSpacer() );
 	paramsGuiFbo.allocate(KM_AP_guiTextureWidth, KM_AP_guiTextureHeight, GL_RGBA);
@@ -25,6 +30,7 @@ animationParamsServer::animationParamsServer(){
 	paramsGuiFbo.end();
 	paramsGui.add( new ofxGuiBaseDraws( &paramsGuiFbo.getTexture() ) );
 	paramsGui.unregisterMouseEvents();
+#endif
 	
 	// bind
 	ofAddListener( ofEvents().draw , this, &animationParamsServer::_draw, OF_EVENT_ORDER_AFTER_APP );
@@ -66,12 +72,23 @@ void animationParamsServer::randomize(){
 	params.uniqueID = ss.str();
 	
 	// randomize colors
-	params.varyingColors.main = ofFloatColor::fromHsb(ofRandom(0.5f,.8f), ofRandom(0.5f,.7f), ofRandom(0.5f,.8f) );
+	karmaRandom random( params.seed );
+	params.varyingColors.main = ofFloatColor::fromHsb(random.getRange(0.5f,.8f), random.getRange(0.5f,.7f), random.getRange(0.5f,.8f) );
 	params.varyingColors.secondary = params.varyingColors.main;
 	params.varyingColors.secondary.setHue( fmod(params.varyingColors.main.getHue()-0.3f, 1));
 }
 
+void animationParamsServer::setSeed( uint32_t _seed ){
+	params.seed = _seed;
+	randomize();
+}
+
+animationClock& animationParamsServer::getClock(){
+	return clock;
+}
+
 void animationParamsServer::setShowParams(const bool &_b){
+#ifndef KM_BENCHMARK_APP
 	if( _b != bShowParams ){
 		// enable
 		if(_b){
@@ -83,6 +100,7 @@ void animationParamsServer::setShowParams(const bool &_b){
 		}
 		bShowParams = _b;
 	}
+#endif
 }
 
 //
@@ -92,8 +110,11 @@ void animationParamsServer::setShowParams(const bool &_b){
 // update the params
 void animationParamsServer::_update(ofEventArgs &e){
 	
-	params.fps = ofGetFrameRate();
-	params.elapsedTime = ofGetElapsedTimef();
+	clock.tick();
+	params.elapsedUpdates++;
+	params.elapsedTime = clock.getElapsedTime();
+	params.deltaTime = clock.getDeltaTime();
+	params.fps = clock.isFixedTimestep() ? clock.getFixedFps() : ofGetFrameRate();
 	
 	// set seasons
 	// formulaes used: (synchronized)
@@ -120,7 +141,7 @@ void animationParamsServer::_update(ofEventArgs &e){
 	
 	// change colors
 	// todo: make this more interesting
-	params.varyingColors.main.setHue( fmod(params.varyingColors.main.getHue()+ (0.0005f+params.seasons.summer*0.003f)*(ofGetFrameRate()/60), 1) );
+	params.varyingColors.main.setHue( fmod(params.varyingColors.main.getHue()+ (0.0005f+params.seasons.summer*0.003f)*(params.deltaTime*60), 1) );
 	params.varyingColors.secondary.setHue( fmod(params.varyingColors.main.getHue()+0.3f,1) );
 }
 
@@ -12,6 +12,7 @@
 #include "ofxGui.h"
 #include "ofxGuiExtended.h"
 #include "animationParams.h"
+#include "animationClock.h"
 
 #define KMAnimSeasonsYear 20 // (sec) year cycle duration
 
@@ -32,6 +33,8 @@ public:
 	// methods
 	void randomize();
 	void setShowParams(const bool& _b );
+	void setSeed( uint32_t _seed ); // re-randomizes
+	animationClock& getClock();
 	
 	// listeners
 	void _update( ofEventArgs& e );
@@ -42,6 +45,8 @@ public:
 	
 	
 private:
+	animationClock clock;
+	
 	bool bShowParams;
 	ofFbo paramsGuiFbo;
 	ofxPanelExtended paramsGui;
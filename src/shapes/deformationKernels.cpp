@@ -0,0 +1,189 @@
+//
+//  deformationKernels.cpp
+//  karmaMapper
+//
+
+#include "deformationKernels.h"
+#include "vertexSimd.h"
+
+// golden angle, spreads the phases of consecutive spans
+#define KM_DEFORM_SPAN_PHASE 2.39996323f
+
+// - - - - - - - -
+// HELPERS
+// - - - - - - - -
+namespace {
+
+// sin(_x) in radians: reduction to [-pi, pi), then a parabola with one correction step
+inline kmFloatV kmFastSin( kmFloatV _x ){
+	kmFloatV t = kmMul( _x, kmSet(0.15915494f) ); // in turns
+	t = kmSub( t, kmFloor( kmAdd(t, kmSet(.5f)) ) );
+	kmFloatV u = kmMul( t, kmSet(2.f) ); // sin(PI*u), u in [-1,1)
+	kmFloatV y = kmMul( kmMul( u, kmSet(4.f) ), kmSub( kmSet(1.f), kmAbs(u) ) );
+	return kmAdd( kmMul( kmSub( kmMul(y, kmAbs(y)), y ), kmSet(.225f) ), y );
+}
+
+inline kmFloatV kmFastCos( kmFloatV _x ){
+	return kmFastSin( kmAdd( _x, kmSet(HALF_PI) ) );
+}
+
+// calls _op(x, y, spanNumber) on KM_SIMD_WIDTH vertices at a time, it alters x and y in place
+// the tail of each span goes through a padded copy so kernels have a single code path
+template<class OP>
+void forEachBlock( const vector<vertexSpan>& _spans, unsigned int _firstSpan, OP _op ){
+	for(unsigned int s=0; s<_spans.size(); ++s){
+		const vertexSpan& span = _spans[s];
+		const unsigned int spanNumber = _firstSpan+s;
+		
+		unsigned int i = 0;
+		for(; i+KM_SIMD_WIDTH<=span.size; i+=KM_SIMD_WIDTH){
+			kmFloatV x = kmLoad( span.x+i );
+			kmFloatV y = kmLoad( span.y+i );
+			_op( x, y, spanNumber );
+			kmStore( span.x+i, x );
+			kmStore( span.y+i, y );
+		}
+		
+		if( i < span.size ){
+			float tailX[KM_SIMD_WIDTH] = {0};
+			float tailY[KM_SIMD_WIDTH] = {0};
+			unsigned int n = span.size-i;
+			memcpy( tailX, span.x+i, n*sizeof(float) );
+			memcpy( tailY, span.y+i, n*sizeof(float) );
+			kmFloatV x = kmLoad( tailX );
+			kmFloatV y = kmLoad( tailY );
+			_op( x, y, spanNumber );
+			kmStore( tailX, x );
+			kmStore( tailY, y );
+			memcpy( span.x+i, tailX, n*sizeof(float) );
+			memcpy( span.y+i, tailY, n*sizeof(float) );
+		}
+	}
+}
+
+}
+
+// - - - - - - - -
+// KERNELS
+// - - - - - - - -
+void deformationKernels::apply( const vector<vertexSpan>& _spans, const deformationSettings& _settings, const animationParams& _params, float _amount, unsigned int _firstSpan ){
+	const float amplitude = _settings.amplitude * _amount;
+	const float phase = _params.elapsedTime * _settings.speed * TWO_PI;
+	
+	switch( _settings.type ){
+		case DEFORM_SINE_WAVE:
+			sineWave( _spans, amplitude, _settings.frequency, phase, _firstSpan );
+			break;
+		case DEFORM_NOISE:
+			noise( _spans, amplitude, _settings.frequency, _params.elapsedTime * _settings.speed, _firstSpan );
+			break;
+		case DEFORM_RADIAL_PULSE:
+			radialPulse( _spans, amplitude, _settings.frequency, phase, _firstSpan );
+			break;
+		case DEFORM_TWIST:
+			// amplitude is the angle, swinging back and forth
+			twist( _spans, amplitude * sin(phase), _settings.frequency );
+			break;
+		case DEFORM_SCALE:
+			scale( _spans, 1.f + amplitude );
+			break;
+		case DEFORM_NONE:
+		default:
+			break;
+	}
+}
+
+void deformationKernels::sineWave( const vector<vertexSpan>& _spans, float _amplitude, float _frequency, float _phase, unsigned int _firstSpan ){
+	const kmFloatV amplitude = kmSet( _amplitude );
+	const kmFloatV frequency = kmSet( _frequency );
+	
+	forEachBlock( _spans, _firstSpan, [&]( kmFloatV& x, kmFloatV& y, unsigned int s ){
+		const kmFloatV phase = kmSet( _phase + s*KM_DEFORM_SPAN_PHASE );
+		kmFloatV dx = kmMul( amplitude, kmFastSin( kmAdd( kmMul(y, frequency), phase ) ) );
+		kmFloatV dy = kmMul( amplitude, kmFastCos( kmAdd( kmMul(x, frequency), phase ) ) );
+		x = kmAdd( x, dx );
+		y = kmAdd( y, dy );
+	});
+}
+
+void deformationKernels::noise( const vector<vertexSpan>& _spans, float _amplitude, float _frequency, float _time, unsigned int _firstSpan ){
+	const kmFloatV amplitude = kmSet( _amplitude * .5f );
+	const kmFloatV frequency = kmSet( _frequency );
+	
+	// time terms are the same for all vertices
+	const float t = _time * TWO_PI;
+	
+	forEachBlock( _spans, _firstSpan, [&]( kmFloatV& x, kmFloatV& y, unsigned int s ){
+		const float k = s*KM_DEFORM_SPAN_PHASE;
+		kmFloatV fx = kmMul( x, frequency );
+		kmFloatV fy = kmMul( y, frequency );
+		
+		kmFloatV dx = kmAdd(
+			kmFastSin( kmAdd( kmAdd( kmMul(fy, kmSet(1.73f)), kmMul(fx, kmSet(.41f)) ), kmSet(1.31f*t + k) ) ),
+			kmFastSin( kmAdd( kmSub( kmMul(fx, kmSet(2.27f)), kmMul(fy, kmSet(.83f)) ), kmSet(-.67f*t + 2.f*k) ) )
+		);
+		kmFloatV dy = kmAdd(
+			kmFastSin( kmAdd( kmSub( kmMul(fx, kmSet(1.91f)), kmMul(fy, kmSet(.37f)) ), kmSet(.97f*t + 3.f*k) ) ),
+			kmFastSin( kmAdd( kmAdd( kmMul(fy, kmSet(2.41f)), kmMul(fx, kmSet(.59f)) ), kmSet(-1.13f*t + 5.f*k) ) )
+		);
+		x = kmAdd( x, kmMul( dx, amplitude ) );
+		y = kmAdd( y, kmMul( dy, amplitude ) );
+	});
+}
+
+void deformationKernels::radialPulse( const vector<vertexSpan>& _spans, float _amplitude, float _frequency, float _phase, unsigned int _firstSpan ){
+	const kmFloatV amplitude = kmSet( _amplitude );
+	const kmFloatV frequency = kmSet( _frequency );
+	const kmFloatV epsilon = kmSet( 1e-6f ); // the origin stays put
+	
+	forEachBlock( _spans, _firstSpan, [&]( kmFloatV& x, kmFloatV& y, unsigned int s ){
+		const kmFloatV phase = kmSet( _phase + s*KM_DEFORM_SPAN_PHASE );
+		kmFloatV distSq = kmAdd( kmAdd( kmMul(x, x), kmMul(y, y) ), epsilon );
+		kmFloatV invDist = kmRsqrt( distSq );
+		kmFloatV dist = kmMul( distSq, invDist );
+		
+		// offset along the unit radius
+		kmFloatV offset = kmMul( amplitude, kmFastSin( kmSub( kmMul(dist, frequency), phase ) ) );
+		kmFloatV factor = kmAdd( kmSet(1.f), kmMul( offset, invDist ) );
+		x = kmMul( x, factor );
+		y = kmMul( y, factor );
+	});
+}
+
+void deformationKernels::twist( const vector<vertexSpan>& _spans, float _angle, float _frequency ){
+	const kmFloatV angle = kmSet( _angle * _frequency );
+	const kmFloatV epsilon = kmSet( 1e-6f );
+	
+	// same for every span, their number doesn't matter
+	forEachBlock( _spans, 0, [&]( kmFloatV& x, kmFloatV& y, unsigned int ){
+		kmFloatV distSq = kmAdd( kmAdd( kmMul(x, x), kmMul(y, y) ), epsilon );
+		kmFloatV a = kmMul( kmMul( distSq, kmRsqrt(distSq) ), angle );
+		kmFloatV sinA = kmFastSin( a );
+		kmFloatV cosA = kmFastCos( a );
+		kmFloatV rx = kmSub( kmMul(x, cosA), kmMul(y, sinA) );
+		y = kmAdd( kmMul(x, sinA), kmMul(y, cosA) );
+		x = rx;
+	});
+}
+
+void deformationKernels::scale( const vector<vertexSpan>& _spans, float _scale ){
+	const kmFloatV scale = kmSet( _scale );
+	
+	// same for every span, their number doesn't matter
+	forEachBlock( _spans, 0, [&]( kmFloatV& x, kmFloatV& y, unsigned int ){
+		x = kmMul( x, scale );
+		y = kmMul( y, scale );
+	});
+}
+
+const char* deformationKernels::getName( deformationType _type ){
+	switch( _type ){
+		case DEFORM_SINE_WAVE: return "Sine wave";
+		case DEFORM_NOISE: return "Noise";
+		case DEFORM_RADIAL_PULSE: return "Radial pulse";
+		case DEFORM_TWIST: return "Twist";
+		case DEFORM_SCALE: return "Scale";
+		case DEFORM_NONE:
+		default: return "None";
+	}
+}
@@ -0,0 +1,62 @@
+//
+//  deformationKernels.h
+//  karmaMapper
+//
+//	Vertex deformations for distort-like effects, run on a batch of vertex spans (usually one per shape) per call.
+//	Vectorized like vertexKernels, trigonometry uses a fast approximation (error ~0.001), distances a reciprocal square root estimate.
+//	Spans hold relative coordinates: the shape's position is the origin of pulses and twists.
+//
+
+#pragma once
+
+#include "ofMain.h"
+#include "vertexPool.h"
+#include "animationParams.h"
+
+enum deformationType {
+	// note: saved in configurations, only append
+	DEFORM_NONE = 0,
+	DEFORM_SINE_WAVE = 1,
+	DEFORM_NOISE = 2,
+	DEFORM_RADIAL_PULSE = 3,
+	DEFORM_TWIST = 4,
+	DEFORM_SCALE = 5, // amplitude is the scale change, 0.1 = +10%
+};
+
+// what deformationKernels::apply() does
+struct deformationSettings {
+	deformationSettings() : type(DEFORM_NONE), amplitude(25.f), frequency(0.02f), speed(1.f) {}
+	
+	deformationType type;
+	float amplitude; // pixels, radians for twists
+	float frequency; // spatial, radians per pixel
+	float speed; // cycles per second
+};
+
+// a deformation an effect applies to its vertex shapes, see basicEffect::addModifier()
+struct shapeModifier {
+	deformationSettings deformation;
+	float amount = 1.f;
+};
+
+class deformationKernels {
+public:
+	// animates _settings on the animation clock, _amount scales the amplitude (ie. a season)
+	static void apply( const vector<vertexSpan>& _spans, const deformationSettings& _settings, const animationParams& _params, float _amount = 1.f, unsigned int _firstSpan = 0 );
+	
+	// each span gets its own phase offset so shapes don't move in unison
+	// _firstSpan is the number of the first span, for batches split over several calls
+	
+	// x moves with sin(y), y with sin(x)
+	static void sineWave( const vector<vertexSpan>& _spans, float _amplitude, float _frequency, float _phase, unsigned int _firstSpan = 0 );
+	// smooth pseudo-noise: sums of sines at unrelated frequencies
+	static void noise( const vector<vertexSpan>& _spans, float _amplitude, float _frequency, float _time, unsigned int _firstSpan = 0 );
+	// moves vertices along their radius, waves going outwards
+	static void radialPulse( const vector<vertexSpan>& _spans, float _amplitude, float _frequency, float _phase, unsigned int _firstSpan = 0 );
+	// rotates vertices by _angle per 1/_frequency pixels from the origin
+	static void twist( const vector<vertexSpan>& _spans, float _angle, float _frequency );
+	// scales around the origin (BPM reactions)
+	static void scale( const vector<vertexSpan>& _spans, float _scale );
+	
+	static const char* getName( deformationType _type );
+};
@@ -0,0 +1,116 @@
+//
+//  polygonTriangulator.cpp
+//  karmaMapper
+//
+
+#include "polygonTriangulator.h"
+
+// - - - - - - - -
+// TRIANGULATION
+// - - - - - - - -
+bool polygonTriangulator::triangulate( const float* _x, const float* _y, unsigned int _size, vector<unsigned int>& _triangles ){
+	_triangles.clear();
+	ring.clear();
+	
+	// skip repeated points (zero length edges)
+	for(unsigned int i=0; i<_size; ++i){
+		if( !ring.empty() && _x[i]==_x[ring.back()] && _y[i]==_y[ring.back()] ) continue;
+		ring.push_back(i);
+	}
+	while( ring.size() > 1 && _x[ring.back()]==_x[ring.front()] && _y[ring.back()]==_y[ring.front()] ){
+		ring.pop_back();
+	}
+	if( ring.size() < 3 ) return false;
+	
+	// make it counter-clockwise
+	float area = 0;
+	for(unsigned int i=0, j=ring.size()-1; i<ring.size(); j=i++){
+		area += _x[ring[j]]*_y[ring[i]] - _x[ring[i]]*_y[ring[j]];
+	}
+	if( area < 0 ) reverse( ring.begin(), ring.end() );
+	
+	// link the ring
+	unsigned int remaining = ring.size();
+	prev.resize( remaining );
+	next.resize( remaining );
+	for(unsigned int i=0; i<remaining; ++i){
+		prev[i] = (i+remaining-1) % remaining;
+		next[i] = (i+1) % remaining;
+	}
+	_triangles.reserve( (remaining-2)*3 );
+	
+	bool bSimple = area != 0; // flat or crossing itself (bow tie)
+	unsigned int current = 0;
+	unsigned int stalled = 0;
+	while( remaining > 3 ){
+		unsigned int p = prev[current];
+		unsigned int n = next[current];
+		
+		bool bEar = isEar( _x, _y, p, current, n );
+		
+		// went around without finding an ear: the outline crosses itself, clip anyway
+		if( !bEar && ++stalled >= remaining ){
+			bEar = true;
+			bSimple = false;
+		}
+		
+		if( bEar ){
+			// collinear points don't make a triangle
+			if( cross(_x, _y, ring[p], ring[current], ring[n]) != 0 ){
+				_triangles.push_back( ring[p] );
+				_triangles.push_back( ring[current] );
+				_triangles.push_back( ring[n] );
+			}
+			clip( current );
+			remaining--;
+			stalled = 0;
+		}
+		current = n;
+	}
+	
+	// last one
+	unsigned int p = prev[current];
+	unsigned int n = next[current];
+	if( cross(_x, _y, ring[p], ring[current], ring[n]) != 0 ){
+		_triangles.push_back( ring[p] );
+		_triangles.push_back( ring[current] );
+		_triangles.push_back( ring[n] );
+	}
+	
+	return bSimple;
+}
+
+// - - - - - - - -
+// INTERNALS
+// - - - - - - - -
+// arguments are ring positions
+bool polygonTriangulator::isEar( const float* _x, const float* _y, unsigned int _prev, unsigned int _ear, unsigned int _next ) const {
+	unsigned int a = ring[_prev];
+	unsigned int b = ring[_ear];
+	unsigned int c = ring[_next];
+	
+	float turn = cross( _x, _y, a, b, c );
+	if( turn < 0 ) return false; // reflex
+	if( turn == 0 ) return true; // collinear, removing it doesn't change the outline
+	
+	// no other vertex may touch the triangle
+	for(unsigned int i=next[_next]; i!=_prev; i=next[i]){
+		unsigned int v = ring[i];
+		
+		// self-touching outline: same position as one of the corners
+		if( (_x[v]==_x[a] && _y[v]==_y[a]) || (_x[v]==_x[b] && _y[v]==_y[b]) || (_x[v]==_x[c] && _y[v]==_y[c]) ) continue;
+		
+		if( cross(_x, _y, a, b, v) >= 0 && cross(_x, _y, b, c, v) >= 0 && cross(_x, _y, c, a, v) >= 0 ) return false;
+	}
+	return true;
+}
+
+void polygonTriangulator::clip( unsigned int _ear ){
+	next[ prev[_ear] ] = next[_ear];
+	prev[ next[_ear] ] = prev[_ear];
+}
+
+// > 0 when a->b->c turns left
+float polygonTriangulator::cross( const float* _x, const float* _y, unsigned int _a, unsigned int _b, unsigned int _c ){
+	return (_x[_b]-_x[_a])*(_y[_c]-_y[_b]) - (_y[_b]-_y[_a])*(_x[_c]-_x[_b]);
+}
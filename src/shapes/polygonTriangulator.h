@@ -0,0 +1,29 @@
+//
+//  polygonTriangulator.h
+//  karmaMapper
+//
+//	Ear clipping triangulation for shape outlines, handles concave and self-touching polygons.
+//	Self-intersecting outlines still get triangles, but they won't match OF's winding rules.
+//	Keeps its work buffers between calls, use one per thread.
+//
+
+#pragma once
+
+#include "ofMain.h"
+
+class polygonTriangulator {
+public:
+	// fills _triangles with indexes into _x and _y, 3 per triangle. Returns false if the outline isn't simple.
+	bool triangulate( const float* _x, const float* _y, unsigned int _size, vector<unsigned int>& _triangles );
+
+private:
+	bool isEar( const float* _x, const float* _y, unsigned int _prev, unsigned int _ear, unsigned int _next ) const;
+	void clip( unsigned int _ear );
+	
+	static float cross( const float* _x, const float* _y, unsigned int _a, unsigned int _b, unsigned int _c );
+	
+	// remaining outline as a ring of vertex indexes
+	vector<unsigned int> ring;
+	vector<unsigned int> prev;
+	vector<unsigned int> next;
+};
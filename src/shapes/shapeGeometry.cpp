@@ -0,0 +1,256 @@
+//
+//  shapeGeometry.cpp
+//  karmaMapper
+//
+
+#include "shapeGeometry.h"
+#include "vertexKernels.h"
+
+// drop expired entries every so many new geometries
+#define KM_GEOMETRY_LIBRARY_GC_INTERVAL 1024
+
+// - - - - - - - -
+// SHAPE GEOMETRY
+// - - - - - - - -
+shapeGeometry::shapeGeometry( const vertexSpan& _outline ){
+	vertexPool& pool = vertexPool::getInstance();
+	storage = pool.allocate( _outline.size );
+	outline = pool.getSpan( storage, 0, _outline.size );
+	
+	if( outline.size > 0 ){
+		vertexKernels::translate( _outline.x, _outline.y, outline.x, outline.y, outline.size, -_outline.x[0], -_outline.y[0] );
+	}
+	
+	allIndices.resize( outline.size );
+	for(unsigned int i=0; i<outline.size; ++i) allIndices[i] = i;
+	
+	// level of detail chain, only keep levels which drop vertexes
+	if( outline.size < KM_SHAPE_LOD_MIN_VERTICES ) return;
+	
+	unsigned int numKept = outline.size;
+	float tolerance = KM_SHAPE_LOD_TOLERANCE;
+	for(unsigned int i=0; i<KM_SHAPE_LOD_MAX_LEVELS && numKept > 3; ++i, tolerance*=2.f){
+		lodLevel lod;
+		lod.error = tolerance;
+		simplify( tolerance, lod.indices );
+		if( lod.indices.size() < 3 ) break;
+		if( lod.indices.size() >= numKept ) continue;
+		
+		numKept = lod.indices.size();
+		lods.push_back( lod );
+	}
+}
+
+shapeGeometry::~shapeGeometry(){
+	vertexPool::getInstance().release( storage );
+}
+
+bool shapeGeometry::isCongruent( const vertexSpan& _outline, float _tolerance ) const {
+	if( _outline.size != outline.size ) return false;
+	if( outline.size == 0 ) return true;
+	
+	const float offsetX = _outline.x[0];
+	const float offsetY = _outline.y[0];
+	for(unsigned int i=0; i<outline.size; ++i){
+		if( fabsf( _outline.x[i]-offsetX-outline.x[i] ) > _tolerance ) return false;
+		if( fabsf( _outline.y[i]-offsetY-outline.y[i] ) > _tolerance ) return false;
+	}
+	return true;
+}
+
+sharedTriangles shapeGeometry::getTriangles(){
+	ofScopedLock lock(mutex);
+	
+	if( !triangles ){
+		vector<unsigned int>* newTriangles = new vector<unsigned int>();
+		polygonTriangulator triangulator;
+		triangulator.triangulate( outline.x, outline.y, outline.size, *newTriangles );
+		triangles.reset( newTriangles );
+	}
+	return triangles;
+}
+
+void shapeGeometry::setTriangles( const uint32_t* _indices, unsigned int _numIndices ){
+	ofScopedLock lock(mutex);
+	
+	if( triangles ) return;
+	for(unsigned int i=0; i<_numIndices; ++i){
+		if( _indices[i] >= outline.size ) return; // corrupt, triangulate later
+	}
+	triangles = make_shared< const vector<unsigned int> >( _indices, _indices+_numIndices );
+}
+
+unsigned int shapeGeometry::getLodLevel( float _maxError ) const {
+	unsigned int level = 0;
+	for(unsigned int i=0; i<lods.size() && lods[i].error <= _maxError; ++i){
+		level = i+1;
+	}
+	return level;
+}
+
+float shapeGeometry::getLodError( unsigned int _level ) const {
+	if( _level == 0 || _level > lods.size() ) return 0.f;
+	return lods[_level-1].error;
+}
+
+const vector<unsigned int>& shapeGeometry::getLodIndices( unsigned int _level ) const {
+	if( _level == 0 || _level > lods.size() ) return allIndices;
+	return lods[_level-1].indices;
+}
+
+sharedTriangles shapeGeometry::getLodTriangles( unsigned int _level ){
+	if( _level == 0 || _level > lods.size() ) return getTriangles();
+	
+	ofScopedLock lock(mutex);
+	
+	lodLevel& lod = lods[_level-1];
+	if( !lod.triangles ){
+		vector<float> x( lod.indices.size() ), y( lod.indices.size() );
+		for(unsigned int i=0; i<lod.indices.size(); ++i){
+			x[i] = outline.x[ lod.indices[i] ];
+			y[i] = outline.y[ lod.indices[i] ];
+		}
+		
+		vector<unsigned int>* newTriangles = new vector<unsigned int>();
+		polygonTriangulator triangulator;
+		triangulator.triangulate( x.data(), y.data(), x.size(), *newTriangles );
+		
+		// back to full outline indexes
+		for(auto it=newTriangles->begin(); it!=newTriangles->end(); ++it){
+			*it = lod.indices[*it];
+		}
+		lod.triangles.reset( newTriangles );
+	}
+	return lod.triangles;
+}
+
+// the closed outline is split at vertex 0 and the vertex farthest from it, then both chains get simplified
+void shapeGeometry::simplify( float _tolerance, vector<unsigned int>& _indices ) const {
+	_indices.clear();
+	const unsigned int n = outline.size;
+	if( n < 4 ){
+		for(unsigned int i=0; i<n; ++i) _indices.push_back(i);
+		return;
+	}
+	
+	unsigned int farthest = 0;
+	float farthestDist = -1.f;
+	for(unsigned int i=1; i<n; ++i){
+		float d = outline.x[i]*outline.x[i] + outline.y[i]*outline.y[i]; // vertex 0 is the origin
+		if( d > farthestDist ){
+			farthestDist = d;
+			farthest = i;
+		}
+	}
+	
+	vector<bool> keep( n, false );
+	keep[0] = keep[farthest] = true;
+	
+	// chains as [first, last] with last possibly n, which is vertex 0 again
+	vector< pair<unsigned int, unsigned int> > chains;
+	chains.push_back( make_pair( 0u, farthest ) );
+	chains.push_back( make_pair( farthest, n ) );
+	
+	const float toleranceSq = _tolerance*_tolerance;
+	while( !chains.empty() ){
+		unsigned int first = chains.back().first;
+		unsigned int last = chains.back().second;
+		chains.pop_back();
+		if( last-first < 2 ) continue;
+		
+		const float ax = outline.x[first], ay = outline.y[first];
+		const float dx = outline.x[last%n]-ax, dy = outline.y[last%n]-ay;
+		const float lengthSq = dx*dx + dy*dy;
+		
+		unsigned int worst = first;
+		float worstDistSq = toleranceSq;
+		for(unsigned int i=first+1; i<last; ++i){
+			float px = outline.x[i]-ax, py = outline.y[i]-ay;
+			// squared distance to the segment
+			float t = (lengthSq > 0.f) ? ofClamp( (px*dx + py*dy)/lengthSq, 0.f, 1.f ) : 0.f;
+			float ex = px - t*dx, ey = py - t*dy;
+			float distSq = ex*ex + ey*ey;
+			if( distSq > worstDistSq ){
+				worstDistSq = distSq;
+				worst = i;
+			}
+		}
+		
+		if( worst == first ) continue; // whole chain within tolerance
+		keep[worst] = true;
+		chains.push_back( make_pair( first, worst ) );
+		chains.push_back( make_pair( worst, last ) );
+	}
+	
+	for(unsigned int i=0; i<n; ++i){
+		if( keep[i] ) _indices.push_back(i);
+	}
+}
+
+// - - - - - - - -
+// LIBRARY
+// - - - - - - - -
+shapeGeometryLibrary::shapeGeometryLibrary() : numInsertions(0), lodMaxError(KM_SHAPE_LOD_DEFAULT_ERROR) {
+
+}
+
+shapeGeometryLibrary& shapeGeometryLibrary::getInstance(){
+	static shapeGeometryLibrary instance;
+	return instance;
+}
+
+shared_ptr<shapeGeometry> shapeGeometryLibrary::acquire( const vertexSpan& _outline ){
+	uint64_t key = hashOutline( _outline );
+	
+	ofScopedLock lock(mutex);
+	
+	auto range = geometries.equal_range( key );
+	for(auto it=range.first; it!=range.second; ++it){
+		shared_ptr<shapeGeometry> geometry = it->second.lock();
+		if( geometry && geometry->isCongruent( _outline, KM_CONGRUENT_SHAPE_TOLERANCE ) ) return geometry;
+	}
+	
+	shared_ptr<shapeGeometry> geometry = make_shared<shapeGeometry>( _outline );
+	geometries.insert( make_pair( key, weak_ptr<shapeGeometry>(geometry) ) );
+	
+	if( ++numInsertions >= KM_GEOMETRY_LIBRARY_GC_INTERVAL ) collectGarbage();
+	
+	return geometry;
+}
+
+unsigned int shapeGeometryLibrary::getNumGeometries() const {
+	ofScopedLock lock(mutex);
+	
+	unsigned int num = 0;
+	for(auto it=geometries.cbegin(); it!=geometries.cend(); ++it){
+		if( !it->second.expired() ) num++;
+	}
+	return num;
+}
+
+void shapeGeometryLibrary::setLodMaxError( float _error ){
+	lodMaxError = MAX( 0.f, _error );
+}
+
+uint64_t shapeGeometryLibrary::hashOutline( const vertexSpan& _outline ){
+	uint64_t key = 14695981039346656037ULL ^ _outline.size;
+	if( _outline.size == 0 ) return key;
+	
+	const float cell = 1.f / (KM_CONGRUENT_SHAPE_TOLERANCE*2.f);
+	for(unsigned int i=0; i<_outline.size; ++i){
+		int64_t x = (int64_t) floorf( (_outline.x[i]-_outline.x[0]) * cell );
+		int64_t y = (int64_t) floorf( (_outline.y[i]-_outline.y[0]) * cell );
+		key = (key ^ (uint64_t) x) * 1099511628211ULL;
+		key = (key ^ (uint64_t) y) * 1099511628211ULL;
+	}
+	return key;
+}
+
+// mutex is locked
+void shapeGeometryLibrary::collectGarbage(){
+	for(auto it=geometries.begin(); it!=geometries.end(); ){
+		if( it->second.expired() ) it = geometries.erase(it);
+		else ++it;
+	}
+	numInsertions = 0;
+}
@@ -0,0 +1,96 @@
+//
+//  shapeGeometry.h
+//  karmaMapper
+//
+//	Outline and triangulation shared by congruent vertexShapes: same outline up to a translation, within KM_CONGRUENT_SHAPE_TOLERANCE.
+//	Facades have lots of identical windows, they end up holding one outline and one set of triangles, each with its own offset.
+//	Shared data is never altered. Deformed shapes triangulate their own copy (see vertexShape::getSharedTriangles()).
+//	Dense outlines (traced from photos...) also get a level of detail chain, simplified with Douglas-Peucker when the geometry is created.
+//	Levels keep a subset of the vertexes, their triangles index the full outline so they draw from the same vertex data.
+//
+
+#pragma once
+
+#include "ofMain.h"
+#include "KMSettings.h"
+#include "vertexPool.h"
+#include "polygonTriangulator.h"
+
+typedef shared_ptr< const vector<unsigned int> > sharedTriangles;
+
+class shapeGeometry {
+public:
+	// stores _outline relative to its first vertex
+	shapeGeometry( const vertexSpan& _outline );
+	~shapeGeometry();
+	
+	// relative to the first vertex of the shapes using it
+	const vertexSpan& getOutline() const { return outline; }
+	unsigned int getNumVertices() const { return outline.size; }
+	bool isCongruent( const vertexSpan& _outline, float _tolerance ) const;
+	
+	// triangulated on first use. Thread safe.
+	sharedTriangles getTriangles();
+	// precomputed ones (binary scenes), ignored once triangulated
+	void setTriangles( const uint32_t* _indices, unsigned int _numIndices );
+	
+	// level of detail, 0 is the full outline
+	unsigned int getNumLodLevels() const { return lods.size()+1; }
+	// coarsest level that stays within _maxError px of the full outline
+	unsigned int getLodLevel( float _maxError ) const;
+	float getLodError( unsigned int _level ) const;
+	// kept vertex indexes, in outline order
+	const vector<unsigned int>& getLodIndices( unsigned int _level ) const;
+	// triangulated on first use. Thread safe.
+	sharedTriangles getLodTriangles( unsigned int _level );
+
+private:
+	shapeGeometry(const shapeGeometry&) = delete;
+	shapeGeometry& operator=(const shapeGeometry&) = delete;
+	
+	// Douglas-Peucker on the closed outline, fills _indices with the kept vertexes
+	void simplify( float _tolerance, vector<unsigned int>& _indices ) const;
+	
+	vertexBlock storage;
+	vertexSpan outline;
+	sharedTriangles triangles;
+	
+	struct lodLevel {
+		float error = 0; // px
+		vector<unsigned int> indices;
+		sharedTriangles triangles;
+	};
+	vector<lodLevel> lods; // from level 1 on
+	vector<unsigned int> allIndices; // level 0
+	
+	ofMutex mutex;
+};
+
+// finds the geometry of new outlines. Thread safe.
+class shapeGeometryLibrary {
+public:
+	static shapeGeometryLibrary& getInstance();
+	
+	// a congruent geometry if there is one, a new one otherwise
+	shared_ptr<shapeGeometry> acquire( const vertexSpan& _outline );
+	
+	unsigned int getNumGeometries() const; // in use
+	
+	// global simplification error (px) shapes may be drawn with, effects can raise it (see basicEffect::getLodError())
+	float getLodMaxError() const { return lodMaxError; }
+	void setLodMaxError( float _error );
+
+private:
+	shapeGeometryLibrary();
+	shapeGeometryLibrary(const shapeGeometryLibrary&) = delete;
+	shapeGeometryLibrary& operator=(const shapeGeometryLibrary&) = delete;
+	
+	// outlines quantized to the tolerance. Outlines across a cell border don't find each other, they just don't share.
+	static uint64_t hashOutline( const vertexSpan& _outline );
+	void collectGarbage();
+	
+	unordered_multimap< uint64_t, weak_ptr<shapeGeometry> > geometries;
+	unsigned int numInsertions; // since the last garbage collection
+	float lodMaxError;
+	mutable ofMutex mutex;
+};
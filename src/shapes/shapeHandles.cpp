@@ -0,0 +1,145 @@
+//
+//  shapeHandles.cpp
+//  karmaMapper
+//
+
+#include "shapeHandles.h"
+
+// - - - - - - - -
+// CONSTRUCTORS
+// - - - - - - - -
+shapeHandles::shapeHandles(){
+	slots.resize(1);
+}
+
+shapeHandles& shapeHandles::getInstance(){
+	static shapeHandles instance;
+	return instance;
+}
+
+// - - - - - - - -
+// REGISTRATION
+// - - - - - - - -
+void shapeHandles::registerShape( basicShape* _shape ){
+	if( _shape == nullptr ) return;
+	
+	ofScopedLock lock(mutex);
+	if( slotOfShape.find(_shape) != slotOfShape.end() ) return;
+	
+	uint32_t index;
+	if( freeSlots.empty() ){
+		index = slots.size();
+		slots.push_back( slot() );
+	}
+	else {
+		index = freeSlots.back();
+		freeSlots.pop_back();
+	}
+	
+	slot& s = slots[index];
+	s.shape = _shape;
+	s.vertices = _shape->isType("vertexShape") ? (vertexShape*)_shape : nullptr;
+	slotOfShape[_shape] = index;
+}
+
+void shapeHandles::unregisterShape( basicShape* _shape ){
+	ofScopedLock lock(mutex);
+	auto found = slotOfShape.find( _shape );
+	if( found == slotOfShape.end() ) return;
+	
+	slot& s = slots[found->second];
+	s.shape = nullptr;
+	s.vertices = nullptr;
+	s.generation++;
+	if( s.generation == 0 ) s.generation = 1; // wrapped
+	
+	freeSlots.push_back( found->second );
+	slotOfShape.erase( found );
+}
+
+// - - - - - - - -
+// HANDLES
+// - - - - - - - -
+vertexHandle shapeHandles::getHandle( basicShape* _shape, unsigned int _vertex ) const {
+	vertexHandle handle;
+	
+	ofScopedLock lock(mutex);
+	auto found = slotOfShape.find( _shape );
+	if( found == slotOfShape.end() ) return handle;
+	
+	const slot& s = slots[found->second];
+	if( s.vertices != nullptr ){
+		if( _vertex >= s.vertices->getRenderVertices().size ) return handle;
+		handle.layout = (uint16_t)s.vertices->getLayoutRevision();
+	}
+	handle.slot = found->second;
+	handle.vertex = _vertex;
+	handle.generation = s.generation;
+	return handle;
+}
+
+bool shapeHandles::isValid( const vertexHandle& _handle ) const {
+	ofScopedLock lock(mutex);
+	return getSlot(_handle) != nullptr;
+}
+
+basicShape* shapeHandles::getShape( const vertexHandle& _handle ) const {
+	ofScopedLock lock(mutex);
+	const slot* s = getSlot(_handle);
+	return (s==nullptr) ? nullptr : s->shape;
+}
+
+bool shapeHandles::resolve( const vertexHandle& _handle, basicPoint& _position ) const {
+	ofScopedLock lock(mutex);
+	const slot* s = getSlot(_handle);
+	if( s==nullptr || !resolveSlot(*s, _handle, _position) ){
+		_position = basicPoint::nullPoint;
+		return false;
+	}
+	return true;
+}
+
+unsigned int shapeHandles::resolve( const vertexHandle* _handles, unsigned int _count, basicPoint* _positions, unsigned char* _valid ) const {
+	unsigned int numValid = 0;
+	
+	ofScopedLock lock(mutex);
+	for(unsigned int i=0; i<_count; ++i){
+		const slot* s = getSlot(_handles[i]);
+		bool bValid = s!=nullptr && resolveSlot(*s, _handles[i], _positions[i]);
+		if( bValid ) numValid++;
+		else _positions[i] = basicPoint::nullPoint;
+		if( _valid != nullptr ) _valid[i] = bValid ? 1 : 0;
+	}
+	return numValid;
+}
+
+unsigned int shapeHandles::getNumShapes() const {
+	ofScopedLock lock(mutex);
+	return slotOfShape.size();
+}
+
+// - - - - - - - -
+// INTERNALS
+// - - - - - - - -
+// mutex must be locked
+const shapeHandles::slot* shapeHandles::getSlot( const vertexHandle& _handle ) const {
+	if( _handle.slot == 0 || _handle.slot >= slots.size() ) return nullptr;
+	
+	const slot& s = slots[_handle.slot];
+	if( s.shape == nullptr || s.generation != _handle.generation ) return nullptr;
+	if( s.vertices != nullptr && (uint16_t)s.vertices->getLayoutRevision() != _handle.layout ) return nullptr;
+	return &s;
+}
+
+bool shapeHandles::resolveSlot( const slot& _slot, const vertexHandle& _handle, basicPoint& _position ) const {
+	if( _slot.vertices == nullptr ){
+		_position = _slot.shape->getRenderPosition();
+		return true;
+	}
+	
+	const vertexSpan& render = _slot.vertices->getRenderVertices();
+	if( _handle.vertex >= render.size ) return false;
+	
+	_position = render[_handle.vertex] + _slot.shape->getRenderPosition();
+	return true;
+}
@@ -0,0 +1,65 @@
+//
+//  shapeHandles.h
+//  karmaMapper
+//
+//	Compact references to shape vertices that can't dangle: (slot, vertex, generation).
+//	shapesDB registers its shapes here. A removed shape bumps its slot generation and an edited outline its layout revision,
+//	so old handles simply stop resolving instead of pointing into freed memory. Thread safe.
+//
+
+#pragma once
+
+#include "ofMain.h"
+#include "basicShape.h"
+#include "vertexShape.h"
+
+// 12 bytes, copy it around freely
+struct vertexHandle {
+	uint32_t slot = 0; // 0 = null handle
+	uint32_t vertex = 0;
+	uint16_t generation = 0;
+	uint16_t layout = 0; // vertexShape layout revision
+	
+	bool isNull() const { return slot == 0; }
+};
+
+class shapeHandles {
+public:
+	static shapeHandles& getInstance();
+	
+	void registerShape( basicShape* _shape );
+	void unregisterShape( basicShape* _shape ); // before deleting it
+	
+	// null handle if the shape isn't registered or the vertex doesn't exist
+	// handles to other shapes than vertexShapes resolve to their position
+	vertexHandle getHandle( basicShape* _shape, unsigned int _vertex = 0 ) const;
+	bool isValid( const vertexHandle& _handle ) const;
+	basicShape* getShape( const vertexHandle& _handle ) const; // nullptr if invalid
+	
+	// committed (rendered) absolute position. False once the shape got removed or edited.
+	bool resolve( const vertexHandle& _handle, basicPoint& _position ) const;
+	// one lock for all. Invalid handles give basicPoint::nullPoint and _valid[i]=0. Returns the number of valid ones.
+	unsigned int resolve( const vertexHandle* _handles, unsigned int _count, basicPoint* _positions, unsigned char* _valid = nullptr ) const;
+	
+	unsigned int getNumShapes() const;
+
+private:
+	shapeHandles();
+	shapeHandles(const shapeHandles&) = delete;
+	shapeHandles& operator=(const shapeHandles&) = delete;
+	
+	struct slot {
+		basicShape* shape = nullptr;
+		vertexShape* vertices = nullptr; // same shape when it's a vertexShape
+		uint16_t generation = 1;
+	};
+	
+	// mutex must be locked
+	const slot* getSlot( const vertexHandle& _handle ) const;
+	bool resolveSlot( const slot& _slot, const vertexHandle& _handle, basicPoint& _position ) const;
+	
+	vector<slot> slots; // slot 0 stays empty
+	vector<uint32_t> freeSlots;
+	unordered_map<basicShape*, uint32_t> slotOfShape;
+	mutable ofMutex mutex;
+};
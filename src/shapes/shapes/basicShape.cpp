@@ -7,6 +7,7 @@
 //
 
 #include "basicShape.h"
+#include "shapesBinaryScene.h"
 
 // static
 //basicShape basicShape::nullShape;// = basicShape();
@@ -92,7 +93,11 @@ void basicShape::sendToGPU(){
 	// prepare for drawing
 	ofPushMatrix();
 	ofPushStyle();
+#ifdef KM_EDITOR_APP
 	ofTranslate(position.x, position.y);
+#else
+	ofTranslate(renderPosition.x, renderPosition.y);
+#endif
 	
 	// if shape has error, draw it in red
 #ifdef KM_EDITOR_APP
@@ -128,6 +133,9 @@ void basicShape::calculateBoundingBox(){
 void basicShape::onShapeModified(){
 	// todo: position stuff
 	
+	bModified = true;
+	bRenderStateDirty = true;
+	
 	// update boundingbox
 	calculateBoundingBox();
 	
@@ -149,9 +157,21 @@ void basicShape::onShapeEdited(){
 #endif
 }
 
+// called by the animator once the shape data is final for this frame
+void basicShape::commitRenderState(){
+	renderPosition.x = position.x;
+	renderPosition.y = position.y;
+	renderBoundingBox = boundingBox;
+	
+	if( bRenderStateDirty ) renderRevision++;
+	bRenderStateDirty = false;
+}
+
 // called by animator to reset possibly altered properties to the shape's initial (scene) properties
 void basicShape::resetToScene(){
 	// todo
+	
+	bModified = false;
 }
 
 // writes the shape data to XML. xml's cursor is already pushed into the right <shape> tag.
@@ -195,6 +215,83 @@ bool basicShape::loadFromXML(ofxXmlSettings& xml){
 	return true;
 }
 
+// same as above, from a memory mapped scene (see shapesBinaryScene.h)
+bool basicShape::loadFromBinary( const shapesBinaryScene& _scene, unsigned int _index ){
+	const shapesBinaryScene::shapeRecord& record = _scene.getShape(_index);
+	
+#ifdef KM_EDITOR_APP
+	position.setPos( record.x, record.y );
+#else
+	position.x = record.x;
+	position.y = record.y;
+#endif
+	
+	groupID = record.groupID;
+	string name = _scene.getString( record.name );
+	shapeName = name.empty() ? ofToString(reinterpret_cast<uintptr_t>(this)) : name;
+	
+#ifdef KM_EDITOR_APP
+	setColorFromGroupID();
+#endif
+	
+	return true;
+}
+
+// same as saveToXML(), streamed
+bool basicShape::saveToXMLStream( karmaXmlWriter& _xml ){
+	
+	_xml.beginElement("position");
+	_xml.addValue("X", getPositionUnaltered()->x);
+	_xml.addValue("Y", getPositionUnaltered()->y);
+	_xml.endElement();
+	
+	_xml.addValue("shapeType", getShapeType() );
+	_xml.addValue("groupID", getGroupID() );
+	_xml.addValue("shapeName", getName() );
+	
+	return true;
+}
+
+// same as loadFromXML(), streamed
+bool basicShape::onXmlElementStart( const karmaXmlElement& _element ){
+	// <shape>, set the defaults
+	if( _element.getDepth() == 0 ){
+#ifdef KM_EDITOR_APP
+		position.setPos( 0, 0 );
+#else
+		position.x = 0;
+		position.y = 0;
+#endif
+		groupID = -1;
+		string name = ofToString(reinterpret_cast<uintptr_t>(this));
+		shapeName = name;
+	}
+	return true;
+}
+
+void basicShape::onXmlValue( const karmaXmlElement& _element ){
+	if( _element.getDepth() == 2 && _element.isChildOf("position") ){
+#ifdef KM_EDITOR_APP
+		if( _element.is("X") ) position.setPos( _element.getValue(0.f), position.y );
+		else if( _element.is("Y") ) position.setPos( position.x, _element.getValue(0.f) );
+#else
+		if( _element.is("X") ) position.x = _element.getValue(0.f);
+		else if( _element.is("Y") ) position.y = _element.getValue(0.f);
+#endif
+	}
+	else if( _element.getDepth() == 1 ){
+		if( _element.is("groupID") ) groupID = _element.getValue(-1);
+		else if( _element.is("shapeName") && !_element.getText().empty() ) shapeName = _element.getText();
+	}
+}
+
+bool basicShape::onXmlElementEnd( const karmaXmlElement& _element ){
+#ifdef KM_EDITOR_APP
+	if( _element.getDepth() == 0 ) setColorFromGroupID();
+#endif
+	return true;
+}
+
 // - - - - - - -
 // SHAPE PROPERTIES
 // - - - - - - -
@@ -243,7 +340,7 @@ bool basicShape::isType(const string _type) const {
 
 bool basicShape::isInside( const ofVec2f _pos, const bool _isPositionAbsolute) const{
 	if( _isPositionAbsolute ) return boundingBox.inside(_pos);
-	else return boundingBox.inside( -position.x + _pos.x, -position.y + _pos.y );
+	else return boundingBox.inside( position.x + _pos.x, position.y + _pos.y );
 }
 
 /*ofVec2f basicShape::getPosition() const{
@@ -15,6 +15,7 @@
 #include "KMSettings.h"
 #include "basicPoint.h"
 #include "ofxXmlSettings.h"
+#include "karmaXml.h"
 #include "ofxGui.h"
 #include "ofxGuiExtended.h"
 
@@ -26,9 +27,11 @@
 // Shape querying and altering happens trough absolute coordinates.
 // todo: use a struct instead of ofVec2f
 
+class shapesBinaryScene;
+
 typedef list<basicPoint>& pointListRef; // without the typedef returning this causes compiler errors.
 
-class basicShape {
+class basicShape : public karmaXmlVisitor {
 	
 public:
 	basicShape(const basicPoint _pos);
@@ -44,6 +47,12 @@ public:
 	// LOAD & SAVE FUNCTIONS
 	virtual bool saveToXML(ofxXmlSettings& xml );
 	virtual bool loadFromXML(ofxXmlSettings& xml);
+	virtual bool loadFromBinary( const shapesBinaryScene& _scene, unsigned int _index );
+	// streamed, see karmaXml.h. The writer is inside the <shape> tag, the visitor gets the <shape> element (depth 0) and its children.
+	virtual bool saveToXMLStream( karmaXmlWriter& _xml );
+	virtual bool onXmlElementStart( const karmaXmlElement& _element );
+	virtual void onXmlValue( const karmaXmlElement& _element );
+	virtual bool onXmlElementEnd( const karmaXmlElement& _element );
 	
 	// #########
 	// UTILITIES
@@ -51,6 +60,12 @@ public:
 	virtual void onShapeModified();
 	virtual void onShapeEdited();
 	virtual void resetToScene();
+	bool isModified() const { return bModified; }
+	// copies the altered shape data to what sendToGPU() draws (animator only)
+	virtual void commitRenderState();
+	unsigned int getRenderRevision() const { return renderRevision; } // increases when the committed render state changes
+	const basicPoint& getRenderPosition() const { return renderPosition; }
+	const ofRectangle& getRenderBoundingBox() const { return renderBoundingBox; }
 	
 	// #########
 	// BASIC SHAPE GETTERS
@@ -65,6 +80,9 @@ public:
 	vector<string> getTypes() const;
 	bool isType(const string _type) const;
 	virtual bool isInside( const ofVec2f _pos, const bool _isPositionAbsolute = true) const;
+	// of the scene outline, points have none
+	virtual float getArea() const { return 0.f; }
+	virtual float getPerimeter() const { return 0.f; }
 	basicPoint* getPositionPtr();
 	basicPoint* getPositionUnaltered();
 
@@ -77,6 +95,9 @@ protected:
 	// basicShape properties
 	bool initialized = false;
 	bool hasError = false;
+	bool bModified = true; // altered since last resetToScene() ?
+	bool bRenderStateDirty = true; // altered since last commitRenderState() ?
+	unsigned int renderRevision = 0;
 	ofRectangle boundingBox; // contains all shapes
 #ifdef KM_EDITOR_APP
 	ofParameter<int> groupID; // [-1=none, other = groupID]
@@ -88,6 +109,8 @@ protected:
 	vector<string> myShapeTypes;
 	
 	basicPoint position; // absolute (other shape data will be relative to this)
+	basicPoint renderPosition; // copy used for drawing, so effects can update the next frame meanwhile
+	ofRectangle renderBoundingBox; // idem
 	
 	
 private:
@@ -38,12 +38,7 @@ void fullScreenShape::initialiseFullScreenVariables(){
 	
 	// init variables
 	points.clear();
-	absolutePoints.clear();
-	changingPoints.clear();
-	
 	points.resize(FULLSCREEN_SHAPE_NUM_POINTS);
-	absolutePoints.resize(FULLSCREEN_SHAPE_NUM_POINTS);
-	changingPoints.resize(FULLSCREEN_SHAPE_NUM_POINTS);
 	
 	setPointsToScreenRes();
 }
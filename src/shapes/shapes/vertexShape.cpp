@@ -11,6 +11,8 @@
 //
 
 #include "vertexShape.h"
+#include "shapesBinaryScene.h"
+#include "karmaRenderRecorder.h"
 
 #define VECT_SHAPE_DEFAULT_NUM_POINTS 4
 
@@ -19,7 +21,7 @@ list<basicPoint> vertexShape::zeroList = list<basicPoint>();
 // - - - - - - -
 // CONSTRUCTORS
 // - - - - - - -
-vertexShape::vertexShape(const basicPoint _pos) : basicShape(_pos){
+vertexShape::vertexShape(const basicPoint _pos) : basicShape(_pos), numVertices(0), layoutRevision(0), bTrianglesDirty(true), bRenderUnaltered(false), trianglesRevision(0), triangles(make_shared< const vector<unsigned int> >()), ownTrianglesKey(0) {
 	initialiseVertexVariables();
 	
 #ifdef KM_EDITOR_APP
@@ -32,6 +34,7 @@ vertexShape::vertexShape(const basicPoint _pos) : basicShape(_pos){
 vertexShape::~vertexShape(){
 	//basicShape::~basicShape();
 	
+	vertexPool::getInstance().release( vertexStorage );
 }
 
 // - - - - - - -
@@ -50,7 +53,6 @@ void vertexShape::initialiseVertexVariables(){
 	
 	// init variables
 	points.resize( VECT_SHAPE_DEFAULT_NUM_POINTS );
-	absolutePoints.clear();
 	
 	// spread 4 points trough space
 	int i=0;
@@ -59,6 +61,7 @@ void vertexShape::initialiseVertexVariables(){
 	}
 	
 	// recalculate bounding box & stuff
+	syncVertices();
 	onShapeModified();
 	
 #ifdef KM_EDITOR_APP
@@ -75,7 +78,14 @@ void vertexShape::sendToGPU(){
 	ofPushMatrix();
 	//ofPushStyle();
 	// todo: this should be changingPosition
+#ifdef KM_EDITOR_APP
 	ofTranslate( getPositionPtr()->x, getPositionPtr()->y);
+	const vertexSpan& drawPoints = changingVertices;
+#else
+	ofTranslate( renderPosition.x, renderPosition.y);
+	const vertexSpan& drawPoints = renderVertices;
+#endif
+	unsigned int lodLevel = getLodLevel( shapeGeometryLibrary::getInstance().getLodMaxError() );
 	
 	// if shape has error, draw it in red
 #ifdef KM_EDITOR_APP
@@ -89,15 +99,33 @@ void vertexShape::sendToGPU(){
 		ofFill();
 	}
 	
-	//ofSetPolyMode(OF_POLY_WINDING_NONZERO);
-	//shared_ptr<ofBaseRenderer> tmp = ofGetCurrentRenderer();
-	ofBeginShape();
-	// draw elements
-	for(auto it = changingPoints.begin(); it != changingPoints.end(); it++){
-		// draw center point
-		ofVertex( (*it).x, (*it).y );
+	// filled: draw the cached triangles, re-using the mesh buffers
+	const vector<unsigned int>& lodIndices = getLodIndices( lodLevel );
+	if( ofGetStyle().bFill ){
+		sharedTriangles tris = getLodTriangles( lodLevel );
+		vector<ofVec3f>& meshVertices = triangleMesh.getVertices();
+		meshVertices.resize( drawPoints.size );
+		for(auto it=lodIndices.cbegin(); it!=lodIndices.cend(); ++it){
+			meshVertices[*it].set( drawPoints.x[*it], drawPoints.y[*it] );
+		}
+		if( tris != meshTriangles ){
+			triangleMesh.getIndices().assign( tris->begin(), tris->end() );
+			meshTriangles = tris;
+		}
+		triangleMesh.draw();
 	}
-	ofEndShape(OF_CLOSE);
+	else {
+		ofBeginShape();
+		// draw elements
+		for(auto it=lodIndices.cbegin(); it!=lodIndices.cend(); ++it){
+			// draw center point
+			ofVertex( drawPoints.x[*it], drawPoints.y[*it] );
+		}
+		ofEndShape(OF_CLOSE);
+	}
+	
+	KM_RECORD_RENDER_CALL(shapeDraws, 1);
+	KM_RECORD_RENDER_CALL(vertices, lodIndices.size());
 	
 	// reset
 	//ofPopStyle();
@@ -111,19 +139,32 @@ vertexShape* vertexShape::getUpcasted(){
 
 // simply (re)computes shape data so that it fits in the boundingbox
 void vertexShape::calculateBoundingBox(){
-	// reset
-	int minX=0, minY=0, maxX=0, maxY=0;
-	for(auto it = changingPoints.begin(); it != changingPoints.end(); it++){
-		if((*it).x > maxX) maxX = (*it).x;
-		if((*it).x < minX) minX = (*it).x;
-		
-		if((*it).y > maxY) maxY = (*it).y;
-		if((*it).y < minY) minY = (*it).y;
+	ofRectangle bounds;
+	if( !vertexKernels::getBounds( changingVertices.x, changingVertices.y, changingVertices.size, bounds ) ){
+		basicShape::calculateBoundingBox();
+		return;
 	}
 	
-	boundingBox.setPosition( position.x + minX, position.y + minY );
-	boundingBox.setWidth( abs(maxX-minX) );
-	boundingBox.setHeight( abs(maxY-minY) );
+	boundingBox.set( position.x + bounds.x, position.y + bounds.y, bounds.width, bounds.height );
+}
+
+// even-odd rule, like the filled drawing
+bool vertexShape::isInside( const ofVec2f _pos, const bool _isPositionAbsolute ) const {
+	if( !basicShape::isInside( _pos, _isPositionAbsolute ) ) return false;
+	
+	// relative to the shape
+	float px = _isPositionAbsolute ? _pos.x - position.x : _pos.x;
+	float py = _isPositionAbsolute ? _pos.y - position.y : _pos.y;
+	
+	bool bInside = false;
+	const float* x = changingVertices.x;
+	const float* y = changingVertices.y;
+	for(unsigned int i=0, j=changingVertices.size-1; i<changingVertices.size; j=i++){
+		if( (y[i] > py) != (y[j] > py) && px < (x[j]-x[i]) * (py-y[i]) / (y[j]-y[i]) + x[i] ){
+			bInside = !bInside;
+		}
+	}
+	return bInside;
 }
 
 // updates other shape date after it's been (temporarily) altered (by effect for example)
@@ -133,13 +174,13 @@ void vertexShape::onShapeModified(){
 	basicShape::onShapeModified();
 	
 	// update relative points to absolute points
-	absolutePoints = changingPoints;
-	for(auto it = absolutePoints.begin(); it!=absolutePoints.end(); it++ ){
-		*it = *it + position;
-	}
+	// (the bounding box got updated above)
+	vertexKernels::translate( changingVertices.x, changingVertices.y, absoluteVertices.x, absoluteVertices.y, numVertices, position.x, position.y );
 	
-	// todo: update centerPos & more
-	calculateBoundingBox();
+#ifdef KM_EDITOR_APP
+	// the editor draws the changing vertices
+	bTrianglesDirty = true;
+#endif
 }
 
 // called when the shape has been edited so it can update some ot if't other variables
@@ -148,7 +189,7 @@ void vertexShape::onShapeEdited(){
 	// let parent function do it's thing
 	basicShape::onShapeEdited();
 
-	changingPoints = points;
+	syncVertices();
 	
 	vertexShape::onShapeModified();
 	
@@ -168,10 +209,25 @@ void vertexShape::onShapeEdited(){
 
 
 void vertexShape::resetToScene() {
-	basicShape::resetToScene();
+	// untouched since last reset, nothing to restore
+	if( !isModified() ) return;
 	
 	// syncs original shape data with modifyable data
-	onShapeEdited();
+	vertexKernels::translate( geometry->getOutline().x, geometry->getOutline().y, changingVertices.x, changingVertices.y, numVertices, geometryOffset.x, geometryOffset.y );
+	vertexShape::onShapeModified();
+	
+	basicShape::resetToScene();
+}
+
+void vertexShape::commitRenderState(){
+	// nothing changed since last commit
+	if( !bRenderStateDirty ) return;
+	
+	renderVertices.copyFrom( changingVertices );
+	bRenderUnaltered = !isModified();
+	bTrianglesDirty = true;
+	
+	basicShape::commitRenderState();
 }
 
 // ### LOAD & SAVE
@@ -230,107 +286,247 @@ bool vertexShape::loadFromXML(ofxXmlSettings& xml){
 	return true;
 }
 
+bool vertexShape::saveToXMLStream( karmaXmlWriter& _xml ){
+	if( !basicShape::saveToXMLStream(_xml) ) return false;
+	
+	_xml.beginElement("vectors");
+	for(auto it = points.begin(); it != points.end(); it++){
+		_xml.beginElement("vector");
+		_xml.addValue("X", (*it).x);
+		_xml.addValue("Y", (*it).y);
+		_xml.endElement();
+	}
+	_xml.endElement();
+	
+	return true;
+}
+
+// <shape>
+//   <vectors>
+//     <vector><X/><Y/></vector>
+bool vertexShape::onXmlElementStart( const karmaXmlElement& _element ){
+	if( _element.getDepth() == 1 && _element.is("vectors") ) points.clear();
+	else if( _element.getDepth() == 2 && _element.is("vector") && _element.isChildOf("vectors") ) points.push_back( basicPoint(0,0) );
+	
+	return basicShape::onXmlElementStart(_element);
+}
+
+void vertexShape::onXmlValue( const karmaXmlElement& _element ){
+	if( _element.getDepth() == 3 && _element.isChildOf("vector") && !points.empty() ){
+		if( _element.is("X") ) points.back().x = _element.getValue(0.f);
+		else if( _element.is("Y") ) points.back().y = _element.getValue(0.f);
+		return;
+	}
+	
+	basicShape::onXmlValue(_element);
+}
+
+bool vertexShape::onXmlElementEnd( const karmaXmlElement& _element ){
+	if( _element.getDepth() == 1 && _element.is("vectors") ) onShapeEdited();
+	
+	return basicShape::onXmlElementEnd(_element);
+}
+
+bool vertexShape::loadFromBinary( const shapesBinaryScene& _scene, unsigned int _index ){
+	if( !basicShape::loadFromBinary(_scene, _index) ) return false;
+	
+	const shapesBinaryScene::shapeRecord& record = _scene.getShape(_index);
+	points.resize( record.numVertices );
+	unsigned int i=0;
+	for(auto it=points.begin(); it!=points.end(); ++it, ++i){
+		*it = _scene.getVertex( record, i );
+	}
+	onShapeEdited();
+	
+	// use the stored triangulation for the shared geometry, unless a congruent shape already triangulated it
+	if( record.numTriangleIndices > 0 ){
+		geometry->setTriangles( _scene.getTriangles( record ), record.numTriangleIndices );
+	}
+	
+	return true;
+}
+
 // - - - - - - -
 // VERTEX SHAPE FUNCTIONS
 // - - - - - - -
 
 // ### GETTERS
-list<basicPoint>& vertexShape::getPoints( const basicShapePointType& _type ){
+list<basicPoint>& vertexShape::getPoints(){
+	return points;
+}
+
+// note: alterable spans are handed out, so the shape is flagged as modified
+vertexSpan vertexShape::getVertices( const basicShapePointType& _type ){
 	switch( _type ){
 		case POINT_POSITION_ABSOLUTE:
-			return absolutePoints;
+			bModified = bRenderStateDirty = true;
+			return absoluteVertices;
 			break;
 		case POINT_POSITION_RELATIVE:
-			return changingPoints;
+			bModified = bRenderStateDirty = true;
+			return changingVertices;
 			break;
 		
+		// the scene outline is shared, it can't be handed out
 		case POINT_POSITION_RELATIVE_UNALTERED:
 		default:
-			return points;
+			ofLogError("vertexShape::getVertices") << "Unaltered vertices are read only, use getUnalteredVertices().";
+			return vertexSpan();
 			break;
 	}
 }
 
+// the shared outline is relative to the first vertex, re-base it on the position
+void vertexShape::getUnalteredVertices( vector<basicPoint>& _vertices ) const {
+	const vertexSpan& outline = geometry->getOutline();
+	_vertices.resize( outline.size );
+	for(unsigned int i=0; i<outline.size; ++i){
+		_vertices[i] = basicPoint( outline.x[i] + geometryOffset.x, outline.y[i] + geometryOffset.y );
+	}
+}
+
 int vertexShape::getNumPoints(){
 	return points.size();
 }
 
 // ### UTILITIES
 
-/* / gets alterable vertex reference holding relative point coordinates
- ofVec2f& vertexShape::getRandomVertex(){
-	// todo: what if no vertexes ?
-	//if( points.size()==0 ) return NULL;
-	
-	list<ofVec2f>::iterator it = points.begin();
-	std::advance(it, round(ofRandom(points.size()-1)) );
-	return (*it);
- }*/
+unsigned int vertexShape::getRandomVertexIndex( karmaRandom& _random ) const {
+	return _random.getIndex( numVertices );
+}
 
-// gets alterable vertex pointer holding relative point coordinates
-basicPoint* vertexShape::getRandomVertexPtr( const basicShapePointType& _type ){
-	if( points.size()==0 ) return &basicPoint::nullPoint;
+// shoelace formula
+float vertexShape::getArea() const {
+	if( numVertices < 3 ) return 0.f;
 	
-	if( _type == POINT_POSITION_RELATIVE ){
-		auto it = changingPoints.begin();
-		std::advance(it, round(ofRandom(changingPoints.size()-1)) );
-		return &*it;
+	// translation doesn't matter, the shared outline will do
+	const vertexSpan& outline = geometry->getOutline();
+	double area = 0.;
+	for(unsigned int i=0, j=numVertices-1; i<numVertices; j=i++){
+		area += (double)outline.x[j]*outline.y[i] - (double)outline.x[i]*outline.y[j];
 	}
-	else if( _type == POINT_POSITION_ABSOLUTE ){
-		auto it = absolutePoints.begin();
-		std::advance(it, round(ofRandom(absolutePoints.size()-1)) );
-		return &*it;
+	return fabs(area) * .5;
+}
+
+float vertexShape::getPerimeter() const {
+	if( numVertices < 2 ) return 0.f;
+	
+	const vertexSpan& outline = geometry->getOutline();
+	float perimeter = 0.f;
+	for(unsigned int i=0, j=numVertices-1; i<numVertices; j=i++){
+		perimeter += sqrtf( (outline.x[i]-outline.x[j])*(outline.x[i]-outline.x[j]) + (outline.y[i]-outline.y[j])*(outline.y[i]-outline.y[j]) );
 	}
-	else if( _type == POINT_POSITION_RELATIVE_UNALTERED ){
-		auto it = points.begin();
-		std::advance(it, round(ofRandom(points.size()-1)) );
-		return &*it;
+	return perimeter;
+}
+
+// wraps around
+unsigned int vertexShape::getNextVertexIndex( unsigned int _index, bool _getPrev ) const {
+	if( numVertices == 0 ) return 0;
+	
+	if( _getPrev ) return (_index+numVertices-1) % numVertices;
+	return (_index+1) % numVertices;
+}
+
+basicPoint* vertexShape::getCenterPtr(){
+	// todo
+	return &position;
+}
+
+// (re)allocates the vertex layers when the number of points changed, then copies points to them
+void vertexShape::syncVertices(){
+	if( points.size() != numVertices ){
+		vertexPool& pool = vertexPool::getInstance();
+		pool.release( vertexStorage );
+		
+		numVertices = points.size();
+		vertexStorage = pool.allocate( numVertices*3 );
+		changingVertices = pool.getSpan( vertexStorage, 0, numVertices );
+		absoluteVertices = pool.getSpan( vertexStorage, numVertices, numVertices );
+		renderVertices = pool.getSpan( vertexStorage, numVertices*2, numVertices );
 	}
-	else {
-		return &basicPoint::nullPoint;
+	
+	unsigned int i=0;
+	for(auto it = points.begin(); it != points.end(); it++, i++){
+		changingVertices.set( i, *it );
 	}
+	
+	// snap to the shared outline so the shared triangles fit
+	geometry = shapeGeometryLibrary::getInstance().acquire( changingVertices );
+	geometryOffset = (numVertices>0) ? changingVertices[0] : basicPoint(0,0);
+	vertexKernels::translate( geometry->getOutline().x, geometry->getOutline().y, changingVertices.x, changingVertices.y, numVertices, geometryOffset.x, geometryOffset.y );
+	
+	bRenderUnaltered = false;
+	bTrianglesDirty = true;
+	layoutRevision++;
 }
 
-basicPoint* vertexShape::getNextVertexPtr(basicPoint &_p, const basicShapePointType& _type, bool _getPrev){
-	if( _type == POINT_POSITION_RELATIVE ){
-		auto it= std::find( changingPoints.begin(), changingPoints.end(), _p );
-		if( it != changingPoints.end() ){
-			_getPrev ? --it : ++it;
-			return &*it;
-		}
-		else return &basicPoint::nullPoint;
+// FNV-1a over the coordinates
+uint64_t vertexShape::hashOutline( const vertexSpan& _outline ){
+	uint64_t key = 14695981039346656037ULL ^ _outline.size;
+	for(unsigned int i=0; i<_outline.size; ++i){
+		uint32_t bits[2];
+		memcpy( &bits[0], &_outline.x[i], sizeof(float) );
+		memcpy( &bits[1], &_outline.y[i], sizeof(float) );
+		key = (key ^ bits[0]) * 1099511628211ULL;
+		key = (key ^ bits[1]) * 1099511628211ULL;
 	}
-	else if( _type == POINT_POSITION_ABSOLUTE ){
-		auto it= std::find( absolutePoints.begin(), absolutePoints.end(), _p );
-		if( it != absolutePoints.end() ){
-			if(_getPrev && it == absolutePoints.begin()) return &*absolutePoints.end();
-			// incremment
-			_getPrev ? --it : ++it;
-			
-			if(!_getPrev && it==absolutePoints.end()) return &*absolutePoints.begin();
+	return key;
+}
 
-			return &(*it);
-		}
-		else return &basicPoint::nullPoint;
-	}
-	else if( _type == POINT_POSITION_RELATIVE_UNALTERED ){
-		auto it= std::find( points.begin(), points.end(), _p );
-		if( it != points.end() ){
-			_getPrev ? --it : ++it;
-			return &*it;
-		}
-		else return &basicPoint::nullPoint;
+// unaltered outlines use the geometry's triangles.
+// altered ones are triangulated into a vector of their own, never into the shared one.
+// most frames the outline is reset to the same scene points, the hash avoids triangulating those again
+const sharedTriangles& vertexShape::getSharedTriangles(){
+	if( !bTrianglesDirty ) return triangles;
+	bTrianglesDirty = false;
+	
+#ifdef KM_EDITOR_APP
+	const vertexSpan& outline = changingVertices;
+	const bool bUnaltered = !isModified();
+#else
+	const vertexSpan& outline = renderVertices;
+	const bool bUnaltered = bRenderUnaltered;
+#endif
+	
+	sharedTriangles current;
+	if( bUnaltered ){
+		current = geometry->getTriangles();
 	}
 	else {
-		return &basicPoint::nullPoint;
+		uint64_t key = hashOutline( outline );
+		if( !ownTriangles || key != ownTrianglesKey ){
+			ownTrianglesKey = key;
+			triangulator.triangulate( outline.x, outline.y, outline.size, newTriangles );
+			if( !ownTriangles || newTriangles != *ownTriangles ){
+				ownTriangles = make_shared< const vector<unsigned int> >( newTriangles );
+			}
+		}
+		current = ownTriangles;
 	}
+	
+	if( current != triangles && *current != *triangles ) trianglesRevision++;
+	triangles = current;
+	return triangles;
 }
 
-basicPoint* vertexShape::getCenterPtr(){
-	// todo
-	return &position;
+
+// simplified outlines are for rendering only, the editor works on the real one
+unsigned int vertexShape::getLodLevel( float _maxError ) const {
+#ifdef KM_EDITOR_APP
+	return 0;
+#else
+	return geometry->getLodLevel( _maxError );
+#endif
 }
 
+const vector<unsigned int>& vertexShape::getLodIndices( unsigned int _level ) const {
+	return geometry->getLodIndices( _level );
+}
+
+sharedTriangles vertexShape::getLodTriangles( unsigned int _level ){
+	if( _level == 0 ) return getSharedTriangles();
+	return geometry->getLodTriangles( _level );
+}
 
 #ifdef KM_EDITOR_APP
 // - - - - - - -
@@ -10,6 +10,11 @@
 
 #include "ofMain.h"
 #include "basicShape.h"
+#include "karmaRandom.h"
+#include "vertexPool.h"
+#include "polygonTriangulator.h"
+#include "vertexKernels.h"
+#include "shapeGeometry.h"
 //#include "ofxTextBox.h"
 
 class vertexShape : public basicShape {
@@ -28,6 +33,11 @@ public:
 	// LOAD & SAVE FUNCTIONS
 	virtual bool saveToXML(ofxXmlSettings& xml );
 	virtual bool loadFromXML(ofxXmlSettings& xml);
+	virtual bool loadFromBinary( const shapesBinaryScene& _scene, unsigned int _index );
+	virtual bool saveToXMLStream( karmaXmlWriter& _xml );
+	virtual bool onXmlElementStart( const karmaXmlElement& _element );
+	virtual void onXmlValue( const karmaXmlElement& _element );
+	virtual bool onXmlElementEnd( const karmaXmlElement& _element );
 	
 	// #########
 	// UTILITIES
@@ -35,16 +45,38 @@ public:
 	virtual void onShapeModified();
 	virtual void onShapeEdited();
 	virtual void resetToScene();
+	virtual void commitRenderState();
+	virtual bool isInside( const ofVec2f _pos, const bool _isPositionAbsolute = true) const;
+	virtual float getArea() const;
+	virtual float getPerimeter() const;
 	
 	// #########
 	// Vertex Shape Properties
 	
 	// Utilities
 	//basicPoint& getRandomVertex();
-	list<basicPoint> & getPoints( const basicShapePointType& _type = POINT_POSITION_RELATIVE );
+	// scene points. Call onShapeEdited() after altering them.
+	list<basicPoint> & getPoints();
+	// alterable vertices, flags the shape as modified. Call onShapeModified() after altering them.
+	vertexSpan getVertices( const basicShapePointType& _type = POINT_POSITION_RELATIVE );
+	// copy of the scene vertices, relative to the position
+	void getUnalteredVertices( vector<basicPoint>& _vertices ) const;
+	// committed vertices, for rendering
+	const vertexSpan& getRenderVertices() const { return renderVertices; } // relative
+	// cached triangulation of the drawn vertices, 3 vertex indexes per triangle (main thread)
+	// congruent unaltered shapes return the same vector
+	const sharedTriangles& getSharedTriangles();
+	unsigned int getTrianglesRevision() const { return trianglesRevision; } // increases when the triangles changed
+	// level of detail (see shapeGeometry), 0 is the full outline. The editor always uses the full outline.
+	unsigned int getLodLevel( float _maxError ) const;
+	const vector<unsigned int>& getLodIndices( unsigned int _level ) const; // vertex indexes drawn at _level
+	// above level 0, triangles follow the scene outline: strong deformations can fold them
+	sharedTriangles getLodTriangles( unsigned int _level );
 	int getNumPoints();
-	basicPoint* getRandomVertexPtr( const basicShapePointType& _type = POINT_POSITION_RELATIVE );
-	basicPoint* getNextVertexPtr(basicPoint& _p, const basicShapePointType& _type = POINT_POSITION_RELATIVE, bool _getPrev = false);
+	// vertex indexes stay valid until the shape gets edited
+	unsigned int getRandomVertexIndex( karmaRandom& _random ) const; // reproducible
+	unsigned int getNextVertexIndex( unsigned int _index, bool _getPrev = false ) const;
+	unsigned int getLayoutRevision() const { return layoutRevision; } // increases when the points got re-synced, vertex indexes might mean something else
 	basicPoint* getCenterPtr();
 	// idea: add gravity alterable values: point, averagePosition, etc.
 	
@@ -54,10 +86,42 @@ protected:
 	//bool hovered, selected;
 	//unsigned int numPoints;
 	
+	// (re)allocates the vertex layers and fills them with points
+	void syncVertices();
+	static uint64_t hashOutline( const vertexSpan& _outline );
+	
 	// vertexShape Properties
-	list<basicPoint> points; // relative coordinates
-	list<basicPoint> changingPoints; // relative alterable coordinates
-	list<basicPoint> absolutePoints; // copy of above but using absolute coordinates
+	list<basicPoint> points; // relative coordinates, as edited
+	
+	// scene outline, shared by congruent shapes
+	shared_ptr<shapeGeometry> geometry;
+	basicPoint geometryOffset; // position of the outline's first vertex
+	
+	// pooled vertex layers, [changing|absolute|render] in one block
+	vertexBlock vertexStorage;
+	unsigned int numVertices;
+	vertexSpan changingVertices; // relative alterable coordinates
+	vertexSpan absoluteVertices; // copy of above but using absolute coordinates
+	vertexSpan renderVertices; // changingVertices as they get drawn
+	unsigned int layoutRevision;
+	
+	// tessellation cache. Unaltered outlines use the geometry's triangles,
+	// altered ones get their own, only re-triangulated when the drawn outline really changed.
+	bool bTrianglesDirty;
+	bool bRenderUnaltered; // the render vertices are the scene outline
+	unsigned int trianglesRevision;
+	sharedTriangles triangles; // either the geometry's or ownTriangles
+	sharedTriangles ownTriangles;
+	uint64_t ownTrianglesKey; // hash of the vertices ownTriangles got triangulated from
+	vector<unsigned int> newTriangles;
+	polygonTriangulator triangulator;
+	ofMesh triangleMesh; // filled drawing
+	sharedTriangles meshTriangles; // triangles in triangleMesh
+	
+private:
+	// the vertex block can't be shared
+	vertexShape(const vertexShape&) = delete;
+	vertexShape& operator=(const vertexShape&) = delete;
 
 #ifdef KM_EDITOR_APP
 
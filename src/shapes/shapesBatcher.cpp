@@ -0,0 +1,238 @@
+//
+//  shapesBatcher.cpp
+//  karmaMapper
+//
+
+#include "shapesBatcher.h"
+
+// - - - - - - - -
+// CONSTRUCTORS
+// - - - - - - - -
+shapesBatcher::shapesBatcher() : numVertices(0), layoutRevision(1) {
+
+}
+
+shapesBatcher& shapesBatcher::getInstance(){
+	static shapesBatcher instance;
+	return instance;
+}
+
+// - - - - - - - -
+// SCENE GEOMETRY
+// - - - - - - - -
+void shapesBatcher::update( const list<basicShape*>& _shapes ){
+	if( needsRelayout(_shapes) ) relayout(_shapes);
+	
+	unsigned int dirtyBegin = numVertices;
+	unsigned int dirtyEnd = 0;
+	for(auto it=entries.begin(); it!=entries.end(); ++it){
+		batchedShape& e = *it;
+		
+		if( e.shape->getRenderRevision() == e.renderRevision ) continue;
+		e.renderRevision = e.shape->getRenderRevision();
+		
+		writeVertices(e);
+		dirtyBegin = MIN( dirtyBegin, e.vertexOffset );
+		dirtyEnd = MAX( dirtyEnd, e.vertexOffset+e.numVertices );
+		
+		// outline changed, the triangles might have too
+		updateTriangles(e);
+	}
+	
+	// upload changed vertices
+	if( dirtyEnd > dirtyBegin ){
+		GLsizeiptr offset = dirtyBegin * floatsPerVertex * sizeof(float);
+		GLsizeiptr bytes = (dirtyEnd-dirtyBegin) * floatsPerVertex * sizeof(float);
+		KM_RECORD_RENDER_CALL(batchUploadedBytes, bytes);
+#ifndef KM_BENCHMARK_APP
+		vertexBuffer.updateData( offset, bytes, &vertexData[dirtyBegin*floatsPerVertex] );
+#endif
+	}
+}
+
+void shapesBatcher::draw( shapesBatch& _batch, const vector<basicShape*>& _shapes, ofShader* _shader, float _lodError ){
+	// shapes changed ?
+	uint64_t key = 14695981039346656037ULL;
+	for(auto it=_shapes.cbegin(); it!=_shapes.cend(); ++it){
+		key = (key ^ (uintptr_t)(*it)) * 1099511628211ULL;
+	}
+	key = (key ^ _shapes.size()) * 1099511628211ULL;
+	
+	if( key != _batch.shapesKey || _batch.layoutRevision != layoutRevision || _batch.lodError != _lodError ){
+		rebuildBatch( _batch, _shapes, key, _lodError );
+	}
+	
+	bool bFill = ofGetStyle().bFill;
+	unsigned int count = bFill ? _batch.numTriangleIndices : _batch.numEdgeIndices;
+	if( count > 0 ){
+		KM_RECORD_RENDER_CALL(batchDraws, 1);
+		KM_RECORD_RENDER_CALL(vertices, count);
+
+#ifndef KM_BENCHMARK_APP
+		int stride = floatsPerVertex * sizeof(float);
+		_batch.vbo.setVertexBuffer( vertexBuffer, 2, stride, 0 );
+		if( _shader != nullptr ){
+			int location = _shader->getAttributeLocation("kmShapeCenter");
+			if( location >= 0 ) _batch.vbo.setAttributeBuffer( location, vertexBuffer, 2, stride, 2*sizeof(float) );
+			location = _shader->getAttributeLocation("kmShapeBoundingBox");
+			if( location >= 0 ) _batch.vbo.setAttributeBuffer( location, vertexBuffer, 4, stride, 4*sizeof(float) );
+		}
+		_batch.vbo.setIndexBuffer( bFill ? _batch.triangleBuffer : _batch.edgeBuffer );
+		_batch.vbo.drawElements( bFill ? GL_TRIANGLES : GL_LINES, count );
+#endif
+	}
+	
+	// not part of the scene, draw them the old way
+	for(auto it=_batch.unbatchedShapes.begin(); it!=_batch.unbatchedShapes.end(); ++it){
+		(*it)->sendToGPU();
+	}
+}
+
+bool shapesBatcher::supportsShader( ofShader& _shader ){
+#ifdef KM_BENCHMARK_APP
+	return true;
+#else
+	return _shader.isLoaded() && _shader.getAttributeLocation("kmShapeCenter") >= 0;
+#endif
+}
+
+unsigned int shapesBatcher::getNumVertices() const {
+	return numVertices;
+}
+
+unsigned int shapesBatcher::getLayoutRevision() const {
+	return layoutRevision;
+}
+
+void shapesBatcher::shutdown(){
+	entries.clear();
+	entryIndex.clear();
+	vertexData.clear();
+	vertexBuffer = ofBufferObject(); // drops the GL buffer
+	numVertices = 0;
+	layoutRevision++; // batches still around get rebuilt if ever drawn again
+}
+
+// - - - - - - - -
+// INTERNALS
+// - - - - - - - -
+bool shapesBatcher::needsRelayout( const list<basicShape*>& _shapes ) const {
+	auto e = entries.cbegin();
+	for(auto it=_shapes.cbegin(); it!=_shapes.cend(); ++it){
+		if( !(*it)->isType("vertexShape") ) continue;
+		
+		if( e == entries.cend() ) return true;
+		if( e->shape != *it ) return true;
+		if( e->numVertices != e->shape->getRenderVertices().size ) return true;
+		++e;
+	}
+	return e != entries.cend();
+}
+
+void shapesBatcher::relayout( const list<basicShape*>& _shapes ){
+	entries.clear();
+	entryIndex.clear();
+	numVertices = 0;
+	
+	for(auto it=_shapes.cbegin(); it!=_shapes.cend(); ++it){
+		if( !(*it)->isType("vertexShape") ) continue;
+		
+		batchedShape e;
+		e.shape = (vertexShape*)(*it);
+		e.vertexOffset = numVertices;
+		e.numVertices = e.shape->getRenderVertices().size;
+		e.renderRevision = e.shape->getRenderRevision();
+		updateTriangles(e);
+		
+		numVertices += e.numVertices;
+		entryIndex[*it] = entries.size();
+		entries.push_back(e);
+	}
+	
+	vertexData.resize( numVertices * floatsPerVertex );
+	for(auto it=entries.cbegin(); it!=entries.cend(); ++it){
+		writeVertices(*it);
+	}
+	
+	KM_RECORD_RENDER_CALL(batchUploadedBytes, vertexData.size()*sizeof(float));
+#ifndef KM_BENCHMARK_APP
+	if( vertexData.size() > 0 ){
+		vertexBuffer.allocate( vertexData.size()*sizeof(float), vertexData.data(), GL_DYNAMIC_DRAW );
+	}
+#endif
+	
+	layoutRevision++;
+}
+
+// the shapes cache their triangulation
+void shapesBatcher::updateTriangles( batchedShape& _entry ){
+	const sharedTriangles& triangles = _entry.shape->getSharedTriangles();
+	if( _entry.triangles && _entry.shape->getTrianglesRevision() == _entry.trianglesRevision ) return;
+	
+	_entry.trianglesRevision = _entry.shape->getTrianglesRevision();
+	_entry.triangles = triangles;
+	layoutRevision++; // batches need new indexes
+}
+
+void shapesBatcher::writeVertices( const batchedShape& _entry ){
+	const vertexSpan& render = _entry.shape->getRenderVertices();
+	const basicPoint& center = _entry.shape->getRenderPosition();
+	const ofRectangle& box = _entry.shape->getRenderBoundingBox();
+	
+	float* data = &vertexData[ _entry.vertexOffset * floatsPerVertex ];
+	for(unsigned int i=0; i<_entry.numVertices; ++i, data+=floatsPerVertex){
+		data[0] = render.x[i] + center.x;
+		data[1] = render.y[i] + center.y;
+		data[2] = center.x;
+		data[3] = center.y;
+		data[4] = box.x;
+		data[5] = box.y;
+		data[6] = box.width;
+		data[7] = box.height;
+	}
+}
+
+void shapesBatcher::rebuildBatch( shapesBatch& _batch, const vector<basicShape*>& _shapes, uint64_t _key, float _lodError ){
+	_batch.shapesKey = _key;
+	_batch.layoutRevision = layoutRevision;
+	_batch.lodError = _lodError;
+	_batch.unbatchedShapes.clear();
+	_batch.triangleIndices.clear();
+	_batch.edgeIndices.clear();
+	
+	for(auto it=_shapes.cbegin(); it!=_shapes.cend(); ++it){
+		auto found = entryIndex.find(*it);
+		if( found == entryIndex.end() ){
+			_batch.unbatchedShapes.push_back(*it);
+			continue;
+		}
+		
+		const batchedShape& e = entries[found->second];
+		unsigned int lodLevel = e.shape->getLodLevel( _lodError );
+		
+		// simplified triangles don't change with the outline, no need to keep them in the entry
+		sharedTriangles lodTriangles = (lodLevel>0) ? e.shape->getLodTriangles( lodLevel ) : e.triangles;
+		for(auto t=lodTriangles->cbegin(); t!=lodTriangles->cend(); ++t){
+			_batch.triangleIndices.push_back( e.vertexOffset + *t );
+		}
+		
+		const vector<unsigned int>& lodIndices = e.shape->getLodIndices( lodLevel );
+		if( lodIndices.size() < 2 ) continue;
+		for(unsigned int i=0; i<lodIndices.size(); ++i){
+			_batch.edgeIndices.push_back( e.vertexOffset + lodIndices[i] );
+			_batch.edgeIndices.push_back( e.vertexOffset + lodIndices[(i+1)%lodIndices.size()] );
+		}
+	}
+	
+	_batch.numTriangleIndices = _batch.triangleIndices.size();
+	_batch.numEdgeIndices = _batch.edgeIndices.size();
+
+#ifndef KM_BENCHMARK_APP
+	if( _batch.numTriangleIndices > 0 ){
+		_batch.triangleBuffer.allocate( _batch.numTriangleIndices*sizeof(unsigned int), _batch.triangleIndices.data(), GL_STATIC_DRAW );
+	}
+	if( _batch.numEdgeIndices > 0 ){
+		_batch.edgeBuffer.allocate( _batch.numEdgeIndices*sizeof(unsigned int), _batch.edgeIndices.data(), GL_STATIC_DRAW );
+	}
+#endif
+}
@@ -0,0 +1,93 @@
+//
+//  shapesBatcher.h
+//  karmaMapper
+//
+//	Keeps the triangles of all scene shapes in one persistent vertex buffer so an effect can draw all its shapes in one call.
+//	Triangles come from the shapes' tessellation cache. Each frame, only the vertices of shapes that changed are uploaded (one dirty range).
+//	Batches can draw simplified outlines (see shapeGeometry), those only index less vertices of the same buffer.
+//	Per-vertex attributes for shaders: kmShapeCenter (vec2) and kmShapeBoundingBox (vec4, x,y,w,h). Positions are absolute.
+//	Main thread only (GL). In the benchmark target nothing is uploaded, draws are recorded instead.
+//	The app has to call shutdown() from its exit(), the GL context is gone by the time statics get destroyed.
+//
+
+#pragma once
+
+#include "ofMain.h"
+#include "basicShape.h"
+#include "vertexShape.h"
+#include "karmaRenderRecorder.h"
+
+// per-effect list of shapes to draw, owned by the effect
+// its index buffers are rebuilt when the effect's shapes or the scene layout change
+class shapesBatch {
+public:
+	shapesBatch() : shapesKey(0), layoutRevision(0), lodError(0), numTriangleIndices(0), numEdgeIndices(0) {}
+
+private:
+	friend class shapesBatcher;
+	
+	uint64_t shapesKey;
+	unsigned int layoutRevision;
+	float lodError; // the indexes got built with
+	vector<basicShape*> unbatchedShapes; // drawn one by one
+	vector<unsigned int> triangleIndices;
+	vector<unsigned int> edgeIndices;
+	unsigned int numTriangleIndices;
+	unsigned int numEdgeIndices;
+	ofBufferObject triangleBuffer;
+	ofBufferObject edgeBuffer;
+	ofVbo vbo;
+};
+
+class shapesBatcher {
+public:
+	static shapesBatcher& getInstance();
+	
+	// call once per frame after shapes committed their render state
+	void update( const list<basicShape*>& _shapes );
+	
+	// draws the shapes with the current style: filled (triangles) or not (outlines)
+	// pass the bound shader to feed it the per-shape attributes
+	// _lodError: simplification error (px) the shapes may be drawn with (see basicEffect::getLodError())
+	void draw( shapesBatch& _batch, const vector<basicShape*>& _shapes, ofShader* _shader = nullptr, float _lodError = 0.f );
+	
+	// does the shader use the per-vertex shape attributes ? Otherwise it needs per-shape uniforms.
+	static bool supportsShader( ofShader& _shader );
+	
+	unsigned int getNumVertices() const;
+	unsigned int getLayoutRevision() const;
+	
+	// forgets the shapes and frees the vertex buffer
+	// call from the app's exit() while there's still a GL context
+	void shutdown();
+
+private:
+	shapesBatcher();
+	shapesBatcher(const shapesBatcher&) = delete;
+	shapesBatcher& operator=(const shapesBatcher&) = delete;
+	
+	// interleaved vertex: x, y, centerX, centerY, bbX, bbY, bbW, bbH
+	static const unsigned int floatsPerVertex = 8;
+	
+	struct batchedShape {
+		vertexShape* shape = nullptr;
+		unsigned int vertexOffset = 0;
+		unsigned int numVertices = 0;
+		unsigned int renderRevision = 0;
+		unsigned int trianglesRevision = 0;
+		sharedTriangles triangles; // local indexes, shared with the shape (and congruent ones)
+	};
+	
+	bool needsRelayout( const list<basicShape*>& _shapes ) const;
+	void relayout( const list<basicShape*>& _shapes );
+	void updateTriangles( batchedShape& _entry );
+	void writeVertices( const batchedShape& _entry );
+	void rebuildBatch( shapesBatch& _batch, const vector<basicShape*>& _shapes, uint64_t _key, float _lodError );
+	
+	vector<batchedShape> entries;
+	unordered_map<basicShape*, unsigned int> entryIndex;
+	vector<float> vertexData;
+	ofBufferObject vertexBuffer;
+	unsigned int numVertices;
+	unsigned int layoutRevision;
+};
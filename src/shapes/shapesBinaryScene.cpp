@@ -0,0 +1,279 @@
+//
+//  shapesBinaryScene.cpp
+//  karmaMapper
+//
+
+#include "shapesBinaryScene.h"
+#include "shapes.h"
+#include "polygonTriangulator.h"
+#include <fstream>
+
+static_assert( sizeof(shapesBinaryScene::fileHeader) == 64, "Binary scene header changed size" );
+static_assert( sizeof(shapesBinaryScene::shapeRecord) == 40, "Binary scene shape records changed size" );
+
+// - - - - - - - -
+// CONSTRUCTORS
+// - - - - - - - -
+shapesBinaryScene::shapesBinaryScene(){
+	close();
+}
+
+// - - - - - - - -
+// READING
+// - - - - - - - -
+bool shapesBinaryScene::open( const string& _path ){
+	close();
+	if( !file.open(_path) ) return false;
+	
+	if( !validate(_path) ){
+		close();
+		return false;
+	}
+	return true;
+}
+
+void shapesBinaryScene::close(){
+	file.close();
+	header = nullptr;
+	shapes = nullptr;
+	verticesX = verticesY = nullptr;
+	quantizedX = quantizedY = nullptr;
+	triangleIndices = nullptr;
+	strings = nullptr;
+}
+
+bool shapesBinaryScene::isBinaryScene( const string& _path ){
+	ifstream in( ofToDataPath(_path, true).c_str(), ios::binary );
+	uint32_t magic = 0;
+	in.read( (char*)&magic, sizeof(magic) );
+	return in.good() && magic == KM_BINARY_SCENE_MAGIC;
+}
+
+unsigned int shapesBinaryScene::getNumShapes() const {
+	return (header==nullptr) ? 0 : header->numShapes;
+}
+
+unsigned int shapesBinaryScene::getNumVertices() const {
+	return (header==nullptr) ? 0 : header->numVertices;
+}
+
+bool shapesBinaryScene::isQuantized() const {
+	return header!=nullptr && (header->flags & SCENE_QUANTIZED);
+}
+
+const shapesBinaryScene::shapeRecord& shapesBinaryScene::getShape( unsigned int _index ) const {
+	return shapes[_index];
+}
+
+// the pool ends with \0, so do all strings
+const char* shapesBinaryScene::getString( uint32_t _offset ) const {
+	if( strings == nullptr || _offset >= header->stringsSize ) return "";
+	return strings + _offset;
+}
+
+basicPoint shapesBinaryScene::getVertex( const shapeRecord& _shape, unsigned int _index ) const {
+	unsigned int i = _shape.firstVertex + _index;
+	if( quantizedX != nullptr ){
+		return basicPoint( quantizedX[i] * header->quantizationScale, quantizedY[i] * header->quantizationScale );
+	}
+	return basicPoint( verticesX[i], verticesY[i] );
+}
+
+const uint32_t* shapesBinaryScene::getTriangles( const shapeRecord& _shape ) const {
+	return triangleIndices + _shape.firstTriangleIndex;
+}
+
+// a corrupt or truncated file must not read out of the mapping
+bool shapesBinaryScene::validate( const string& _path ){
+	const uint64_t size = file.getSize();
+	if( size < sizeof(fileHeader) ){
+		ofLogError("shapesBinaryScene::open") << _path << " is too small to be a scene.";
+		return false;
+	}
+	
+	header = (const fileHeader*) file.getData();
+	if( header->magic != KM_BINARY_SCENE_MAGIC || header->byteOrder != 0x01020304 ){
+		ofLogError("shapesBinaryScene::open") << _path << " is not a binary scene (or was written with another byte order).";
+		return false;
+	}
+	if( header->version != KM_BINARY_SCENE_VERSION ){
+		ofLogError("shapesBinaryScene::open") << _path << " has version " << header->version << ", expected " << KM_BINARY_SCENE_VERSION << ". Re-convert it from XML.";
+		return false;
+	}
+	
+	bool bQuantized = header->flags & SCENE_QUANTIZED;
+	uint64_t vertexBytes = (uint64_t)header->numVertices * (bQuantized ? sizeof(int16_t) : sizeof(float));
+	
+	auto isInside = [size]( uint64_t _offset, uint64_t _bytes ){
+		return _offset % 4 == 0 && _offset + _bytes <= size;
+	};
+	if( !isInside( header->shapesOffset, (uint64_t)header->numShapes * sizeof(shapeRecord) ) ||
+		!isInside( header->verticesOffset, vertexBytes*2 ) ||
+		!isInside( header->trianglesOffset, (uint64_t)header->numTriangleIndices * sizeof(uint32_t) ) ||
+		!isInside( header->stringsOffset, header->stringsSize ) ||
+		header->stringsSize == 0 ||
+		(bQuantized && !(header->quantizationScale > 0.f)) ){
+		ofLogError("shapesBinaryScene::open") << _path << " is truncated or corrupt.";
+		return false;
+	}
+	
+	const unsigned char* data = file.getData();
+	shapes = (const shapeRecord*)( data + header->shapesOffset );
+	triangleIndices = (const uint32_t*)( data + header->trianglesOffset );
+	strings = (const char*)( data + header->stringsOffset );
+	if( bQuantized ){
+		quantizedX = (const int16_t*)( data + header->verticesOffset );
+		quantizedY = quantizedX + header->numVertices;
+	}
+	else {
+		verticesX = (const float*)( data + header->verticesOffset );
+		verticesY = verticesX + header->numVertices;
+	}
+	
+	if( strings[header->stringsSize-1] != '\0' ){
+		ofLogError("shapesBinaryScene::open") << _path << " has a corrupt string pool.";
+		return false;
+	}
+	
+	// ranges only, that's one pass over the (small) shape table
+	for(unsigned int s=0; s<header->numShapes; ++s){
+		const shapeRecord& r = shapes[s];
+		if( (uint64_t)r.firstVertex + r.numVertices > header->numVertices ||
+			(uint64_t)r.firstTriangleIndex + r.numTriangleIndices > header->numTriangleIndices ||
+			r.numTriangleIndices % 3 != 0 ){
+			ofLogError("shapesBinaryScene::open") << _path << " has a corrupt shape record (" << s << ").";
+			return false;
+		}
+	}
+	
+	return true;
+}
+
+// - - - - - - - -
+// WRITING
+// - - - - - - - -
+bool shapesBinaryScene::save( const list<basicShape*>& _shapes, const string& _path, bool _quantized ){
+	vector<shapeRecord> records;
+	vector<float> x, y;
+	vector<uint32_t> triangles;
+	string stringPool;
+	records.reserve( _shapes.size() );
+	
+	unordered_map<string, uint32_t> stringOffsets; // types repeat a lot
+	auto addString = [&]( const string& _str ){
+		auto found = stringOffsets.find( _str );
+		if( found != stringOffsets.end() ) return found->second;
+		
+		uint32_t offset = stringPool.size();
+		stringPool.append( _str.c_str(), _str.size()+1 );
+		stringOffsets[_str] = offset;
+		return offset;
+	};
+	
+	polygonTriangulator triangulator;
+	vector<float> shapeX, shapeY;
+	vector<unsigned int> shapeTriangles;
+	float maxCoordinate = 0.f;
+	
+	for(auto it=_shapes.cbegin(); it!=_shapes.cend(); ++it){
+		basicShape* shape = *it;
+		
+		shapeRecord r;
+		memset( &r, 0, sizeof(r) );
+		r.type = addString( shape->getShapeType() );
+		r.name = addString( shape->getName() );
+		r.groupID = shape->getGroupID();
+		r.x = shape->getPositionUnaltered()->x;
+		r.y = shape->getPositionUnaltered()->y;
+		r.firstVertex = x.size();
+		r.firstTriangleIndex = triangles.size();
+		
+		if( shape->isType("vertexShape") ){
+			list<basicPoint>& points = ((vertexShape*)shape)->getPoints();
+			shapeX.clear();
+			shapeY.clear();
+			for(auto p=points.cbegin(); p!=points.cend(); ++p){
+				shapeX.push_back( p->x );
+				shapeY.push_back( p->y );
+				maxCoordinate = MAX( maxCoordinate, MAX( fabs(p->x), fabs(p->y) ) );
+			}
+			x.insert( x.end(), shapeX.begin(), shapeX.end() );
+			y.insert( y.end(), shapeY.begin(), shapeY.end() );
+			r.numVertices = shapeX.size();
+			
+			triangulator.triangulate( shapeX.data(), shapeY.data(), shapeX.size(), shapeTriangles );
+			triangles.insert( triangles.end(), shapeTriangles.begin(), shapeTriangles.end() );
+			r.numTriangleIndices = shapeTriangles.size();
+		}
+		
+		records.push_back( r );
+	}
+	if( stringPool.empty() ) stringPool.push_back('\0');
+	
+	fileHeader h;
+	memset( &h, 0, sizeof(h) );
+	h.magic = KM_BINARY_SCENE_MAGIC;
+	h.version = KM_BINARY_SCENE_VERSION;
+	h.byteOrder = 0x01020304;
+	h.flags = _quantized ? SCENE_QUANTIZED : 0;
+	h.numShapes = records.size();
+	h.numVertices = x.size();
+	h.numTriangleIndices = triangles.size();
+	h.stringsSize = stringPool.size();
+	h.quantizationScale = (maxCoordinate > 0.f) ? maxCoordinate/32767.f : 1.f;
+	
+	auto align = []( uint64_t _offset ){ return (_offset+3) & ~(uint64_t)3; };
+	uint64_t vertexBytes = (uint64_t)h.numVertices * (_quantized ? sizeof(int16_t) : sizeof(float));
+	uint64_t offset = sizeof(fileHeader);
+	h.shapesOffset = offset;
+	offset = align( offset + records.size()*sizeof(shapeRecord) );
+	h.verticesOffset = offset;
+	offset = align( offset + vertexBytes*2 );
+	h.trianglesOffset = offset;
+	offset += triangles.size()*sizeof(uint32_t);
+	h.stringsOffset = offset;
+	offset += stringPool.size();
+	if( offset > 0xFFFFFFFFu ){
+		ofLogError("shapesBinaryScene::save") << "Scene is too big for the binary format (4GB).";
+		return false;
+	}
+	
+	string path = ofToDataPath( _path, true );
+	ofstream out( path.c_str(), ios::binary | ios::trunc );
+	if( !out.is_open() ){
+		ofLogError("shapesBinaryScene::save") << "Could not write " << path;
+		return false;
+	}
+	
+	const char padding[4] = {0,0,0,0};
+	auto pad = [&](){
+		out.write( padding, align( (uint64_t)out.tellp() ) - (uint64_t)out.tellp() );
+	};
+	
+	out.write( (const char*)&h, sizeof(h) );
+	out.write( (const char*)records.data(), records.size()*sizeof(shapeRecord) );
+	pad();
+	if( _quantized ){
+		vector<int16_t> q( x.size()*2 );
+		for(unsigned int i=0; i<x.size(); ++i){
+			q[i] = (int16_t) roundf( x[i] / h.quantizationScale );
+			q[x.size()+i] = (int16_t) roundf( y[i] / h.quantizationScale );
+		}
+		out.write( (const char*)q.data(), q.size()*sizeof(int16_t) );
+	}
+	else {
+		out.write( (const char*)x.data(), x.size()*sizeof(float) );
+		out.write( (const char*)y.data(), y.size()*sizeof(float) );
+	}
+	pad();
+	out.write( (const char*)triangles.data(), triangles.size()*sizeof(uint32_t) );
+	out.write( stringPool.data(), stringPool.size() );
+	
+	if( !out.good() ){
+		ofLogError("shapesBinaryScene::save") << "Failed writing " << path;
+		return false;
+	}
+	
+	ofLogNotice("shapesBinaryScene::save") << "Saved " << records.size() << " shapes (" << h.numVertices << " vertices" << (_quantized?", quantized":"") << ") to " << path;
+	return true;
+}
@@ -0,0 +1,93 @@
+//
+//  shapesBinaryScene.h
+//  karmaMapper
+//
+//	Binary scene files (.kmscene), memory mapped and read in place: loading a shape is copying its vertices, no parsing.
+//	Layout (little endian, sections 4-byte aligned): header, shape table, vertex pool (all x then all y), triangle indexes, string pool.
+//	Vertices are relative to their shape's position, as floats or quantized to 16 bit (scale in the header).
+//	The triangles are the shapes' ear-clipped outlines, so they don't need to be triangulated again on load.
+//	XML stays the editable format, shapesScene::convertScene() goes both ways.
+//
+
+#pragma once
+
+#include "ofMain.h"
+#include "KMSettings.h"
+#include "basicPoint.h"
+#include "karmaMappedFile.h"
+
+#define KM_BINARY_SCENE_MAGIC 0x42534D4B // "KMSB"
+#define KM_BINARY_SCENE_VERSION 1
+
+class basicShape;
+
+class shapesBinaryScene {
+public:
+	enum fileFlags {
+		SCENE_QUANTIZED = 1 // int16 vertices
+	};
+	
+	// 64 bytes
+	struct fileHeader {
+		uint32_t magic;
+		uint32_t version;
+		uint32_t byteOrder; // 0x01020304 as written
+		uint32_t flags;
+		uint32_t numShapes;
+		uint32_t numVertices;
+		uint32_t numTriangleIndices;
+		uint32_t stringsSize;
+		uint32_t shapesOffset; // in bytes, from the start of the file
+		uint32_t verticesOffset;
+		uint32_t trianglesOffset;
+		uint32_t stringsOffset;
+		float quantizationScale; // coordinate = quantized value * scale
+		uint32_t reserved[3];
+	};
+	
+	// 40 bytes
+	struct shapeRecord {
+		uint32_t type; // string pool offsets
+		uint32_t name;
+		int32_t groupID;
+		float x;
+		float y;
+		uint32_t firstVertex;
+		uint32_t numVertices;
+		uint32_t firstTriangleIndex;
+		uint32_t numTriangleIndices; // 3 per triangle, local vertex indexes
+		uint32_t reserved;
+	};
+	
+	shapesBinaryScene();
+	
+	// maps and validates the file, _path is absolute or relative to the data folder
+	bool open( const string& _path );
+	void close();
+	static bool isBinaryScene( const string& _path ); // checks the magic
+	
+	unsigned int getNumShapes() const;
+	unsigned int getNumVertices() const;
+	bool isQuantized() const;
+	
+	// only call with valid indexes (< getNumShapes())
+	const shapeRecord& getShape( unsigned int _index ) const;
+	const char* getString( uint32_t _offset ) const;
+	basicPoint getVertex( const shapeRecord& _shape, unsigned int _index ) const; // relative
+	const uint32_t* getTriangles( const shapeRecord& _shape ) const;
+	
+	static bool save( const list<basicShape*>& _shapes, const string& _path, bool _quantized = false );
+
+private:
+	bool validate( const string& _path );
+	
+	karmaMappedFile file;
+	const fileHeader* header;
+	const shapeRecord* shapes;
+	const float* verticesX;
+	const float* verticesY;
+	const int16_t* quantizedX;
+	const int16_t* quantizedY;
+	const uint32_t* triangleIndices;
+	const char* strings;
+};
@@ -21,130 +21,315 @@ shapesDB::shapesDB(){
 }
 
 shapesDB::~shapesDB(){
-
+	// ~shapesScene() can't reach onShapeRemoved() anymore
+	unloadShapes();
 }
 
 // - - - - - - - - -
 // SHAPE SERVING FUNCTIONS
 // - - - - - - - - -
 basicShape* shapesDB::getRandomShape(){
-	if(shapes.size()<1){
+	karmaRandom random = getUnseededRandom();
+	return getRandomShape( random );
+}
+
+vector<basicShape*> shapesDB::getRandomShapes(int _amount, bool _returnExactAmount ) {
+	karmaRandom random = getUnseededRandom();
+	return getRandomShapes( random, _amount, _returnExactAmount );
+}
+
+basicShape* shapesDB::getRandomShape( karmaRandom& _random ) const {
+	if(indexedShapes.size()<1){
 		ofLogError("shapesDB::getRandomShape()", "There are not yet any shapes to serve!");
 		
 		// todo; return an error shape ?
 		return NULL;
 	}
 	
-	int offset( round( ofRandomuf()-.49f*(shapes.size()-.011f) ) );
-	list<basicShape*>::iterator it = shapes.begin();
-	std::advance(it,offset);
-	return *it;
-	
+	return indexedShapes[ _random.getIndex( indexedShapes.size() ) ];
 }
 
-vector<basicShape*> shapesDB::getRandomShapes(int _amount, bool _returnExactAmount ) {
-	
-	// select unique shapes when possible
-	// todo: add a vector<int> remainingIndexes for optimisation
-	vector<int> selected;
+vector<basicShape*> shapesDB::getRandomShapes( karmaRandom& _random, int _amount, bool _returnExactAmount ) const {
 	vector<basicShape*> retShapes;
-	selected.resize(_amount);
-	int numAdded = 0;
-	while(numAdded < _amount && numAdded < getNumShapes() ){
-		int newSh = ofRandom( 0.49f+getNumShapes()-1 );
-		if( std::find( selected.begin(), selected.end(), newSh)==selected.end() ){
-			// found a new one
-			list<basicShape*>::iterator it = shapes.begin();
-			std::advance(it,newSh);
-			retShapes.push_back(*it);
-			selected[numAdded]=newSh;
-			numAdded++;
-			//cout << "Rand=" << newSh << "[/"<< getNumShapes() << "]" << endl;
+	if( _amount <= 0 || indexedShapes.size() < 1 ) return retShapes;
+	
+	unsigned int numShapes = indexedShapes.size();
+	unsigned int numUnique = MIN( (unsigned int)_amount, numShapes );
+	retShapes.reserve( _returnExactAmount ? _amount : numUnique );
+	
+	// partial Fisher-Yates: only the first numUnique swaps
+	if( numUnique*4 >= numShapes ){
+		vector<unsigned int> order( numShapes );
+		for(unsigned int i=0; i<numShapes; ++i) order[i] = i;
+		for(unsigned int i=0; i<numUnique; ++i){
+			unsigned int j = i + _random.getIndex( numShapes-i );
+			std::swap( order[i], order[j] );
+			retShapes.push_back( indexedShapes[ order[i] ] );
+		}
+	}
+	// few out of many: only remember the swapped slots
+	else {
+		unordered_map<unsigned int, unsigned int> swapped;
+		swapped.reserve( numUnique*2 );
+		for(unsigned int i=0; i<numUnique; ++i){
+			unsigned int j = i + _random.getIndex( numShapes-i );
+			auto atI = swapped.find(i);
+			auto atJ = swapped.find(j);
+			unsigned int valueI = (atI==swapped.end()) ? i : atI->second;
+			unsigned int valueJ = (atJ==swapped.end()) ? j : atJ->second;
+			swapped[j] = valueI;
+			retShapes.push_back( indexedShapes[ valueJ ] );
 		}
 	}
 	
-	// if there are les shapes then the asked amount, fill them with random duplicates
-	if(_returnExactAmount && numAdded<_amount){
-		while( numAdded!=_amount){
-			retShapes.push_back( getRandomShape() );
-			numAdded++;
+	// if there are less shapes than the asked amount, fill them with random duplicates
+	if(_returnExactAmount){
+		while( retShapes.size() < (unsigned int)_amount ){
+			retShapes.push_back( indexedShapes[ _random.getIndex( numShapes ) ] );
 		}
 	}
 	
 	return retShapes;
 }
 
-// todo: add int _limit restriction param (and randomize)
-vector<basicShape*> shapesDB::getShapesByType(string _type){
-	vector<basicShape*> ret;
-	ret.clear();
-	ret.resize(0);
+basicShape* shapesDB::getRandomShapeWeighted( karmaRandom& _random, shapeWeighting _weighting ){
+	if(indexedShapes.size()<1){
+		ofLogError("shapesDB::getRandomShapeWeighted()", "There are not yet any shapes to serve!");
+		return NULL;
+	}
 	
-	// loop trough shapes and return the wanted ones
-	for(auto it = shapes.begin(); it != shapes.end(); it++){
-		if((*it)->getShapeType() == _type ) ret.push_back((*it));
+	aliasTable& table = (_weighting == SHAPE_WEIGHT_PERIMETER) ? perimeterTable : areaTable;
+	{
+		ofScopedLock lock(weightsMutex);
+		if( table.bDirty ) buildAliasTable( table, _weighting );
 	}
 	
+	unsigned int i = _random.getIndex( table.probability.size() );
+	if( _random.getFloat() < table.probability[i] ) return indexedShapes[i];
+	return indexedShapes[ table.alias[i] ];
+}
+
+const vector<basicShape*>& shapesDB::getShapesByType(const string& _type) const {
+	auto it = shapesByType.find( _type );
+	if( it == shapesByType.end() ) return noShapes;
+	return it->second;
+}
+
+const map<string, vector<basicShape*> >& shapesDB::getAllShapesByType() const {
+	return shapesByType;
+}
+
+const map<int, vector<basicShape*>>& shapesDB::getAllShapesByGroup() const {
+	return shapesByGroup;
+}
+
+basicShape* shapesDB::getRandomShapeByType(const string& _type){
+	const vector<basicShape*>& ret = getShapesByType(_type);
+	if(ret.size()<=0) return NULL;
+	
+	karmaRandom random = getUnseededRandom();
+	return ret[ random.getIndex( ret.size() ) ];
+}
+
+const vector<basicShape*>& shapesDB::getShapesByGroup(int _group) const {
+	auto it = shapesByGroup.find( _group );
+	if( it == shapesByGroup.end() ) return noShapes;
+	return it->second;
+}
+
+basicShape* shapesDB::getRandomShapeByGroup(int _group){
+	const vector<basicShape*>& ret = getShapesByGroup(_group);
+	if(ret.size()<=0) return NULL;
+	karmaRandom random = getUnseededRandom();
+	return ret[ random.getIndex( ret.size() ) ];
+}
+
+basicShape* shapesDB::getShapeByName( const string& _name ) const {
+	if( _name.empty() ) return nullptr;
+	
+	auto it = shapesByName.find( _name );
+	if( it == shapesByName.end() ) return nullptr;
+	return it->second;
+}
+
+void shapesDB::reindexShape( basicShape* _shape ){
+	if( shapeKeys.find(_shape) == shapeKeys.end() ) return;
+	
+	removeFromIndexes( _shape );
+	addToIndexes( _shape );
+	
+	ofScopedLock lock(weightsMutex);
+	areaTable.bDirty = perimeterTable.bDirty = true;
+}
+
+// - - - - - - - -
+// SPATIAL QUERIES
+// - - - - - - - -
+basicShape* shapesDB::getShapeAt( const ofVec2f& _pos ) const {
+	return spatialIndex.getShapeAt( _pos );
+}
+
+vector<basicShape*> shapesDB::getShapesAt( const ofVec2f& _pos ) const {
+	vector<basicShape*> ret;
+	spatialIndex.getShapesAt( _pos, ret );
 	return ret;
 }
 
-map<string, vector<basicShape*> > shapesDB::getAllShapesByType() const {
-	map<string, vector<basicShape*> > ret;
-	for( auto it=shapes.begin(); it!=shapes.end(); ++it ){
-		if( ret.find( (*it)->getShapeType() ) == ret.end() ){
-			ret[ (*it)->getShapeType() ] = vector<basicShape*>();
-		}
-		ret[ (*it)->getShapeType() ].push_back(*it);
-	}
+vector<basicShape*> shapesDB::getShapesInRect( const ofRectangle& _rect, bool _fullyInside ) const {
+	vector<basicShape*> ret;
+	spatialIndex.getShapesInRect( _rect, ret, _fullyInside );
 	return ret;
 }
 
-map<int, vector<basicShape*>> shapesDB::getAllShapesByGroup() const {
+vector<basicShape*> shapesDB::getNearestShapes( const ofVec2f& _pos, unsigned int _count ) const {
+	vector<basicShape*> ret;
+	spatialIndex.getNearestShapes( _pos, _count, ret );
+	return ret;
+}
+
+void shapesDB::markShapeMoved( basicShape* _shape ){
+	spatialIndex.markDirty( _shape );
+}
+
+void shapesDB::updateSpatialIndex(){
+	spatialIndex.update();
+}
+
+// - - - - - - - -
+// INDEXES
+// - - - - - - - -
+const vector<basicShape*> shapesDB::noShapes;
+
+void shapesDB::swapScene( shapesDB& _other ){
+	shapesScene::swapScene( _other );
 	
-	map<int, vector<basicShape*> > ret;
-	for( auto it=shapes.begin(); it!=shapes.end(); ++it ){
-		if( ret.find( (*it)->getGroupID() ) == ret.end() ){
-			ret[ (*it)->getGroupID() ] = vector<basicShape*>();
-		}
-		ret[ (*it)->getGroupID() ].push_back(*it);
+	std::swap( spatialIndex, _other.spatialIndex );
+	shapeKeys.swap( _other.shapeKeys );
+	shapesByName.swap( _other.shapesByName );
+	shapesByType.swap( _other.shapesByType );
+	shapesByGroup.swap( _other.shapesByGroup );
+	indexedShapes.swap( _other.indexedShapes );
+	
+	{
+		ofScopedLock lock(weightsMutex);
+		areaTable.bDirty = perimeterTable.bDirty = true;
 	}
-	return ret;
+	ofScopedLock lock(_other.weightsMutex);
+	_other.areaTable.bDirty = _other.perimeterTable.bDirty = true;
 }
 
-basicShape* shapesDB::getRandomShapeByType(string _type){
-	vector<basicShape*> ret = getShapesByType(_type);
-	if(ret.size()<=0) return NULL;
+void shapesDB::onShapeInserted( basicShape* _shape ){
+	spatialIndex.insert( _shape );
+	addToIndexes( _shape );
+	shapeHandles::getInstance().registerShape( _shape );
+	indexedShapes.push_back( _shape );
 	
-	return ret[round(-.49f+ofRandomuf()*(ret.size()-0.011f))];
+	ofScopedLock lock(weightsMutex);
+	areaTable.bDirty = perimeterTable.bDirty = true;
 }
 
-// todo: add int _limit restriction param (and randomize)
-vector<basicShape*> shapesDB::getShapesByGroup(int _group){
-	vector<basicShape*> ret;
-	ret.clear();
-	ret.resize(0);
+void shapesDB::onShapeRemoved( basicShape* _shape ){
+	spatialIndex.remove( _shape );
+	removeFromIndexes( _shape );
+	shapeHandles::getInstance().unregisterShape( _shape );
+	indexedShapes.erase( std::remove( indexedShapes.begin(), indexedShapes.end(), _shape ), indexedShapes.end() );
+	
+	ofScopedLock lock(weightsMutex);
+	areaTable.bDirty = perimeterTable.bDirty = true;
+}
+
+void shapesDB::addToIndexes( basicShape* _shape ){
+	indexedKeys& keys = shapeKeys[_shape];
+	keys.name = _shape->getName();
+	keys.type = _shape->getShapeType();
+	keys.group = _shape->getGroupID();
+	
+	// first one wins on duplicate names, like the old linear search
+	shapesByName.insert( make_pair(keys.name, _shape) );
+	shapesByType[keys.type].push_back( _shape );
+	shapesByGroup[keys.group].push_back( _shape );
+}
+
+void shapesDB::removeFromIndexes( basicShape* _shape ){
+	auto found = shapeKeys.find( _shape );
+	if( found == shapeKeys.end() ) return;
+	const indexedKeys& keys = found->second;
+	
+	// keep scene order within the lists
+	auto removeFrom = [_shape]( vector<basicShape*>& _list ){
+		_list.erase( std::remove( _list.begin(), _list.end(), _shape ), _list.end() );
+	};
 	
-	// loop trough shapes and return the wanted ones
-	for(auto it = shapes.begin(); it != shapes.end(); it++){
-		if((*it)->getGroupID() == _group ) ret.push_back((*it));
+	removeFrom( shapesByType[keys.type] );
+	if( shapesByType[keys.type].empty() ) shapesByType.erase( keys.type );
+	
+	removeFrom( shapesByGroup[keys.group] );
+	if( shapesByGroup[keys.group].empty() ) shapesByGroup.erase( keys.group );
+	
+	auto named = shapesByName.find( keys.name );
+	if( named != shapesByName.end() && named->second == _shape ){
+		shapesByName.erase( named );
+		
+		// another shape with the same name ?
+		for(auto it=shapes.begin(); it!=shapes.end(); ++it){
+			if( *it != _shape && shapeKeys.count(*it) && shapeKeys[*it].name == keys.name ){
+				shapesByName[keys.name] = *it;
+				break;
+			}
+		}
 	}
 	
-	return ret;
+	shapeKeys.erase( found );
 }
 
-basicShape* shapesDB::getRandomShapeByGroup(int _group){
-	vector<basicShape*> ret = getShapesByGroup(_group);
-	if(ret.size()<=0) return NULL;
-	return ret[round(-.49f+(ofRandomuf()*(ret.size()-.011f)))];
+// - - - - - - - -
+// RANDOM SAMPLING
+// - - - - - - - -
+karmaRandom shapesDB::getUnseededRandom(){
+	// ofRandom() is seeded by ofSeedRandom(), so the old behaviour stays
+	uint64_t seed = (uint64_t)ofRandom(4294967295.f);
+	return karmaRandom( seed, (uint64_t)ofRandom(4294967295.f) );
 }
 
-basicShape* shapesDB::getShapeByName( string _name ){
-	if( _name.empty() ) return nullptr;
+// weightsMutex must be locked
+void shapesDB::buildAliasTable( aliasTable& _table, shapeWeighting _weighting ){
+	unsigned int numShapes = indexedShapes.size();
+	_table.probability.assign( numShapes, 1.f );
+	_table.alias.resize( numShapes );
+	_table.bDirty = false;
+	
+	vector<double> weights( numShapes, 0. );
+	double total = 0.;
+	for(unsigned int i=0; i<numShapes; ++i){
+		_table.alias[i] = i;
+		
+		float w = (_weighting == SHAPE_WEIGHT_PERIMETER) ? indexedShapes[i]->getPerimeter() : indexedShapes[i]->getArea();
+		if( w > 0.f && w == w ) weights[i] = w;
+		total += weights[i];
+	}
+	if( total <= 0. ) return; // uniform
+	
+	// scale to an average of 1, then pair small ones with big ones
+	vector<unsigned int> small, large;
+	for(unsigned int i=0; i<numShapes; ++i){
+		weights[i] *= numShapes / total;
+		if( weights[i] < 1. ) small.push_back(i);
+		else large.push_back(i);
+	}
+	while( !small.empty() && !large.empty() ){
+		unsigned int s = small.back(); small.pop_back();
+		unsigned int l = large.back();
+		
+		_table.probability[s] = weights[s];
+		_table.alias[s] = l;
 		
-	for(auto it = shapes.begin(); it != shapes.end(); it++){
-		if( (*it)->getName().compare( _name )==0 ){
-			return (*it);
+		weights[l] -= 1. - weights[s];
+		if( weights[l] < 1. ){
+			large.pop_back();
+			small.push_back(l);
 		}
 	}
-	return nullptr;
+	// leftovers are 1 (rounding)
+	for(auto it=small.cbegin(); it!=small.cend(); ++it) _table.probability[*it] = 1.f;
+	for(auto it=large.cbegin(); it!=large.cend(); ++it) _table.probability[*it] = 1.f;
 }
@@ -12,7 +12,15 @@
 #include "KMSettings.h"
 #include "shapesScene.h"
 #include "shapes.h"
+#include "shapesSpatialIndex.h"
+#include "shapeHandles.h"
+#include "karmaRandom.h"
 
+// for weighted random sampling
+enum shapeWeighting {
+	SHAPE_WEIGHT_AREA,
+	SHAPE_WEIGHT_PERIMETER
+};
 
 class shapesDB : public shapesScene { // holds the whole shapes "scene"
 
@@ -30,19 +38,76 @@ public:
 	}
 	basicShape* getRandomShape();
 	vector<basicShape*> getRandomShapes(int _amount=1, bool _returnExactAmount = true );
-	vector<basicShape*> getShapesByType(string _type);
-	map<string, vector<basicShape*> > getAllShapesByType() const;
-	map<int, vector<basicShape*>> getAllShapesByGroup() const;
 	
+	// O(1) per shape, reproducible with the effect's random stream
+	basicShape* getRandomShape( karmaRandom& _random ) const;
+	// unique shapes (partial Fisher-Yates), then duplicates if _returnExactAmount
+	vector<basicShape*> getRandomShapes( karmaRandom& _random, int _amount, bool _returnExactAmount = true ) const;
+	// bigger shapes come out more often. Shapes without surface (points) never do, unless all are.
+	basicShape* getRandomShapeWeighted( karmaRandom& _random, shapeWeighting _weighting = SHAPE_WEIGHT_AREA );
+	
+	// indexed lookups, no copies. Views stay valid until shapes are inserted, removed or re-indexed.
+	const vector<basicShape*>& getShapesByType(const string& _type) const;
+	const map<string, vector<basicShape*> >& getAllShapesByType() const;
+	const map<int, vector<basicShape*>>& getAllShapesByGroup() const;
 	
-	basicShape* getRandomShapeByType(string _type);
-	vector<basicShape*> getShapesByGroup(int _group);
+	basicShape* getRandomShapeByType(const string& _type);
+	const vector<basicShape*>& getShapesByGroup(int _group) const;
 	basicShape* getRandomShapeByGroup(int _group);
-	basicShape* getShapeByName( string _name );
+	basicShape* getShapeByName( const string& _name ) const;
+	
+	// call after changing a shape's name or group, or its scene outline (weights)
+	void reindexShape( basicShape* _shape );
 	
+	// exchanges all shapes with _other, indexes included. Nothing may be using either scene meanwhile.
+	void swapScene( shapesDB& _other );
 	
+	// spatial queries on the shapes' bounding boxes as of the last updateSpatialIndex() (see shapesSpatialIndex)
+	// point queries also test the live outline: main thread only, not while effects update
+	basicShape* getShapeAt( const ofVec2f& _pos ) const; // topmost
+	vector<basicShape*> getShapesAt( const ofVec2f& _pos ) const;
+	// these only read the indexed boxes, effects can use them from parallel updates
+	vector<basicShape*> getShapesInRect( const ofRectangle& _rect, bool _fullyInside = false ) const;
+	vector<basicShape*> getNearestShapes( const ofVec2f& _pos, unsigned int _count = 1 ) const;
+	// the shape's bounding box changed
+	void markShapeMoved( basicShape* _shape );
+	// re-bins the moved shapes, once per frame from the main thread while nobody queries
+	void updateSpatialIndex();
+	
+protected:
+	virtual void onShapeInserted( basicShape* _shape );
+	virtual void onShapeRemoved( basicShape* _shape );
 	
 private:
+	shapesSpatialIndex spatialIndex;
+	
+	// what a shape was indexed with, its getters might have changed since
+	struct indexedKeys {
+		string name;
+		string type;
+		int group;
+	};
+	void addToIndexes( basicShape* _shape );
+	void removeFromIndexes( basicShape* _shape );
+	
+	unordered_map<basicShape*, indexedKeys> shapeKeys;
+	unordered_map<string, basicShape*> shapesByName;
+	map<string, vector<basicShape*> > shapesByType; // ordered for GUIs
+	map<int, vector<basicShape*> > shapesByGroup;
+	static const vector<basicShape*> noShapes;
 	
+	// random sampling
+	static karmaRandom getUnseededRandom(); // for the ofRandom()-like calls
+	vector<basicShape*> indexedShapes; // scene order
 	
+	// Vose alias tables, rebuilt when shapes change
+	struct aliasTable {
+		bool bDirty = true;
+		vector<float> probability;
+		vector<unsigned int> alias;
+	};
+	void buildAliasTable( aliasTable& _table, shapeWeighting _weighting );
+	aliasTable areaTable;
+	aliasTable perimeterTable;
+	ofMutex weightsMutex;
 };
@@ -62,6 +62,7 @@ void shapesEditor::update() {
 	for(auto s = shapes.rbegin(); s!=shapes.rend(); ){
 		if( (*s)->pleaseDeleteMe ){
 			selectShape(NULL); // todo: [later] this is wrong if we (can) delete from batch mode
+			onShapeRemoved(*s);
 			delete (*s);
 			s++;
 			s= std::list<basicShape*>::reverse_iterator( shapes.erase(s.base()) );
@@ -485,6 +486,7 @@ void shapesEditor::selectShape(basicShape* _i, const bool& preventToggle, const
 				// toggle selection
 				if(!preventToggle){
 					(*it)->disableEditMode();
+					spatialIndex.markDirty( *it );
 					selectedShapes.erase(it);
 					multiShapesHandler.onShapeSelectionUpdated( selectedShapes );
 				}
@@ -508,6 +510,7 @@ void shapesEditor::selectShape(basicShape* _i, const bool& preventToggle, const
 	else if ( _i == NULL && selectedShapes.size()>0 ){
 		for(auto it=selectedShapes.begin(); it!=selectedShapes.end(); it++){
 			(*it)->disableEditMode();
+			spatialIndex.markDirty( *it );
 		}
 		selectedShapes.clear();
 		multiShapesHandler.onShapeSelectionUpdated( selectedShapes );
@@ -691,14 +694,18 @@ void shapesEditor::_mousePressed(ofMouseEventArgs &e){
 	
 	// let user select multiple shapes by clicking on them
 	if( e.button==0 && isInEditMode()){
-		for(auto it=shapes.rbegin(); it!=shapes.rend(); it++){
-			if( (*it)->isInside( e ) ){
-				bool allowMultiple = ofGetKeyPressed( OF_KEY_SHIFT) || ofGetKeyPressed( OF_KEY_RIGHT_SHIFT) || isInEditModeBatch();
-				
-				// toggle clicked shape
-				selectShape( *it, false, allowMultiple );
-				return;
-			}
+		// only selected shapes can be edited (handles, transformator, GUI), re-bin those
+		for(auto it=selectedShapes.begin(); it!=selectedShapes.end(); it++){
+			spatialIndex.markDirty( *it );
+		}
+		spatialIndex.update();
+		basicShape* clicked = spatialIndex.getShapeAt( e );
+		if( clicked != nullptr ){
+			bool allowMultiple = ofGetKeyPressed( OF_KEY_SHIFT) || ofGetKeyPressed( OF_KEY_RIGHT_SHIFT) || isInEditModeBatch();
+			
+			// toggle clicked shape
+			selectShape( clicked, false, allowMultiple );
+			return;
 		}
 		
 		// deselect
@@ -723,6 +730,15 @@ void shapesEditor::_keyPressed(ofKeyEventArgs &e){
 	}
 }
 
+// keeps the picking index in sync with the scene
+void shapesEditor::onShapeInserted( basicShape* _shape ){
+	spatialIndex.insert( _shape );
+}
+
+void shapesEditor::onShapeRemoved( basicShape* _shape ){
+	spatialIndex.remove( _shape );
+}
+
 
 // - - - - - - - -
 // MENU EVENT LISTENERS
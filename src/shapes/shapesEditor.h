@@ -16,6 +16,7 @@
 #include "shapes.h"
 #include "shapesScene.h"
 #include "shapesTransformator.h"
+#include "shapesSpatialIndex.h"
 #include "ofxGui.h"
 
 enum shapesEditMode {
@@ -75,6 +76,10 @@ public:
 	void setFullScreen( bool & _fullScreen );
 	void enableShapeEditing( bool & _on );
 
+protected:
+	virtual void onShapeInserted( basicShape* _shape );
+	virtual void onShapeRemoved( basicShape* _shape );
+
 private:
 	
 private:
@@ -83,6 +88,7 @@ private:
 	list<basicShape*> selectedShapes;
 	shapesTransformator multiShapesHandler;
 	shapesEditMode editMode;
+	shapesSpatialIndex spatialIndex; // mouse picking
 	
 	// GUI (new)
 	ofxPanelExtended editorGui;
@@ -7,12 +7,89 @@
 //
 
 #include "shapesScene.h"
+#include "shapesBinaryScene.h"
 
 // forward declare
 //namespace shape {
 //	basicShape* create(const std::string& name);
 //}
 
+// collects the <shape> tags of <shapes>
+// the shape is created once its shapeType has been read, the tags before it are kept and replayed to it
+class shapesSceneXmlReader : public karmaXmlVisitor {
+public:
+	shapesSceneXmlReader() : currentShape(nullptr), bUnknownType(false), bFailed(false) {}
+	
+	~shapesSceneXmlReader(){
+		// parsing failed
+		delete currentShape;
+		for(auto it=shapes.begin(); it!=shapes.end(); ++it) delete (*it);
+	}
+	
+	virtual bool onXmlElementStart( const karmaXmlElement& _element ){
+		if( _element.getDepth() == 0 ) return _element.is("shapes");
+		if( _element.getDepth() == 1 ){
+			if( !_element.is("shape") ) return false;
+			bUnknownType = false;
+			shapeReader.begin( 1 );
+		}
+		if( bUnknownType ) return false;
+		return shapeReader.onXmlElementStart( _element );
+	}
+	
+	virtual void onXmlValue( const karmaXmlElement& _element ){
+		if( _element.getDepth() == 0 || bUnknownType ) return;
+		if( _element.getDepth() == 2 && _element.is("shapeType") && currentShape == nullptr ){
+			createShape( _element.getValue("basicShape") );
+			if( currentShape == nullptr ) return;
+		}
+		shapeReader.onXmlValue( _element );
+	}
+	
+	virtual bool onXmlElementEnd( const karmaXmlElement& _element ){
+		if( _element.getDepth() == 0 ) return true;
+		if( bUnknownType ){
+			if( _element.getDepth() == 1 ) bUnknownType = false;
+			return true;
+		}
+		
+		// no shapeType, default to basicShape
+		if( _element.getDepth() == 1 && currentShape == nullptr ){
+			createShape("basicShape");
+			if( currentShape == nullptr ) return true;
+		}
+		
+		if( bFailed || !shapeReader.onXmlElementEnd( _element ) ) return false;
+		if( _element.getDepth() == 1 ){
+			shapes.push_back( currentShape );
+			currentShape = nullptr;
+		}
+		return true;
+	}
+	
+	list<basicShape*> shapes;
+
+private:
+	void createShape( const string& _shapeType ){
+		// Some code comes from:
+		// --> http://stackoverflow.com/questions/8269465/how-can-i-instantiate-an-object-knowing-only-its-name
+		currentShape = shape::create(_shapeType, basicPoint(0,0) );
+		if( currentShape == nullptr ){
+			// unknow shape type, skip it
+			ofLogError("basicShape* shape::create") << "Shapetype not found: " << _shapeType;
+			bUnknownType = true;
+			return;
+		}
+		// the shape stopped parsing, fails on the next element end
+		if( !shapeReader.setTarget( currentShape ) ) bFailed = true;
+	}
+	
+	basicShape* currentShape; // being read
+	bool bUnknownType;
+	bool bFailed;
+	karmaXmlForwarder shapeReader;
+};
+
 // - - - - - - - -
 // CONSTRUCTORS
 // - - - - - - - -
@@ -67,6 +144,7 @@ string shapesScene::getLoadedScene() const {
 basicShape* shapesScene::insertShape(basicShape* _shape){
 	// add shape to stage
 	shapes.push_back(_shape);
+	onShapeInserted(_shape);
 	
 	// on fail, inform user
 	//ofLogError("shapesScene::insertShape() failed to instantiate a new shape of type `"+_type+"`.\nYou have no choice but to accept this fact by clicking OK.");
@@ -80,6 +158,7 @@ bool shapesScene::removeShape(basicShape *_shape){
 		
 	for(list<basicShape*>::iterator it = shapes.begin(); it != shapes.end(); it++){
 		if(_shape==*it){
+			onShapeRemoved(_shape);
 			shapes.erase(it);
                         return true;
 		}
@@ -121,36 +200,52 @@ bool shapesScene::saveScene(const string& _fileName){
 	}
 	else fullPath = _fileName;
 	
-	ofxXmlSettings sceneXML;
-	sceneXML.addTag("shapes");
-	sceneXML.pushTag("shapes");
+	// binary scene ?
+	if( ofFilePath::getFileExt(fullPath) == KM_BINARY_SCENE_EXTENSION ){
+		if( !shapesBinaryScene::save( shapes, fullPath ) ){
+			ofSystemAlertDialog("Could not save the current configuration...\nSave File: "+fullPath);
+			return false;
+		}
+		return true;
+	}
+	
+	// write down settings to disk
+	vector<int> failed;
+	if( writeXMLScene(fullPath, failed) ){
+		if(failed.size() == 0 ) ofLogNotice("shapesScene::saveScene()", "Saved current configuration to `"+fullPath+"`");
+		else ofSystemAlertDialog("The scene has been saved but "+ ofToString(failed.size()) +" out of "+ ofToString(shapes.size()) +" shapes failed to save.");
+	}
+	else ofSystemAlertDialog("Could not save the current configuration...\nSave File: "+fullPath);
+	
+	return true; // todo: this should be conditional
+}
+
+// streamed to disk, shape by shape
+bool shapesScene::writeXMLScene( const string& _path, vector<int>& _failed ){
+	karmaXmlWriter sceneXML;
+	if( !sceneXML.open(_path) ) return false;
+	
+	sceneXML.beginElement("shapes");
 	
 	// save all shapes data
 	int s=0;
-	vector<int> failed;
-	failed.clear();
+	_failed.clear();
 	for(auto it = shapes.begin(); it != shapes.end(); it++, s++){
 		
-		sceneXML.addTag("shape");
-		sceneXML.pushTag("shape", s);
+		sceneXML.beginElement("shape");
 		
-		if(!(*it)->saveToXML(sceneXML)) failed.push_back(s);
+		if(!(*it)->saveToXMLStream(sceneXML)) _failed.push_back(s);
 		
-		sceneXML.popTag(); //pop shape
+		sceneXML.endElement(); // shape
 	}
 	
-	// write down settings to disk
-	if( sceneXML.saveFile(fullPath) ){
-		if(failed.size() == 0 ) ofLogNotice("shapesScene::saveScene()", "Saved current configuration to `"+fullPath+"`");
-		else ofSystemAlertDialog("The scene has been saved but "+ ofToString(failed.size()) +" out of "+ ofToString(shapes.size()) +" shapes failed to save.");
-	}
-	else ofSystemAlertDialog("Could not save the current configuration...\nSave File: "+fullPath);
+	sceneXML.endElement(); // shapes
 	
-	return true; // todo: this should be conditional
+	return sceneXML.close();
 }
 
-// (re)loads a scene from file
-bool shapesScene::loadScene( const string& _fileName ){
+// (re)loads a scene from file, xml or binary
+bool shapesScene::loadScene( const string& _fileName, bool _remember ){
 	
 	string fullPath;
 	
@@ -161,63 +256,102 @@ bool shapesScene::loadScene( const string& _fileName ){
 	}
 	else fullPath = ofToDataPath( _fileName );
 	
-	ofxXmlSettings sceneXML;
-	
 	// can we read the file ?
-	if( sceneXML.loadFile(fullPath) ){
+	if( readSceneFile(fullPath) ){
 		
-		unloadShapes();
+		ofLogNotice("shapesScene::loadScene") << "Loaded scene from " << fullPath << " [" << shapes.size() << " shapes]";
 		
-		sceneXML.pushTag("shapes");
+		loadedConfiguration = _fileName;
+		if( _remember ) rememberLoadedScene();
+		
+		return true;
+	}
+	else{
+		ofLogError("shapesScene::loadShapes()", "Loading from `"+fullPath+"` failed!");
+		return false;
+	}
+}
+
+// saves the loaded scene as the last used one, main thread
+void shapesScene::rememberLoadedScene() const {
+	ofxXmlSettings sceneSettings;
+	sceneSettings.load( KM_SCENE_SAVE_FILE );
+	sceneSettings.setValue("sceneSettings:lastLoadedScene", loadedConfiguration);
+	
+	if(!sceneSettings.saveFile(KM_SCENE_SAVE_FILE)) ofLogError("shapesScene::saveScene") << "Failed saving global settings...";
+}
+
+// converts between xml and binary scenes, depending on the file extensions
+bool shapesScene::convertScene( const string& _from, const string& _to, bool _quantized ){
+	shapesScene scene;
+	if( !scene.readSceneFile( ofToDataPath(_from) ) ){
+		ofLogError("shapesScene::convertScene") << "Could not read " << _from;
+		return false;
+	}
+	
+	if( ofFilePath::getFileExt(_to) == KM_BINARY_SCENE_EXTENSION ){
+		return shapesBinaryScene::save( scene.shapes, _to, _quantized );
+	}
+	vector<int> failed;
+	return scene.writeXMLScene( _to, failed ) && failed.size()==0;
+}
+
+// replaces the current shapes, without remembering the file
+bool shapesScene::readSceneFile( const string& _fullPath ){
+	if( shapesBinaryScene::isBinaryScene(_fullPath) ){
+		shapesBinaryScene sceneFile;
+		if( !sceneFile.open(_fullPath) ) return false;
 		
-		// loop for each shape
-		int numShapes = sceneXML.getNumTags("shape");
-		shapes.clear();
-		//shapes.resize(numShapes);
+		unloadShapes();
 		
-		for(int s=0; s<numShapes; s++){
-			sceneXML.pushTag("shape", s);
-			
-			// Some code comes from:
-			// --> http://stackoverflow.com/questions/8269465/how-can-i-instantiate-an-object-knowing-only-its-name
-			string shapeType = sceneXML.getValue("shapeType", "basicShape");
+		for(unsigned int s=0; s<sceneFile.getNumShapes(); ++s){
+			string shapeType = sceneFile.getString( sceneFile.getShape(s).type );
 			basicShape* shape = shape::create(shapeType, basicPoint(0,0) );
 			if( shape != nullptr ){
 				shapes.push_back( shape );
-				shapes.back()->loadFromXML( sceneXML );
+				shapes.back()->loadFromBinary( sceneFile, s );
+				onShapeInserted( shape );
 			}
 			else {
 				// unknow shape type
 				ofLogError("basicShape* shape::create") << "Shapetype not found: " << shapeType;
 			}
-			
-			sceneXML.popTag(); // pop shape
 		}
-		
-		ofLogNotice("shapesScene::loadScene") << "Loaded scene from " << fullPath << " [" << numShapes << " shapes]";
-		
-		// remember this scene
-		loadedConfiguration = _fileName;
-		ofxXmlSettings sceneSettings;
-		sceneSettings.load( KM_SCENE_SAVE_FILE );
-		sceneSettings.setValue("sceneSettings:lastLoadedScene", _fileName);
-		
-		if(!sceneSettings.saveFile(KM_SCENE_SAVE_FILE)) ofLogError("shapesScene::saveScene") << "Failed saving global settings...";
-		
 		return true;
 	}
-	else{
-		ofLogError("shapesScene::loadShapes()", "Loading from `"+fullPath+"` failed!");
+	
+	// xml, streamed
+	karmaXmlReader reader;
+	shapesSceneXmlReader sceneReader;
+	if( !reader.open(_fullPath) ) return false;
+	if( !reader.parse( sceneReader ) ){
+		ofLogError("shapesScene::readSceneFile") << _fullPath << ": " << reader.getError();
 		return false;
 	}
+	
+	unloadShapes();
+	
+	for(auto it=sceneReader.shapes.begin(); it!=sceneReader.shapes.end(); ++it){
+		shapes.push_back( *it );
+		onShapeInserted( *it );
+	}
+	sceneReader.shapes.clear();
+	
+	return true;
 }
 
 
+void shapesScene::swapScene( shapesScene& _other ){
+	shapes.swap( _other.shapes );
+	loadedConfiguration.swap( _other.loadedConfiguration );
+}
+
 bool shapesScene::unloadShapes(){
 	
 	// dump'em all! :D
 	while( shapes.size() > 0 ){
 		auto it = shapes.begin();
+		onShapeRemoved(*it);
 		delete (*it);
 		shapes.erase( it );
 	}
@@ -41,8 +41,12 @@ public:
 	basicShape* insertShape(basicShape* _shape);
 	bool removeShape(basicShape* _shape);
 	bool shapeExists(const basicShape* i) const;
+	// .kmscene files are saved and loaded as binary scenes, others as xml
 	bool saveScene( const string& _fileName = "" );
-	bool loadScene( const string& _fileName = "" );
+	// _remember also saves it as the last used scene, only from the main thread
+	bool loadScene( const string& _fileName = "", bool _remember = true );
+	void rememberLoadedScene() const;
+	static bool convertScene( const string& _from, const string& _to, bool _quantized = false );
 	bool unloadShapes();
 	
 	// utilities
@@ -53,8 +57,16 @@ public:
 protected:
 	// Note: vectors are uncompatible as they invalidate pointers
 	list<basicShape*> shapes;
+	
+	// called when shapes enter or leave the scene (removed ones are deleted right after)
+	virtual void onShapeInserted( basicShape* _shape ){}
+	virtual void onShapeRemoved( basicShape* _shape ){}
+	// exchanges the shapes and the scene file with _other, without notifications
+	void swapScene( shapesScene& _other );
 
 private:
+	bool readSceneFile( const string& _fullPath );
+	bool writeXMLScene( const string& _path, vector<int>& _failed );
 	
 	string loadedConfiguration;
 };
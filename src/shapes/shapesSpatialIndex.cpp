@@ -0,0 +1,240 @@
+//
+//  shapesSpatialIndex.cpp
+//  karmaMapper
+//
+
+#include "shapesSpatialIndex.h"
+#include <unordered_set>
+
+// - - - - - - - -
+// CONSTRUCTORS
+// - - - - - - - -
+shapesSpatialIndex::shapesSpatialIndex( float _cellSize ) : cellSize( MAX(1.f, _cellSize) ), nextOrder(0) {
+
+}
+
+// - - - - - - - -
+// CONTENTS
+// - - - - - - - -
+void shapesSpatialIndex::insert( basicShape* _shape ){
+	if( _shape == nullptr || entries.find(_shape) != entries.end() ) return;
+	
+	entry& e = entries[_shape];
+	e.order = nextOrder++;
+	e.box = _shape->getBoundingBox();
+	bin( _shape, e );
+}
+
+void shapesSpatialIndex::remove( basicShape* _shape ){
+	auto it = entries.find( _shape );
+	if( it == entries.end() ) return;
+	
+	unbin( _shape, it->second );
+	if( it->second.bDirty ) dirtyShapes.erase( std::remove( dirtyShapes.begin(), dirtyShapes.end(), _shape ), dirtyShapes.end() );
+	entries.erase( it );
+}
+
+void shapesSpatialIndex::clear(){
+	entries.clear();
+	cells.clear();
+	largeShapes.clear();
+	dirtyShapes.clear();
+	occupied = cellRange();
+	nextOrder = 0;
+}
+
+void shapesSpatialIndex::markDirty( basicShape* _shape ){
+	auto it = entries.find( _shape );
+	if( it == entries.end() || it->second.bDirty ) return;
+	
+	it->second.bDirty = true;
+	dirtyShapes.push_back( _shape );
+}
+
+void shapesSpatialIndex::update(){
+	for(auto it=dirtyShapes.begin(); it!=dirtyShapes.end(); ++it){
+		entry& e = entries.at(*it);
+		e.bDirty = false;
+		
+		const ofRectangle& box = (*it)->getBoundingBox();
+		if( box.x==e.box.x && box.y==e.box.y && box.width==e.box.width && box.height==e.box.height ) continue;
+		
+		// same cells ? Only the box changes.
+		cellRange range = getCells( box );
+		bool bLarge = range.getNumCells() > KM_SPATIAL_INDEX_MAX_CELLS;
+		if( (bLarge && e.cells.isEmpty()) || (range.x0==e.cells.x0 && range.y0==e.cells.y0 && range.x1==e.cells.x1 && range.y1==e.cells.y1) ){
+			e.box = box;
+			continue;
+		}
+		
+		unbin( *it, e );
+		e.box = box;
+		bin( *it, e );
+	}
+	dirtyShapes.clear();
+}
+
+// - - - - - - - -
+// QUERIES
+// - - - - - - - -
+basicShape* shapesSpatialIndex::getShapeAt( const ofVec2f& _pos ) const {
+	basicShape* topmost = nullptr;
+	unsigned int topOrder = 0;
+	
+	cellRange range = getCells( ofRectangle(_pos.x, _pos.y, 0, 0) );
+	forEachCandidate( range, [&]( basicShape* _shape, const entry& _entry ){
+		if( topmost != nullptr && _entry.order < topOrder ) return;
+		if( !_entry.box.inside(_pos) || !_shape->isInside(_pos) ) return;
+		
+		topmost = _shape;
+		topOrder = _entry.order;
+	});
+	return topmost;
+}
+
+void shapesSpatialIndex::getShapesAt( const ofVec2f& _pos, vector<basicShape*>& _result ) const {
+	_result.clear();
+	
+	cellRange range = getCells( ofRectangle(_pos.x, _pos.y, 0, 0) );
+	forEachCandidate( range, [&]( basicShape* _shape, const entry& _entry ){
+		if( _entry.box.inside(_pos) && _shape->isInside(_pos) ) _result.push_back( _shape );
+	});
+}
+
+void shapesSpatialIndex::getShapesInRect( const ofRectangle& _rect, vector<basicShape*>& _result, bool _fullyInside ) const {
+	_result.clear();
+	
+	ofRectangle rect = _rect.getStandardized();
+	forEachCandidate( getCells(rect), [&]( basicShape* _shape, const entry& _entry ){
+		const ofRectangle& b = _entry.box;
+		if( _fullyInside ){
+			if( b.x >= rect.x && b.y >= rect.y && b.x+b.width <= rect.x+rect.width && b.y+b.height <= rect.y+rect.height ) _result.push_back( _shape );
+		}
+		else if( b.x <= rect.x+rect.width && rect.x <= b.x+b.width && b.y <= rect.y+rect.height && rect.y <= b.y+b.height ){
+			_result.push_back( _shape );
+		}
+	});
+}
+
+// searches rings of cells around _pos until nothing closer can be found
+void shapesSpatialIndex::getNearestShapes( const ofVec2f& _pos, unsigned int _count, vector<basicShape*>& _result ) const {
+	_result.clear();
+	if( _count == 0 || entries.empty() ) return;
+	
+	// local, concurrent queries can't share buffers
+	vector< pair<float, basicShape*> > nearest;
+	unordered_set<basicShape*> visited; // shapes spanning several cells
+	auto addCandidate = [&]( basicShape* _shape, const entry& _entry ){
+		if( !visited.insert(_shape).second ) return;
+		nearest.push_back( make_pair( getDistance(_entry.box, _pos), _shape ) );
+	};
+	
+	visitLargeShapes( addCandidate );
+	
+	int cx = floor( _pos.x / cellSize );
+	int cy = floor( _pos.y / cellSize );
+	int maxRing = MAX( MAX( abs(cx-occupied.x0), abs(occupied.x1-cx) ), MAX( abs(cy-occupied.y0), abs(occupied.y1-cy) ) );
+	if( occupied.isEmpty() ) maxRing = -1;
+	
+	for(int ring=0; ring<=maxRing; ++ring){
+		for(int x=cx-ring; x<=cx+ring; ++x){
+			visitCell( x, cy-ring, addCandidate );
+			if( ring > 0 ) visitCell( x, cy+ring, addCandidate );
+		}
+		for(int y=cy-ring+1; y<=cy+ring-1; ++y){
+			visitCell( cx-ring, y, addCandidate );
+			visitCell( cx+ring, y, addCandidate );
+		}
+		
+		// unvisited cells are at least this far away
+		if( nearest.size() >= _count ){
+			float reach = ring * cellSize + MIN( MIN( _pos.x - cx*cellSize, (cx+1)*cellSize - _pos.x ), MIN( _pos.y - cy*cellSize, (cy+1)*cellSize - _pos.y ) );
+			nth_element( nearest.begin(), nearest.begin()+_count-1, nearest.end() );
+			if( nearest[_count-1].first <= reach ) break;
+		}
+	}
+	
+	unsigned int numResults = MIN( _count, (unsigned int) nearest.size() );
+	partial_sort( nearest.begin(), nearest.begin()+numResults, nearest.end() );
+	for(unsigned int i=0; i<numResults; ++i){
+		_result.push_back( nearest[i].second );
+	}
+}
+
+unsigned int shapesSpatialIndex::getNumShapes() const {
+	return entries.size();
+}
+
+// - - - - - - - -
+// INTERNALS
+// - - - - - - - -
+shapesSpatialIndex::cellRange shapesSpatialIndex::getCells( const ofRectangle& _box ) const {
+	ofRectangle box = _box.getStandardized();
+	cellRange range;
+	range.x0 = floor( box.x / cellSize );
+	range.y0 = floor( box.y / cellSize );
+	range.x1 = floor( (box.x+box.width) / cellSize );
+	range.y1 = floor( (box.y+box.height) / cellSize );
+	return range;
+}
+
+void shapesSpatialIndex::bin( basicShape* _shape, entry& _entry ){
+	cellRange range = getCells( _entry.box );
+	
+	if( range.getNumCells() > KM_SPATIAL_INDEX_MAX_CELLS ){
+		_entry.cells = cellRange();
+		largeShapes.push_back( _shape );
+		return;
+	}
+	
+	_entry.cells = range;
+	for(int y=range.y0; y<=range.y1; ++y){
+		for(int x=range.x0; x<=range.x1; ++x){
+			cells[ getCellKey(x, y) ].push_back( _shape );
+		}
+	}
+	
+	// occupied cells only grow, clear() resets them
+	if( occupied.isEmpty() ){
+		occupied = range;
+	}
+	else {
+		occupied.x0 = MIN( occupied.x0, range.x0 );
+		occupied.y0 = MIN( occupied.y0, range.y0 );
+		occupied.x1 = MAX( occupied.x1, range.x1 );
+		occupied.y1 = MAX( occupied.y1, range.y1 );
+	}
+}
+
+void shapesSpatialIndex::unbin( basicShape* _shape, entry& _entry ){
+	if( _entry.cells.isEmpty() ){
+		largeShapes.erase( std::remove( largeShapes.begin(), largeShapes.end(), _shape ), largeShapes.end() );
+		return;
+	}
+	
+	for(int y=_entry.cells.y0; y<=_entry.cells.y1; ++y){
+		for(int x=_entry.cells.x0; x<=_entry.cells.x1; ++x){
+			auto cell = cells.find( getCellKey(x, y) );
+			if( cell == cells.end() ) continue;
+			
+			vector<basicShape*>& list = cell->second;
+			auto it = std::find( list.begin(), list.end(), _shape );
+			if( it != list.end() ){
+				*it = list.back();
+				list.pop_back();
+			}
+			if( list.empty() ) cells.erase( cell );
+		}
+	}
+	_entry.cells = cellRange();
+}
+
+uint64_t shapesSpatialIndex::getCellKey( int _x, int _y ){
+	return ( (uint64_t)(uint32_t)_x << 32 ) | (uint32_t)_y;
+}
+
+float shapesSpatialIndex::getDistance( const ofRectangle& _box, const ofVec2f& _pos ){
+	float dx = MAX( MAX( _box.x - _pos.x, 0.f ), _pos.x - (_box.x+_box.width) );
+	float dy = MAX( MAX( _box.y - _pos.y, 0.f ), _pos.y - (_box.y+_box.height) );
+	return sqrt( dx*dx + dy*dy );
+}
@@ -0,0 +1,116 @@
+//
+//  shapesSpatialIndex.h
+//  karmaMapper
+//
+//	Uniform grid over the shapes' bounding boxes, for picking and region queries.
+//	Point queries do a real inside test (see basicShape::isInside()), rectangle queries test bounding boxes.
+//	Moved shapes get marked dirty, update() re-bins only those. Call it from the thread editing the shapes (once per frame in the animator).
+//	Rectangle and nearest queries don't alter the index, several threads can run them as long as nobody updates it meanwhile.
+//	Point queries read the shapes' live vertices, only run them where nothing alters the shapes.
+//
+
+#pragma once
+
+#include "ofMain.h"
+#include "basicShape.h"
+
+// grid cell size in pixels
+#define KM_SPATIAL_INDEX_CELL_SIZE 64.f
+// shapes covering more cells are kept aside and always tested
+#define KM_SPATIAL_INDEX_MAX_CELLS 256
+
+class shapesSpatialIndex {
+public:
+	shapesSpatialIndex( float _cellSize = KM_SPATIAL_INDEX_CELL_SIZE );
+	
+	void insert( basicShape* _shape );
+	void remove( basicShape* _shape );
+	void clear();
+	
+	// the shape's bounding box changed, re-bin it on the next update()
+	void markDirty( basicShape* _shape );
+	// re-bins the dirty shapes
+	void update();
+	
+	// topmost shape (last inserted) containing _pos, nullptr if none
+	basicShape* getShapeAt( const ofVec2f& _pos ) const;
+	void getShapesAt( const ofVec2f& _pos, vector<basicShape*>& _result ) const;
+	void getShapesInRect( const ofRectangle& _rect, vector<basicShape*>& _result, bool _fullyInside = false ) const;
+	// sorted by distance to their bounding box
+	void getNearestShapes( const ofVec2f& _pos, unsigned int _count, vector<basicShape*>& _result ) const;
+	
+	unsigned int getNumShapes() const;
+
+private:
+	struct cellRange {
+		int x0 = 0, y0 = 0, x1 = -1, y1 = -1;
+		bool isEmpty() const { return x1 < x0 || y1 < y0; }
+		unsigned int getNumCells() const { return isEmpty() ? 0 : (x1-x0+1)*(y1-y0+1); }
+	};
+	
+	struct entry {
+		ofRectangle box;
+		cellRange cells; // empty when kept in largeShapes
+		unsigned int order = 0; // insertion order, higher is on top
+		bool bDirty = false;
+	};
+	
+	cellRange getCells( const ofRectangle& _box ) const;
+	void bin( basicShape* _shape, entry& _entry );
+	void unbin( basicShape* _shape, entry& _entry );
+	static uint64_t getCellKey( int _x, int _y );
+	static float getDistance( const ofRectangle& _box, const ofVec2f& _pos );
+	
+	// calls _f(shape, entry) once per candidate shape in the range
+	template<typename F>
+	void forEachCandidate( const cellRange& _range, F _f ) const;
+	// calls _f(shape, entry) for all shapes in the cell, shapes spanning several cells come several times
+	template<typename F>
+	void visitCell( int _x, int _y, F& _f ) const;
+	template<typename F>
+	void visitLargeShapes( F& _f ) const;
+	
+	float cellSize;
+	unordered_map<basicShape*, entry> entries;
+	unordered_map<uint64_t, vector<basicShape*> > cells;
+	vector<basicShape*> largeShapes;
+	vector<basicShape*> dirtyShapes;
+	cellRange occupied; // cells with shapes, bounds the nearest search
+	unsigned int nextOrder;
+};
+
+template<typename F>
+void shapesSpatialIndex::forEachCandidate( const cellRange& _range, F _f ) const {
+	visitLargeShapes( _f );
+	
+	// only where there are shapes
+	int x0 = MAX( _range.x0, occupied.x0 ), x1 = MIN( _range.x1, occupied.x1 );
+	int y0 = MAX( _range.y0, occupied.y0 ), y1 = MIN( _range.y1, occupied.y1 );
+	for(int y=y0; y<=y1; ++y){
+		for(int x=x0; x<=x1; ++x){
+			auto visitOnce = [&]( basicShape* _shape, const entry& _entry ){
+				// shapes spanning several cells are visited from the first cell they share with the range
+				if( x != MAX(_entry.cells.x0, x0) || y != MAX(_entry.cells.y0, y0) ) return;
+				_f( _shape, _entry );
+			};
+			visitCell( x, y, visitOnce );
+		}
+	}
+}
+
+template<typename F>
+void shapesSpatialIndex::visitCell( int _x, int _y, F& _f ) const {
+	auto cell = cells.find( getCellKey(_x, _y) );
+	if( cell == cells.end() ) return;
+	
+	for(auto it=cell->second.cbegin(); it!=cell->second.cend(); ++it){
+		_f( *it, entries.at(*it) );
+	}
+}
+
+template<typename F>
+void shapesSpatialIndex::visitLargeShapes( F& _f ) const {
+	for(auto it=largeShapes.cbegin(); it!=largeShapes.cend(); ++it){
+		_f( *it, entries.at(*it) );
+	}
+}
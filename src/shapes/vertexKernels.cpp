@@ -0,0 +1,163 @@
+//
+//  vertexKernels.cpp
+//  karmaMapper
+//
+
+#include "vertexKernels.h"
+#include "vertexSimd.h"
+
+// - - - - - - - -
+// KERNELS
+// - - - - - - - -
+void vertexKernels::translate( const float* _srcX, const float* _srcY, float* _dstX, float* _dstY, unsigned int _size, float _offsetX, float _offsetY ){
+	unsigned int i = 0;
+
+#if defined(KM_SIMD_AVX)
+	__m256 offsetX = _mm256_set1_ps( _offsetX );
+	__m256 offsetY = _mm256_set1_ps( _offsetY );
+	for(; i+8<=_size; i+=8){
+		_mm256_storeu_ps( _dstX+i, _mm256_add_ps( _mm256_loadu_ps(_srcX+i), offsetX ) );
+		_mm256_storeu_ps( _dstY+i, _mm256_add_ps( _mm256_loadu_ps(_srcY+i), offsetY ) );
+	}
+#elif defined(KM_SIMD_SSE)
+	__m128 offsetX = _mm_set1_ps( _offsetX );
+	__m128 offsetY = _mm_set1_ps( _offsetY );
+	for(; i+4<=_size; i+=4){
+		_mm_storeu_ps( _dstX+i, _mm_add_ps( _mm_loadu_ps(_srcX+i), offsetX ) );
+		_mm_storeu_ps( _dstY+i, _mm_add_ps( _mm_loadu_ps(_srcY+i), offsetY ) );
+	}
+#elif defined(KM_SIMD_NEON)
+	float32x4_t offsetX = vdupq_n_f32( _offsetX );
+	float32x4_t offsetY = vdupq_n_f32( _offsetY );
+	for(; i+4<=_size; i+=4){
+		vst1q_f32( _dstX+i, vaddq_f32( vld1q_f32(_srcX+i), offsetX ) );
+		vst1q_f32( _dstY+i, vaddq_f32( vld1q_f32(_srcY+i), offsetY ) );
+	}
+#endif
+	
+	// remainder
+	for(; i<_size; ++i){
+		_dstX[i] = _srcX[i] + _offsetX;
+		_dstY[i] = _srcY[i] + _offsetY;
+	}
+}
+
+bool vertexKernels::getBounds( const float* _x, const float* _y, unsigned int _size, ofRectangle& _bounds ){
+	if( _size == 0 ) return false;
+	
+	float minX = _x[0], minY = _y[0], maxX = _x[0], maxY = _y[0];
+	unsigned int i = 0;
+
+#if defined(KM_SIMD_AVX)
+	if( _size >= 8 ){
+		__m256 vMinX = _mm256_loadu_ps(_x), vMaxX = vMinX;
+		__m256 vMinY = _mm256_loadu_ps(_y), vMaxY = vMinY;
+		for(i=8; i+8<=_size; i+=8){
+			__m256 x = _mm256_loadu_ps(_x+i);
+			__m256 y = _mm256_loadu_ps(_y+i);
+			vMinX = _mm256_min_ps( vMinX, x );
+			vMaxX = _mm256_max_ps( vMaxX, x );
+			vMinY = _mm256_min_ps( vMinY, y );
+			vMaxY = _mm256_max_ps( vMaxY, y );
+		}
+		float lanes[4][8];
+		_mm256_storeu_ps( lanes[0], vMinX );
+		_mm256_storeu_ps( lanes[1], vMaxX );
+		_mm256_storeu_ps( lanes[2], vMinY );
+		_mm256_storeu_ps( lanes[3], vMaxY );
+		for(unsigned int l=0; l<8; ++l){
+			minX = MIN( minX, lanes[0][l] );
+			maxX = MAX( maxX, lanes[1][l] );
+			minY = MIN( minY, lanes[2][l] );
+			maxY = MAX( maxY, lanes[3][l] );
+		}
+	}
+#elif defined(KM_SIMD_SSE)
+	if( _size >= 4 ){
+		__m128 vMinX = _mm_loadu_ps(_x), vMaxX = vMinX;
+		__m128 vMinY = _mm_loadu_ps(_y), vMaxY = vMinY;
+		for(i=4; i+4<=_size; i+=4){
+			__m128 x = _mm_loadu_ps(_x+i);
+			__m128 y = _mm_loadu_ps(_y+i);
+			vMinX = _mm_min_ps( vMinX, x );
+			vMaxX = _mm_max_ps( vMaxX, x );
+			vMinY = _mm_min_ps( vMinY, y );
+			vMaxY = _mm_max_ps( vMaxY, y );
+		}
+		float lanes[4][4];
+		_mm_storeu_ps( lanes[0], vMinX );
+		_mm_storeu_ps( lanes[1], vMaxX );
+		_mm_storeu_ps( lanes[2], vMinY );
+		_mm_storeu_ps( lanes[3], vMaxY );
+		for(unsigned int l=0; l<4; ++l){
+			minX = MIN( minX, lanes[0][l] );
+			maxX = MAX( maxX, lanes[1][l] );
+			minY = MIN( minY, lanes[2][l] );
+			maxY = MAX( maxY, lanes[3][l] );
+		}
+	}
+#elif defined(KM_SIMD_NEON)
+	if( _size >= 4 ){
+		float32x4_t vMinX = vld1q_f32(_x), vMaxX = vMinX;
+		float32x4_t vMinY = vld1q_f32(_y), vMaxY = vMinY;
+		for(i=4; i+4<=_size; i+=4){
+			float32x4_t x = vld1q_f32(_x+i);
+			float32x4_t y = vld1q_f32(_y+i);
+			vMinX = vminq_f32( vMinX, x );
+			vMaxX = vmaxq_f32( vMaxX, x );
+			vMinY = vminq_f32( vMinY, y );
+			vMaxY = vmaxq_f32( vMaxY, y );
+		}
+		float lanes[4][4];
+		vst1q_f32( lanes[0], vMinX );
+		vst1q_f32( lanes[1], vMaxX );
+		vst1q_f32( lanes[2], vMinY );
+		vst1q_f32( lanes[3], vMaxY );
+		for(unsigned int l=0; l<4; ++l){
+			minX = MIN( minX, lanes[0][l] );
+			maxX = MAX( maxX, lanes[1][l] );
+			minY = MIN( minY, lanes[2][l] );
+			maxY = MAX( maxY, lanes[3][l] );
+		}
+	}
+#endif
+	
+	// remainder
+	for(; i<_size; ++i){
+		minX = MIN( minX, _x[i] );
+		maxX = MAX( maxX, _x[i] );
+		minY = MIN( minY, _y[i] );
+		maxY = MAX( maxY, _y[i] );
+	}
+	
+	_bounds.set( minX, minY, maxX-minX, maxY-minY );
+	return true;
+}
+
+bool vertexKernels::getBounds( const vector<ofRectangle>& _boxes, ofRectangle& _bounds ){
+	if( _boxes.empty() ) return false;
+	
+	float minX = _boxes[0].x, minY = _boxes[0].y;
+	float maxX = _boxes[0].x+_boxes[0].width, maxY = _boxes[0].y+_boxes[0].height;
+	for(auto it=_boxes.cbegin()+1; it!=_boxes.cend(); ++it){
+		minX = MIN( minX, it->x );
+		minY = MIN( minY, it->y );
+		maxX = MAX( maxX, it->x+it->width );
+		maxY = MAX( maxY, it->y+it->height );
+	}
+	
+	_bounds.set( minX, minY, maxX-minX, maxY-minY );
+	return true;
+}
+
+const char* vertexKernels::getInstructionSet(){
+#if defined(KM_SIMD_AVX)
+	return "AVX";
+#elif defined(KM_SIMD_SSE)
+	return "SSE2";
+#elif defined(KM_SIMD_NEON)
+	return "NEON";
+#else
+	return "scalar";
+#endif
+}
@@ -0,0 +1,25 @@
+//
+//  vertexKernels.h
+//  karmaMapper
+//
+//	Vectorized loops over x[] / y[] vertex arrays (see vertexPool.h).
+//	Uses AVX, SSE2 or NEON depending on what the compiler targets, scalar code otherwise.
+//
+
+#pragma once
+
+#include "ofMain.h"
+
+class vertexKernels {
+public:
+	// _dst = _src + _offset, arrays may be the same
+	static void translate( const float* _srcX, const float* _srcY, float* _dstX, float* _dstY, unsigned int _size, float _offsetX, float _offsetY );
+	
+	// axis aligned bounding box, returns false if there are no vertices
+	static bool getBounds( const float* _x, const float* _y, unsigned int _size, ofRectangle& _bounds );
+	
+	// union of boxes, returns false if empty
+	static bool getBounds( const vector<ofRectangle>& _boxes, ofRectangle& _bounds );
+	
+	static const char* getInstructionSet();
+};
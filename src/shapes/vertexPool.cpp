@@ -0,0 +1,138 @@
+//
+//  vertexPool.cpp
+//  karmaMapper
+//
+
+#include "vertexPool.h"
+
+// - - - - - - - -
+// CONSTRUCTORS
+// - - - - - - - -
+vertexPool::vertexPool() : numVertices(0) {
+
+}
+
+vertexPool& vertexPool::getInstance(){
+	static vertexPool instance;
+	return instance;
+}
+
+// - - - - - - - -
+// BLOCKS
+// - - - - - - - -
+vertexBlock vertexPool::allocate( unsigned int _size ){
+	vertexBlock block;
+	if( _size == 0 ) return block;
+	
+	ofScopedLock lock(mutex);
+	
+	// first fit
+	for(unsigned int i=0; i<pages.size(); ++i){
+		if( allocateInPage(i, _size, block) ){
+			numVertices += _size;
+			return block;
+		}
+	}
+	
+	// new page, re-using emptied slots
+	unsigned int capacity = MAX( _size, (unsigned int) KM_VERTEX_POOL_PAGE_SIZE );
+	unsigned int index = pages.size();
+	for(unsigned int i=0; i<pages.size(); ++i){
+		if( pages[i]->x.empty() ){
+			index = i;
+			break;
+		}
+	}
+	if( index == pages.size() ) pages.emplace_back( new page() );
+	
+	page& p = *pages[index];
+	p.x.assign( capacity, 0.f );
+	p.y.assign( capacity, 0.f );
+	p.freeRanges.clear();
+	p.freeRanges.push_back( make_pair(0u, capacity) );
+	
+	allocateInPage(index, _size, block);
+	numVertices += _size;
+	return block;
+}
+
+void vertexPool::release( vertexBlock& _block ){
+	if( _block.size == 0 ) return;
+	
+	ofScopedLock lock(mutex);
+	
+	page& p = *pages[_block.page];
+	numVertices -= _block.size;
+	
+	// insert sorted, then merge with neighbours
+	auto it = p.freeRanges.begin();
+	while( it!=p.freeRanges.end() && it->first < _block.offset ) ++it;
+	it = p.freeRanges.insert( it, make_pair(_block.offset, _block.size) );
+	
+	auto next = it+1;
+	if( next!=p.freeRanges.end() && it->first + it->second == next->first ){
+		it->second += next->second;
+		p.freeRanges.erase(next);
+	}
+	if( it!=p.freeRanges.begin() ){
+		auto prev = it-1;
+		if( prev->first + prev->second == it->first ){
+			prev->second += it->second;
+			p.freeRanges.erase(it);
+		}
+	}
+	
+	// give oversized pages back to the system once they're empty
+	if( p.x.size() > KM_VERTEX_POOL_PAGE_SIZE && p.freeRanges.size()==1 && p.freeRanges[0].second == p.x.size() ){
+		vector<float>().swap(p.x);
+		vector<float>().swap(p.y);
+		p.freeRanges.clear();
+	}
+	
+	_block = vertexBlock();
+}
+
+vertexSpan vertexPool::getSpan( const vertexBlock& _block, unsigned int _offset, unsigned int _size ){
+	if( _block.size == 0 || _offset+_size > _block.size ) return vertexSpan();
+	
+	ofScopedLock lock(mutex);
+	page& p = *pages[_block.page];
+	return vertexSpan( &p.x[_block.offset+_offset], &p.y[_block.offset+_offset], _size );
+}
+
+unsigned int vertexPool::getNumVertices() const {
+	ofScopedLock lock(mutex);
+	return numVertices;
+}
+
+unsigned int vertexPool::getCapacity() const {
+	ofScopedLock lock(mutex);
+	unsigned int capacity = 0;
+	for(auto it=pages.cbegin(); it!=pages.cend(); ++it){
+		capacity += (*it)->x.size();
+	}
+	return capacity;
+}
+
+// - - - - - - - -
+// INTERNALS
+// - - - - - - - -
+// mutex must be locked
+bool vertexPool::allocateInPage( unsigned int _page, unsigned int _size, vertexBlock& _block ){
+	page& p = *pages[_page];
+	
+	for(auto it=p.freeRanges.begin(); it!=p.freeRanges.end(); ++it){
+		if( it->second < _size ) continue;
+		
+		_block.page = _page;
+		_block.offset = it->first;
+		_block.size = _size;
+		
+		it->first += _size;
+		it->second -= _size;
+		if( it->second == 0 ) p.freeRanges.erase(it);
+		
+		return true;
+	}
+	return false;
+}
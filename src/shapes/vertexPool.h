@@ -0,0 +1,86 @@
+//
+//  vertexPool.h
+//  karmaMapper
+//
+//	Scene-wide vertex storage as separate x[] and y[] arrays (structure of arrays).
+//	Shapes get a contiguous block from a page and keep spans on it, so per-frame resets and deformations work on plain float arrays.
+//	Pages never move once allocated: spans stay valid until their block is released. Thread safe.
+//
+
+#pragma once
+
+#include "ofMain.h"
+#include "basicPoint.h"
+#include <cstring>
+
+// vertices per page, bigger blocks get a page of their own
+#define KM_VERTEX_POOL_PAGE_SIZE 65536
+
+// a run of vertices in the pool
+struct vertexBlock {
+	unsigned int page = 0;
+	unsigned int offset = 0;
+	unsigned int size = 0;
+};
+
+// read/write view on a run of vertices
+// don't keep it around, it's only valid until the shape gets edited
+struct vertexSpan {
+	vertexSpan() : x(nullptr), y(nullptr), size(0) {}
+	vertexSpan( float* _x, float* _y, unsigned int _size ) : x(_x), y(_y), size(_size) {}
+	
+	basicPoint operator[]( unsigned int _i ) const {
+		return basicPoint( x[_i], y[_i] );
+	}
+	
+	void set( unsigned int _i, const basicPoint& _p ){
+		x[_i] = _p.x;
+		y[_i] = _p.y;
+	}
+	
+	// spans need to have the same size
+	void copyFrom( const vertexSpan& _src ){
+		if( size == 0 ) return;
+		memcpy( x, _src.x, size*sizeof(float) );
+		memcpy( y, _src.y, size*sizeof(float) );
+	}
+	
+	bool empty() const {
+		return size == 0;
+	}
+	
+	float* x;
+	float* y;
+	unsigned int size;
+};
+
+class vertexPool {
+public:
+	static vertexPool& getInstance();
+	
+	vertexBlock allocate( unsigned int _size );
+	void release( vertexBlock& _block ); // resets the block
+	
+	// _offset and _size in vertices, relative to the block
+	vertexSpan getSpan( const vertexBlock& _block, unsigned int _offset, unsigned int _size );
+	
+	unsigned int getNumVertices() const; // in use
+	unsigned int getCapacity() const;
+
+private:
+	vertexPool();
+	vertexPool(const vertexPool&) = delete;
+	vertexPool& operator=(const vertexPool&) = delete;
+	
+	struct page {
+		vector<float> x;
+		vector<float> y;
+		vector< pair<unsigned int, unsigned int> > freeRanges; // offset, size. Sorted by offset.
+	};
+	
+	bool allocateInPage( unsigned int _page, unsigned int _size, vertexBlock& _block );
+	
+	vector< unique_ptr<page> > pages;
+	unsigned int numVertices;
+	mutable ofMutex mutex;
+};
@@ -0,0 +1,86 @@
+//
+//  vertexSimd.h
+//  karmaMapper
+//
+//	Picks the instruction set for the vertex kernels (AVX, SSE2, NEON or scalar) and wraps the few operations they share.
+//	Only include this in kernel translation units, it pulls in the intrinsics headers.
+//
+
+#pragma once
+
+#include <cmath>
+
+#if defined(__AVX__)
+	#include <immintrin.h>
+	#define KM_SIMD_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define KM_SIMD_SSE
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+	#include <arm_neon.h>
+	#define KM_SIMD_NEON
+#endif
+
+// - - - - - - - -
+// VECTOR TYPE
+// - - - - - - - -
+#if defined(KM_SIMD_AVX)
+	#define KM_SIMD_WIDTH 8
+	typedef __m256 kmFloatV;
+	inline kmFloatV kmSet( float _f ){ return _mm256_set1_ps(_f); }
+	inline kmFloatV kmLoad( const float* _p ){ return _mm256_loadu_ps(_p); }
+	inline void kmStore( float* _p, kmFloatV _v ){ _mm256_storeu_ps(_p, _v); }
+	inline kmFloatV kmAdd( kmFloatV _a, kmFloatV _b ){ return _mm256_add_ps(_a, _b); }
+	inline kmFloatV kmSub( kmFloatV _a, kmFloatV _b ){ return _mm256_sub_ps(_a, _b); }
+	inline kmFloatV kmMul( kmFloatV _a, kmFloatV _b ){ return _mm256_mul_ps(_a, _b); }
+	inline kmFloatV kmFloor( kmFloatV _v ){ return _mm256_floor_ps(_v); }
+	inline kmFloatV kmAbs( kmFloatV _v ){ return _mm256_andnot_ps(_mm256_set1_ps(-0.f), _v); }
+	inline kmFloatV kmRsqrt( kmFloatV _v ){ return _mm256_rsqrt_ps(_v); } // ~12 bits
+#elif defined(KM_SIMD_SSE)
+	#define KM_SIMD_WIDTH 4
+	typedef __m128 kmFloatV;
+	inline kmFloatV kmSet( float _f ){ return _mm_set1_ps(_f); }
+	inline kmFloatV kmLoad( const float* _p ){ return _mm_loadu_ps(_p); }
+	inline void kmStore( float* _p, kmFloatV _v ){ _mm_storeu_ps(_p, _v); }
+	inline kmFloatV kmAdd( kmFloatV _a, kmFloatV _b ){ return _mm_add_ps(_a, _b); }
+	inline kmFloatV kmSub( kmFloatV _a, kmFloatV _b ){ return _mm_sub_ps(_a, _b); }
+	inline kmFloatV kmMul( kmFloatV _a, kmFloatV _b ){ return _mm_mul_ps(_a, _b); }
+	// no _mm_floor_ps before SSE4.1: truncate, then step down where that rounded up
+	inline kmFloatV kmFloor( kmFloatV _v ){
+		kmFloatV t = _mm_cvtepi32_ps( _mm_cvttps_epi32(_v) );
+		return _mm_sub_ps( t, _mm_and_ps( _mm_cmpgt_ps(t, _v), _mm_set1_ps(1.f) ) );
+	}
+	inline kmFloatV kmAbs( kmFloatV _v ){ return _mm_andnot_ps(_mm_set1_ps(-0.f), _v); }
+	inline kmFloatV kmRsqrt( kmFloatV _v ){ return _mm_rsqrt_ps(_v); } // ~12 bits
+#elif defined(KM_SIMD_NEON)
+	#define KM_SIMD_WIDTH 4
+	typedef float32x4_t kmFloatV;
+	inline kmFloatV kmSet( float _f ){ return vdupq_n_f32(_f); }
+	inline kmFloatV kmLoad( const float* _p ){ return vld1q_f32(_p); }
+	inline void kmStore( float* _p, kmFloatV _v ){ vst1q_f32(_p, _v); }
+	inline kmFloatV kmAdd( kmFloatV _a, kmFloatV _b ){ return vaddq_f32(_a, _b); }
+	inline kmFloatV kmSub( kmFloatV _a, kmFloatV _b ){ return vsubq_f32(_a, _b); }
+	inline kmFloatV kmMul( kmFloatV _a, kmFloatV _b ){ return vmulq_f32(_a, _b); }
+	inline kmFloatV kmFloor( kmFloatV _v ){
+		kmFloatV t = vcvtq_f32_s32( vcvtq_s32_f32(_v) );
+		return vsubq_f32( t, vbslq_f32( vcgtq_f32(t, _v), vdupq_n_f32(1.f), vdupq_n_f32(0.f) ) );
+	}
+	inline kmFloatV kmAbs( kmFloatV _v ){ return vabsq_f32(_v); }
+	// estimate + one Newton step, the bare estimate is only 8 bits
+	inline kmFloatV kmRsqrt( kmFloatV _v ){
+		kmFloatV e = vrsqrteq_f32(_v);
+		return vmulq_f32( e, vrsqrtsq_f32( vmulq_f32(_v, e), e ) );
+	}
+#else
+	#define KM_SIMD_WIDTH 1
+	typedef float kmFloatV;
+	inline kmFloatV kmSet( float _f ){ return _f; }
+	inline kmFloatV kmLoad( const float* _p ){ return *_p; }
+	inline void kmStore( float* _p, kmFloatV _v ){ *_p = _v; }
+	inline kmFloatV kmAdd( kmFloatV _a, kmFloatV _b ){ return _a+_b; }
+	inline kmFloatV kmSub( kmFloatV _a, kmFloatV _b ){ return _a-_b; }
+	inline kmFloatV kmMul( kmFloatV _a, kmFloatV _b ){ return _a*_b; }
+	inline kmFloatV kmFloor( kmFloatV _v ){ return std::floor(_v); }
+	inline kmFloatV kmAbs( kmFloatV _v ){ return std::fabs(_v); }
+	inline kmFloatV kmRsqrt( kmFloatV _v ){ return 1.f/std::sqrt(_v); }
+#endif